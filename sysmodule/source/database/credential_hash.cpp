@@ -0,0 +1,206 @@
+#include "credential_hash.h"
+#include "logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace alefbet::authenticator::logger;
+
+constexpr const char* HashPrefix = "pbkdf2-sha256$";
+constexpr u32 CalibrationIterations = 1024;
+constexpr u32 MinIterations = 1024;
+constexpr u32 MaxIterations = 1'000'000;
+
+namespace alefbet::authenticator::database {
+
+    void pbkdf2Sha256(std::string_view password, const u8* salt, size_t saltSize, u32 iterations, u8* out, size_t outSize) {
+        // The key is only hashed once, each iteration starts from a copy of the keyed context
+        HmacSha256Context keyed;
+        hmacSha256CreateContext(&keyed, password.data(), password.size());
+
+        u8 block[SHA256_HASH_SIZE];
+        u8 result[SHA256_HASH_SIZE];
+
+        for(u32 index = 1; outSize > 0; index++) {
+            const u8 counter[4] = { static_cast<u8>(index >> 24), static_cast<u8>(index >> 16), static_cast<u8>(index >> 8), static_cast<u8>(index) };
+
+            HmacSha256Context ctx = keyed;
+            hmacSha256ContextUpdate(&ctx, salt, saltSize);
+            hmacSha256ContextUpdate(&ctx, counter, sizeof(counter));
+            hmacSha256ContextGetMac(&ctx, block);
+            std::memcpy(result, block, sizeof(result));
+
+            for(u32 i = 1; i < iterations; i++) {
+                ctx = keyed;
+                hmacSha256ContextUpdate(&ctx, block, sizeof(block));
+                hmacSha256ContextGetMac(&ctx, block);
+
+                for(size_t j = 0; j < sizeof(result); j++) {
+                    result[j] ^= block[j];
+                }
+            }
+
+            const size_t size = std::min(outSize, sizeof(result));
+            std::memcpy(out, result, size);
+            out += size;
+            outSize -= size;
+        }
+    }
+
+    bool constantTimeEqual(const void* a, const void* b, size_t size) {
+        const volatile u8* left = static_cast<const volatile u8*>(a);
+        const volatile u8* right = static_cast<const volatile u8*>(b);
+        u8 difference = 0;
+
+        for(size_t i = 0; i < size; i++) {
+            difference |= left[i] ^ right[i];
+        }
+
+        return difference == 0;
+    }
+
+    static void appendHex(std::string& out, const u8* data, size_t size) {
+        constexpr const char* digits = "0123456789abcdef";
+
+        for(size_t i = 0; i < size; i++) {
+            out += digits[data[i] >> 4];
+            out += digits[data[i] & 0xf];
+        }
+    }
+
+    static bool parseHex(std::string_view text, u8* out, size_t size) {
+        if(text.size() != size * 2) return false;
+
+        for(size_t i = 0; i < size; i++) {
+            const auto& result = std::from_chars(text.data() + i * 2, text.data() + i * 2 + 2, out[i], 16);
+            if(result.ec != std::errc() || result.ptr != text.data() + i * 2 + 2) return false;
+        }
+
+        return true;
+    }
+
+    std::string encodeCredentialHash(const CredentialHash& hash) {
+        std::string out = HashPrefix;
+
+        out += std::to_string(hash.iterations);
+        out += '$';
+        appendHex(out, hash.salt, sizeof(hash.salt));
+        out += '$';
+        appendHex(out, hash.key, sizeof(hash.key));
+
+        return out;
+    }
+
+    /* A count outside the calibration range was not written by this module, it could stall the GUI for hours */
+    static bool validIterations(u32 iterations) {
+        return iterations >= MinIterations && iterations <= MaxIterations;
+    }
+
+    bool decodeCredentialHash(std::string_view text, CredentialHash& hash) {
+        if(!text.starts_with(HashPrefix)) return false;
+        text.remove_prefix(std::strlen(HashPrefix));
+
+        const auto& iterations = std::from_chars(text.data(), text.data() + text.size(), hash.iterations);
+        if(iterations.ec != std::errc() || !validIterations(hash.iterations)) return false;
+        text.remove_prefix(iterations.ptr - text.data());
+
+        if(text.size() != 1 + sizeof(hash.salt) * 2 + 1 + sizeof(hash.key) * 2 || text[0] != '$' || text[1 + sizeof(hash.salt) * 2] != '$') return false;
+
+        return parseHex(text.substr(1, sizeof(hash.salt) * 2), hash.salt, sizeof(hash.salt))
+            && parseHex(text.substr(2 + sizeof(hash.salt) * 2), hash.key, sizeof(hash.key));
+    }
+
+    CredentialHasher::CredentialHasher() {
+        randomGet(sessionKey_, sizeof(sessionKey_));
+    }
+
+    void CredentialHasher::calibrate() {
+        const u8 salt[CredentialSaltSize] = {};
+        u8 key[CredentialKeySize];
+
+        const u64 start = armGetSystemTick();
+        pbkdf2Sha256("calibration", salt, sizeof(salt), CalibrationIterations, key, sizeof(key));
+        const u64 elapsedNs = std::max<u64>(armTicksToNs(armGetSystemTick() - start), 1);
+
+        const u64 iterations = static_cast<u64>(PIN_HASH_BUDGET_MS) * 1'000'000 * CalibrationIterations / elapsedNs;
+        iterations_ = static_cast<u32>(std::clamp<u64>(iterations, MinIterations, MaxIterations));
+
+        LOG_INFO(Database, "PIN hash calibrated: %u iterations in %lu us, %u iterations for %u ms\n",
+            CalibrationIterations, elapsedNs / 1000, iterations_, PIN_HASH_BUDGET_MS);
+    }
+
+    u32 CredentialHasher::iterations() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(iterations_ == 0) calibrate();
+
+        return iterations_;
+    }
+
+    CredentialHasher::SessionTag CredentialHasher::sessionTag(const CredentialHash& hash, std::string_view pin) const {
+        SessionTag tag;
+
+        HmacSha256Context ctx;
+        hmacSha256CreateContext(&ctx, sessionKey_, sizeof(sessionKey_));
+        hmacSha256ContextUpdate(&ctx, hash.key, sizeof(hash.key));
+        hmacSha256ContextUpdate(&ctx, pin.data(), pin.size());
+        hmacSha256ContextGetMac(&ctx, tag.data());
+
+        return tag;
+    }
+
+    Credential CredentialHasher::protect(AccountUid uid, std::string_view pin) {
+        CredentialHash hash;
+        hash.iterations = iterations();
+        randomGet(hash.salt, sizeof(hash.salt));
+        pbkdf2Sha256(pin, hash.salt, sizeof(hash.salt), hash.iterations, hash.key, sizeof(hash.key));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        verified_[uid] = sessionTag(hash, pin);
+
+        return Credential::fromHash(hash);
+    }
+
+    bool CredentialHasher::verify(AccountUid uid, const Credential& stored, std::string_view pin) {
+        if(stored.kind == Credential::Plain) {
+            const auto& password = stored.password();
+            return password.size() == pin.size() && constantTimeEqual(password.data(), pin.data(), pin.size());
+        }
+
+        if(stored.kind != Credential::Hashed) return false;
+
+        const auto& hash = stored.hash();
+        if(!validIterations(hash.iterations)) {
+            LOG_ERROR(Database, "Refusing a PIN hash with %u iterations\n", hash.iterations);
+            return false;
+        }
+
+        const auto& tag = sessionTag(hash, pin);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto& it = verified_.find(uid);
+            if(it != verified_.end() && constantTimeEqual(it->second.data(), tag.data(), tag.size())) {
+                return true;
+            }
+        }
+
+        u8 key[CredentialKeySize];
+        const u64 start = armGetSystemTick();
+        pbkdf2Sha256(pin, hash.salt, sizeof(hash.salt), hash.iterations, key, sizeof(key));
+        LOG_DEBUG(Database, "PIN derivation took %lu us\n", armTicksToNs(armGetSystemTick() - start) / 1000);
+
+        if(!constantTimeEqual(key, hash.key, sizeof(key))) return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        verified_[uid] = tag;
+
+        return true;
+    }
+
+    void CredentialHasher::forget(AccountUid uid) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        verified_.erase(uid);
+    }
+
+}
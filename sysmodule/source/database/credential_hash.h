@@ -0,0 +1,69 @@
+#pragma once
+#include <switch.h>
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "database_types.h"
+
+/* Time spent on a single PIN derivation, can be overridden per deployment (make DEFINES="-DPIN_HASH_BUDGET_MS=...") */
+#ifndef PIN_HASH_BUDGET_MS
+#define PIN_HASH_BUDGET_MS 50
+#endif
+
+namespace alefbet::authenticator::database {
+
+    /*! \brief Derives \p outSize bytes from \p password with PBKDF2-HMAC-SHA256. */
+    void pbkdf2Sha256(std::string_view password, const u8* salt, size_t saltSize, u32 iterations, u8* out, size_t outSize);
+
+    /*! \brief Compares two buffers in a time that does not depend on their content. */
+    bool constantTimeEqual(const void* a, const void* b, size_t size);
+
+    /*! \brief Textual form of a hash, as stored in the JSON export ("pbkdf2-sha256$<iterations>$<salt>$<key>"). */
+    std::string encodeCredentialHash(const CredentialHash& hash);
+    bool decodeCredentialHash(std::string_view text, CredentialHash& hash);
+
+    /*! \brief Hashes and verifies PINs.
+
+        The iteration count is calibrated once per boot, on first use, so that a derivation takes
+        about PIN_HASH_BUDGET_MS on this console. It is stored with each hash so that older hashes
+        still verify after a recalibration.
+        Once a PIN has been verified, a MAC of it under a random per-boot key is kept in memory so
+        that later verifications of the same user only cost one HMAC instead of a full derivation.
+    */
+    class CredentialHasher {
+        public:
+            static CredentialHasher& get() {
+                static CredentialHasher hasher;
+
+                return hasher;
+            }
+
+            /*! \brief Derives a new salted hash of \p pin. */
+            Credential protect(AccountUid uid, std::string_view pin);
+
+            /*! \brief Checks \p pin against \p stored (hashed or plain). */
+            bool verify(AccountUid uid, const Credential& stored, std::string_view pin);
+
+            /*! \brief Drops the cached verification of \p uid. */
+            void forget(AccountUid uid);
+
+            u32 iterations();
+
+        private:
+            CredentialHasher();
+
+            typedef std::array<u8, CredentialKeySize> SessionTag;
+
+            SessionTag sessionTag(const CredentialHash& hash, std::string_view pin) const;
+            void calibrate();
+
+        private:
+            std::mutex mutex_;
+            u32 iterations_ = 0;
+            u8 sessionKey_[CredentialKeySize];
+            std::unordered_map<AccountUid, SessionTag, helpers::AccountUidHash, helpers::AccountUidEqual> verified_;
+    };
+
+}
@@ -0,0 +1,72 @@
+#include "credential_index.h"
+
+using namespace alefbet::authenticator::helpers;
+
+constexpr size_t InitialCapacity = 16;
+
+namespace alefbet::authenticator::database {
+
+    static size_t hashOf(AccountUid uid, size_t capacity) {
+        return AccountUidHash{}(uid) & (capacity - 1);
+    }
+
+    const Credential* CredentialIndex::find(AccountUid uid) const {
+        const size_t capacity = records_.size();
+        if(capacity == 0 || !accountUidIsValid(&uid)) return nullptr;
+
+        // The load factor keeps a free slot, which ends the probing
+        for(size_t i = hashOf(uid, capacity);; i = (i + 1) & (capacity - 1)) {
+            const auto& record = records_[i];
+
+            if(!accountUidIsValid(&record.uid)) return nullptr;
+            if(AccountUidEqual{}(record.uid, uid)) return &record.credential;
+        }
+    }
+
+    CredentialRecord* CredentialIndex::slot(AccountUid uid) {
+        const size_t capacity = records_.size();
+
+        for(size_t i = hashOf(uid, capacity);; i = (i + 1) & (capacity - 1)) {
+            auto& record = records_[i];
+
+            if(!accountUidIsValid(&record.uid) || AccountUidEqual{}(record.uid, uid)) {
+                return &record;
+            }
+        }
+    }
+
+    void CredentialIndex::grow() {
+        std::vector<CredentialRecord> previous(records_.empty() ? InitialCapacity : records_.size() * 2);
+        previous.swap(records_);
+        size_ = 0;
+
+        for(const auto& record: previous) {
+            if(accountUidIsValid(&record.uid)) {
+                insert(record.uid, record.credential);
+            }
+        }
+    }
+
+    void CredentialIndex::insert(AccountUid uid, const Credential& credential) {
+        if(!accountUidIsValid(&uid)) return;
+
+        // Keep the load factor under 75% so that probes stay short
+        if((size_ + 1) * 4 > records_.size() * 3) {
+            grow();
+        }
+
+        auto* record = slot(uid);
+        if(!accountUidIsValid(&record->uid)) {
+            record->uid = uid;
+            size_++;
+        }
+
+        record->credential = credential;
+    }
+
+    void CredentialIndex::clear() {
+        records_.clear();
+        size_ = 0;
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <switch.h>
+#include "database_types.h"
+
+namespace alefbet::authenticator::database {
+
+    /*! \brief Open-addressed table of credential records keyed by AccountUid.
+
+        Records have a fixed size and the table is a single contiguous array whose capacity is a
+        power of two; a free slot has a null uid. Lookups hash the uid and probe linearly, without
+        any allocation.
+    */
+    class CredentialIndex {
+        public:
+            /*! \brief Returns the credential of \p uid, or nullptr if none has been set. */
+            const Credential* find(AccountUid uid) const;
+
+            bool contains(AccountUid uid) const {
+                return find(uid) != nullptr;
+            }
+
+            /*! \brief Inserts or replaces the credential of \p uid. */
+            void insert(AccountUid uid, const Credential& credential);
+
+            void clear();
+
+            size_t size() const {
+                return size_;
+            }
+
+            /*! \brief Calls \p func for each record in slot order. */
+            template<typename F>
+            void forEach(F&& func) const {
+                for(const auto& record: records_) {
+                    if(accountUidIsValid(&record.uid)) {
+                        func(record.uid, record.credential);
+                    }
+                }
+            }
+
+        private:
+            void grow();
+            CredentialRecord* slot(AccountUid uid);
+
+        private:
+            std::vector<CredentialRecord> records_;
+            size_t size_ = 0;
+    };
+
+}
@@ -0,0 +1,260 @@
+#include "credential_log.h"
+#include "database.h"
+#include "logger.h"
+#include "sd_card.h"
+#include <cstring>
+
+using namespace alefbet::authenticator::logger;
+using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::services;
+
+constexpr u32 LogMagic = 0x474C4141; // "AALG"
+constexpr u32 LogVersion = 2;
+constexpr u32 CompactionMinDeadRecords = 16;
+
+namespace alefbet::authenticator::database {
+
+    /* File layout: LogHeader, then fixed-size LogEntry records */
+    struct LogHeader {
+        u32 magic;
+        u32 version;            ///< Layout of the file, the credentials carry their own schema
+    };
+
+    struct LogEntry {
+        u32 crc;                ///< CRC32 of everything following this field
+        u32 reserved;
+        u64 timestamp;
+        CredentialRecord record;
+    };
+    static_assert(sizeof(LogEntry) == 96);
+
+    static u32 entryCrc(const LogEntry& entry) {
+        return crc32Calculate(reinterpret_cast<const u8*>(&entry) + sizeof(entry.crc), sizeof(entry) - sizeof(entry.crc));
+    }
+
+    /* A compacted log, as written by rewrite(): every record is valid */
+    static bool validLog(const std::vector<u8>& data) {
+        if(data.size() < sizeof(LogHeader) || (data.size() - sizeof(LogHeader)) % sizeof(LogEntry) != 0) return false;
+
+        LogHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if(header.magic != LogMagic || header.version != LogVersion) return false;
+
+        for(size_t offset = sizeof(header); offset < data.size(); offset += sizeof(LogEntry)) {
+            LogEntry entry;
+            std::memcpy(&entry, &data[offset], sizeof(entry));
+            if(entryCrc(entry) != entry.crc) return false;
+        }
+
+        return true;
+    }
+
+    void CredentialLog::appendRecord(std::vector<u8>& data, AccountUid uid, const Credential& credential, u64 timestamp) {
+        LogEntry entry = {};
+        entry.timestamp = timestamp;
+        entry.record.uid = uid;
+        entry.record.credential = credential;
+        entry.crc = entryCrc(entry);
+
+        const auto* bytes = reinterpret_cast<const u8*>(&entry);
+        data.insert(data.end(), bytes, bytes + sizeof(entry));
+    }
+
+    bool CredentialLog::exists() {
+        return prepare() && SdCard::get().exists(path_);
+    }
+
+    bool CredentialLog::writable() const {
+        if(!replayed_) {
+            LOG_ERROR(Database, "The credential log could not be loaded, refusing to write it\n");
+        }
+        return replayed_;
+    }
+
+    bool CredentialLog::create() {
+        if(!writable()) return false;
+
+        const LogHeader header = { LogMagic, LogVersion };
+
+        createDataDirectory();
+        if(!commitFile(path_, &header, sizeof(header))) {
+            LOG_ERROR(Database, "Could not create the credential log\n");
+            return false;
+        }
+
+        size_ = sizeof(header);
+        stats_.bytesWritten += sizeof(header);
+
+        return true;
+    }
+
+    bool CredentialLog::replay(CredentialIndex& passwords) {
+        if(!prepare()) return false;
+
+        // A compaction may have been interrupted
+        recoverFile(path_, validLog);
+
+        auto& sdcard = SdCard::get();
+        if(!sdcard.exists(path_)) {
+            // Nothing can be lost by creating it
+            replayed_ = true;
+            return false;
+        }
+
+        // Until a replay succeeds the log is kept as it is, another try may read it
+        replayed_ = false;
+
+        std::vector<u8> data;
+        if(R_FAILED(sdcard.readFile(path_, data))) {
+            LOG_ERROR(Database, "Could not read the credential log\n");
+            return false;
+        }
+
+        LogHeader logHeader = {};
+        if(data.size() >= sizeof(logHeader)) {
+            std::memcpy(&logHeader, data.data(), sizeof(logHeader));
+        }
+
+        // A log written by a newer build is never rewritten by this one
+        if(logHeader.magic != LogMagic || logHeader.version != LogVersion) {
+            LOG_ERROR(Database, "The credential log is invalid (version %u), it is left untouched\n", logHeader.version);
+            return false;
+        }
+
+        passwords.clear();
+        stats_.recoveredRecords = 0;
+        stats_.corruptRecords = 0;
+        stats_.discardedBytes = 0;
+
+        // Records have a fixed size, a corrupted one does not hide the records following it.
+        // Only the last one can have been torn by an interrupted append.
+        const size_t records = (data.size() - sizeof(logHeader)) / sizeof(LogEntry);
+        size_t offset = sizeof(logHeader);
+        for(size_t i = 0; i < records; i++) {
+            LogEntry entry;
+            std::memcpy(&entry, &data[offset], sizeof(entry));
+
+            if(entryCrc(entry) == entry.crc) {
+                passwords.insert(entry.record.uid, entry.record.credential);
+                stats_.recoveredRecords++;
+            } else if(i + 1 < records) {
+                // The record may have replaced an older PIN of its user, which must not be accepted again
+                stats_.corruptRecords++;
+                if(accountUidIsValid(&entry.record.uid)) {
+                    LOG_ERROR(Database, "Corrupted record of %s, the account is locked\n", accountUidToString(entry.record.uid).c_str());
+                    passwords.insert(entry.record.uid, Credential::locked());
+                } else {
+                    LOG_ERROR(Database, "Corrupted record at offset %lu, its account is unknown\n", offset);
+                }
+            } else {
+                break;
+            }
+
+            offset += sizeof(entry);
+        }
+
+        // Drop the torn record left by an interrupted append
+        if(offset < data.size()) {
+            stats_.discardedBytes = data.size() - offset;
+            LOG_WARN(Database, "Discarding %lu bytes after the last record\n", stats_.discardedBytes);
+            sdcard.setSize(path_, offset);
+        }
+
+        size_ = offset;
+        replayed_ = true;
+        stats_.liveRecords = passwords.size();
+        stats_.deadRecords = stats_.recoveredRecords + stats_.corruptRecords - stats_.liveRecords;
+
+        LOG_INFO(Database, "Credential log replayed: %u records, %u live\n", stats_.recoveredRecords, stats_.liveRecords);
+
+        return true;
+    }
+
+    bool CredentialLog::append(AccountUid uid, const Credential& credential, bool replacesRecord) {
+        if(!prepare() || !writable()) return false;
+        if(size_ == 0 && !create()) return false;
+
+        const u64 start = armGetSystemTick();
+
+        std::vector<u8> data;
+        appendRecord(data, uid, credential, currentTimestamp());
+
+        // The handle is kept open by the SD card cache between appends
+        auto& sdcard = SdCard::get();
+        const auto& before = sdcard.stats(path_);
+        ::Result rc = sdcard.write(path_, size_, data.data(), data.size(), FsWriteOption_Flush);
+        const auto& after = sdcard.stats(path_);
+
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Database, "Could not append to the credential log: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            return false;
+        }
+
+        size_ += data.size();
+        stats_.appends++;
+        stats_.bytesWritten += data.size();
+        stats_.lastAppendNs = armTicksToNs(armGetSystemTick() - start);
+        stats_.lastAppendOps = (after.opens - before.opens) + (after.writes - before.writes);
+        if(replacesRecord) {
+            stats_.deadRecords++;
+        } else {
+            stats_.liveRecords++;
+        }
+
+        LOG_DEBUG(Database, "Appended %lu bytes to the credential log in %lu us\n", data.size(), stats_.lastAppendNs / 1000);
+
+        return true;
+    }
+
+    bool CredentialLog::rewrite(const CredentialIndex& passwords) {
+        if(!prepare() || !writable()) return false;
+
+        const u64 timestamp = currentTimestamp();
+
+        std::vector<u8> data(sizeof(LogHeader));
+        const LogHeader header = { LogMagic, LogVersion };
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        passwords.forEach([&](AccountUid uid, const Credential& credential) {
+            appendRecord(data, uid, credential, timestamp);
+        });
+
+        createDataDirectory();
+        if(!commitFile(path_, data.data(), data.size())) {
+            LOG_ERROR(Database, "Could not write the compacted log\n");
+            return false;
+        }
+
+        size_ = data.size();
+        stats_.bytesWritten += data.size();
+        stats_.liveRecords = passwords.size();
+        stats_.deadRecords = 0;
+        stats_.compactions++;
+
+        return true;
+    }
+
+    bool CredentialLog::needsCompaction() const {
+        return stats_.deadRecords >= CompactionMinDeadRecords && stats_.deadRecords > stats_.liveRecords;
+    }
+
+    StorageStamp CredentialLog::stamp() {
+        StorageStamp stamp;
+
+        if(!prepare()) return stamp;
+
+        auto& sdcard = SdCard::get();
+
+        FsTimeStampRaw timestamp;
+        if(R_SUCCEEDED(sdcard.getTimeStamp(path_, &timestamp)) && timestamp.is_valid) {
+            stamp.modified = timestamp.modified;
+        }
+
+        if(R_FAILED(sdcard.getSize(path_, &stamp.size))) {
+            stamp.size = -1;
+        }
+
+        return stamp;
+    }
+
+}
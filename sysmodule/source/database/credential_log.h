@@ -0,0 +1,61 @@
+#pragma once
+#include <switch.h>
+#include <vector>
+#include "credential_index.h"
+
+namespace alefbet::authenticator::database {
+
+    /*! \brief Append-only storage of the credentials.
+
+        Each update appends a single fixed-size record (uid, credential, timestamp) protected by a CRC.
+        At startup the log is replayed and a torn last record (write interrupted by a power loss)
+        is cut. A corrupted record followed by valid ones is skipped and locks the account it names,
+        whose previous records may hold a PIN it replaced. When superseded records outnumber the live ones the
+        log is compacted into a fresh file holding a single record per user.
+
+        Nothing is written until the log has been replayed or found missing: a log which could
+        not be read is left untouched rather than replaced by one missing the other users.
+    */
+    class CredentialLog {
+        public:
+            CredentialLog(const char* path)
+            : path_(path) {}
+
+            bool exists();
+
+            /*! \brief Replays the log into \p passwords. Returns false if the log could not be read. */
+            bool replay(CredentialIndex& passwords);
+
+            /*! \brief Appends a record. \p replacesRecord tells whether the user already had one. */
+            bool append(AccountUid uid, const Credential& credential, bool replacesRecord);
+
+            /*! \brief Replaces the whole log with one record per entry of \p passwords. */
+            bool rewrite(const CredentialIndex& passwords);
+
+            bool needsCompaction() const;
+
+            /*! \brief Size and modification time of the log file. */
+            StorageStamp stamp();
+
+            /*! \brief Stamp once a record of \p uid has been appended, the whole log is as cheap to query. */
+            StorageStamp stamp(AccountUid) {
+                return stamp();
+            }
+
+            const CredentialStorageStats& stats() const {
+                return stats_;
+            }
+
+        private:
+            bool create();
+            bool writable() const;
+            static void appendRecord(std::vector<u8>& data, AccountUid uid, const Credential& credential, u64 timestamp);
+
+        private:
+            const char* path_;
+            s64 size_ = 0;
+            bool replayed_ = false;     ///< The log was replayed or is missing, writing cannot lose records
+            CredentialStorageStats stats_;
+    };
+
+}
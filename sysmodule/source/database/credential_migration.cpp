@@ -0,0 +1,46 @@
+#include <array>
+#include "credential_migration.h"
+#include "logger.h"
+
+using namespace alefbet::authenticator::logger;
+
+namespace alefbet::authenticator::database {
+
+    /* The first schema, which every credential of this module has or upgrades from */
+    constexpr u8 BaseSchema = 1;
+
+    /* Steps[n] upgrades a credential from schema BaseSchema + n to BaseSchema + n + 1 */
+    constexpr std::array<MigrationStep, CredentialSchemaVersion - BaseSchema> Steps = {};
+
+    static const MigrationStep* g_steps = Steps.data();
+    static size_t g_stepCount = Steps.size();
+
+    MigrationResult migrateCredential(Credential& credential) {
+        if(credential.schema == CredentialSchemaVersion) return MigrationNone;
+
+        if(credential.schema < BaseSchema || credential.schema > CredentialSchemaVersion) {
+            LOG_ERROR(Database, "Unknown credential schema %u\n", credential.schema);
+            return MigrationFailed;
+        }
+
+        // Upgraded on a copy, a step which fails leaves the credential as stored
+        Credential upgraded = credential;
+        while(upgraded.schema < CredentialSchemaVersion) {
+            const size_t step = upgraded.schema - BaseSchema;
+            if(step >= g_stepCount || g_steps[step] == nullptr || !g_steps[step](upgraded)) {
+                LOG_ERROR(Database, "Could not migrate a credential from schema %u\n", upgraded.schema);
+                return MigrationFailed;
+            }
+            upgraded.schema++;
+        }
+
+        credential = upgraded;
+        return MigrationApplied;
+    }
+
+    void setMigrationSteps(const MigrationStep* steps, size_t count) {
+        g_steps = steps;
+        g_stepCount = count;
+    }
+
+}
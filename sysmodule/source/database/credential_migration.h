@@ -0,0 +1,28 @@
+#pragma once
+#include <switch.h>
+#include "database_types.h"
+
+namespace alefbet::authenticator::database {
+
+    typedef enum {
+        MigrationNone,      ///< The credential already has the current schema
+        MigrationApplied,   ///< The credential has been upgraded and must be written back
+        MigrationFailed     ///< The credential has an unknown schema or a step failed
+    } MigrationResult;
+
+    /*! \brief Converts a credential from its schema to the next one, returns false if it cannot. */
+    typedef bool (*MigrationStep)(Credential& credential);
+
+    /*! \brief Upgrades a credential to CredentialSchemaVersion.
+
+        Each schema change registers a step converting a credential from the previous schema in
+        credential_migration.cpp. Steps are not run when the storage is loaded: the credential
+        store applies them to a single record when it is next read or written, so startup does
+        not depend on the number of stale records.
+    */
+    MigrationResult migrateCredential(Credential& credential);
+
+    /*! \brief Replaces the registered steps, for the tests: \p steps[n] upgrades schema n + 1 to n + 2. */
+    void setMigrationSteps(const MigrationStep* steps, size_t count);
+
+}
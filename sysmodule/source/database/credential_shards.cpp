@@ -0,0 +1,298 @@
+#include "credential_shards.h"
+#include "database.h"
+#include "logger.h"
+#include "sd_card.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace alefbet::authenticator::logger;
+using namespace alefbet::authenticator::services;
+
+constexpr u32 ShardMagic = 0x48534141; // "AASH"
+constexpr u32 ShardVersion = 1;
+constexpr const char* ShardExtension = ".bin";
+constexpr const char* PendingExtension = ".bin.tmp";
+
+namespace alefbet::authenticator::database {
+
+    /* File layout: a single ShardFile */
+    struct ShardFile {
+        u32 magic;
+        u32 version;
+        u32 crc;                ///< CRC32 of everything following this field
+        u32 reserved;
+        u64 timestamp;
+        CredentialRecord record;
+    };
+    static_assert(sizeof(ShardFile) == 104);
+
+    static u32 shardCrc(const ShardFile& shard) {
+        constexpr size_t offset = offsetof(ShardFile, reserved);
+        return crc32Calculate(reinterpret_cast<const u8*>(&shard) + offset, sizeof(shard) - offset);
+    }
+
+    static bool validShard(const std::vector<u8>& data) {
+        if(data.size() != sizeof(ShardFile)) return false;
+
+        ShardFile shard;
+        std::memcpy(&shard, data.data(), sizeof(shard));
+        return shard.magic == ShardMagic && shard.version == ShardVersion && shardCrc(shard) == shard.crc;
+    }
+
+    static bool endsWith(const char* name, const char* suffix) {
+        const size_t nameLength = std::strlen(name);
+        const size_t suffixLength = std::strlen(suffix);
+        return nameLength >= suffixLength && std::strcmp(name + nameLength - suffixLength, suffix) == 0;
+    }
+
+    /* The uid of a shard from its name, "<016lX><016lX>.bin" */
+    static bool shardUid(const std::string& path, AccountUid& uid) {
+        const size_t start = path.rfind('/') + 1;
+        if(path.size() - start != 32 + std::strlen(ShardExtension)) return false;
+
+        for(size_t half = 0; half < 2; half++) {
+            u64 value = 0;
+            for(size_t i = start + half * 16; i < start + (half + 1) * 16; i++) {
+                const char c = path[i];
+                if(c >= '0' && c <= '9') value = value << 4 | (c - '0');
+                else if(c >= 'A' && c <= 'F') value = value << 4 | (c - 'A' + 10);
+                else return false;
+            }
+            uid.uid[half] = value;
+        }
+
+        return accountUidIsValid(&uid);
+    }
+
+    static u32 shardDigest(const char* name, u64 modified) {
+        const u32 digest = crc32Calculate(name, std::strlen(name));
+        return crc32CalculateWithSeed(digest, &modified, sizeof(modified));
+    }
+
+    std::string CredentialShards::shardName(AccountUid uid) {
+        char name[40];
+        std::snprintf(name, sizeof(name), "%016lX%016lX%s", uid.uid[0], uid.uid[1], ShardExtension);
+        return name;
+    }
+
+    std::string CredentialShards::shardPath(AccountUid uid) const {
+        return std::string(dir_) + "/" + shardName(uid);
+    }
+
+    bool CredentialShards::exists() {
+        return prepare() && SdCard::get().exists(dir_);
+    }
+
+    bool CredentialShards::createDirectory() {
+        if(exists()) return true;
+
+        createDataDirectory();
+        return R_SUCCEEDED(SdCard::get().createDirectory(dir_));
+    }
+
+    bool CredentialShards::read(const std::string& path, CredentialRecord& record) {
+        // Shards are read once at load, they do not take cache entries
+        std::vector<u8> data;
+        if(R_FAILED(SdCard::get().readFile(path.c_str(), data)) || !validShard(data)) {
+            return false;
+        }
+
+        ShardFile shard;
+        std::memcpy(&shard, data.data(), sizeof(shard));
+        record = shard.record;
+        return true;
+    }
+
+    bool CredentialShards::replay(CredentialIndex& passwords) {
+        if(!prepare() || !exists()) return false;
+
+        FsDir dir;
+        if(R_FAILED(SdCard::get().openDirectory(dir_, FsDirOpenMode_ReadFiles | FsDirOpenMode_NoFileSize, &dir))) {
+            LOG_ERROR(Database, "Could not open %s\n", dir_);
+            return false;
+        }
+
+        // Collect the names first, shards cannot be renamed while the directory is being read
+        std::vector<std::string> shards;
+        std::vector<std::string> pending;
+        FsDirectoryEntry entries[16];
+        s64 count = 0;
+        while(R_SUCCEEDED(fsDirRead(&dir, &count, sizeof(entries) / sizeof(entries[0]), entries)) && count > 0) {
+            for(s64 i = 0; i < count; i++) {
+                const char* name = entries[i].name;
+
+                if(endsWith(name, PendingExtension)) {
+                    // Path of the shard being replaced
+                    const size_t length = std::strlen(name) - std::strlen(PendingExtension) + std::strlen(ShardExtension);
+                    pending.emplace_back(std::string(dir_) + "/" + std::string(name, length));
+                } else if(endsWith(name, ShardExtension)) {
+                    shards.emplace_back(std::string(dir_) + "/" + name);
+                }
+            }
+        }
+        fsDirClose(&dir);
+
+        // A crash may have interrupted the replacement of a shard
+        for(const auto& path: pending) {
+            const bool complete = std::find(shards.begin(), shards.end(), path) == shards.end();
+            recoverFile(path.c_str(), validShard);
+            if(complete) shards.push_back(path);
+        }
+
+        passwords.clear();
+        stats_.recoveredRecords = 0;
+        stats_.corruptRecords = 0;
+        stats_.discardedBytes = 0;
+
+        for(const auto& path: shards) {
+            CredentialRecord record;
+            if(!read(path, record)) {
+                // Without a credential the account would be offered to set a new PIN, none matches a locked one
+                AccountUid uid = {};
+                if(shardUid(path, uid)) {
+                    LOG_ERROR(Database, "Invalid shard %s, the account is locked\n", path.c_str());
+                    passwords.insert(uid, Credential::locked());
+                    stats_.corruptRecords++;
+                } else {
+                    LOG_WARN(Database, "Ignoring invalid shard %s\n", path.c_str());
+                }
+                stats_.discardedBytes += sizeof(ShardFile);
+                continue;
+            }
+
+            passwords.insert(record.uid, record.credential);
+            stats_.recoveredRecords++;
+        }
+
+        stats_.liveRecords = passwords.size();
+        stats_.deadRecords = 0;
+
+        LOG_INFO(Database, "Credential shards loaded: %u records\n", stats_.recoveredRecords);
+
+        return true;
+    }
+
+    bool CredentialShards::write(AccountUid uid, const Credential& credential, u64 timestamp) {
+        ShardFile shard = {};
+        shard.magic = ShardMagic;
+        shard.version = ShardVersion;
+        shard.timestamp = timestamp;
+        shard.record.uid = uid;
+        shard.record.credential = credential;
+        shard.crc = shardCrc(shard);
+
+        const auto& path = shardPath(uid);
+        if(!commitFile(path.c_str(), &shard, sizeof(shard))) {
+            LOG_ERROR(Database, "Could not write the shard %s\n", path.c_str());
+            return false;
+        }
+
+        stats_.bytesWritten += sizeof(shard);
+        return true;
+    }
+
+    bool CredentialShards::append(AccountUid uid, const Credential& credential, bool replacesRecord) {
+        if(!prepare() || !createDirectory()) return false;
+
+        const u64 start = armGetSystemTick();
+
+        if(!write(uid, credential, currentTimestamp())) return false;
+
+        stats_.appends++;
+        stats_.lastAppendNs = armTicksToNs(armGetSystemTick() - start);
+        stats_.lastAppendOps = commitStats().lastMetadataOps + 1;
+        if(!replacesRecord) {
+            stats_.liveRecords++;
+        }
+
+        LOG_DEBUG(Database, "Replaced the shard of %016lX%016lX in %lu us, %u SD operations\n", uid.uid[0], uid.uid[1], stats_.lastAppendNs / 1000, stats_.lastAppendOps);
+
+        return true;
+    }
+
+    bool CredentialShards::rewrite(const CredentialIndex& passwords) {
+        if(!prepare() || !createDirectory()) return false;
+
+        const u64 timestamp = currentTimestamp();
+        bool written = true;
+
+        passwords.forEach([&](AccountUid uid, const Credential& credential) {
+            written = write(uid, credential, timestamp) && written;
+        });
+
+        stats_.liveRecords = passwords.size();
+
+        return written;
+    }
+
+    StorageStamp CredentialShards::stamp() {
+        shardStamps_.clear();
+        stamp_ = StorageStamp();
+
+        if(!prepare()) return stamp_;
+
+        auto& sdcard = SdCard::get();
+        FsDir dir;
+        if(R_FAILED(sdcard.openDirectory(dir_, FsDirOpenMode_ReadFiles, &dir))) return stamp_;
+
+        // Shards have a fixed size, a replaced one is only told apart by its modification time
+        bool complete = true;
+        FsDirectoryEntry entries[16];
+        s64 count = 0;
+        while(R_SUCCEEDED(fsDirRead(&dir, &count, sizeof(entries) / sizeof(entries[0]), entries)) && count > 0) {
+            for(s64 i = 0; i < count; i++) {
+                const auto& entry = entries[i];
+                const auto& path = std::string(dir_) + "/" + entry.name;
+
+                FsTimeStampRaw timestamp;
+                if(R_FAILED(sdcard.getTimeStamp(path.c_str(), &timestamp)) || !timestamp.is_valid) {
+                    complete = false;
+                    continue;
+                }
+
+                shardStamps_[entry.name] = ShardStamp { entry.file_size, shardDigest(entry.name, timestamp.modified) };
+            }
+        }
+        fsDirClose(&dir);
+
+        // A partial stamp would hide the shards which could not be queried, it is left unknown
+        if(!complete) {
+            shardStamps_.clear();
+            return stamp_;
+        }
+
+        // Combined in a way which does not depend on the order of the entries, so that a single shard can be replaced
+        stamp_.size = 0;
+        for(const auto& [name, shard]: shardStamps_) {
+            stamp_.size += shard.size;
+            stamp_.modified ^= shard.digest;
+        }
+
+        return stamp_;
+    }
+
+    StorageStamp CredentialShards::stamp(AccountUid uid) {
+        // Nothing to update without a complete stamp
+        if(stamp_.size < 0) return stamp();
+
+        const auto& name = shardName(uid);
+        const auto& path = shardPath(uid);
+
+        FsTimeStampRaw timestamp;
+        if(R_FAILED(SdCard::get().getTimeStamp(path.c_str(), &timestamp)) || !timestamp.is_valid) return stamp();
+
+        auto& shard = shardStamps_[name];
+        stamp_.size -= shard.size;
+        stamp_.modified ^= shard.digest;
+
+        shard = ShardStamp { sizeof(ShardFile), shardDigest(name.c_str(), timestamp.modified) };
+        stamp_.size += shard.size;
+        stamp_.modified ^= shard.digest;
+
+        return stamp_;
+    }
+
+}
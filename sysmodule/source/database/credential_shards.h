@@ -0,0 +1,67 @@
+#pragma once
+#include <switch.h>
+#include <string>
+#include <unordered_map>
+#include "credential_index.h"
+
+namespace alefbet::authenticator::database {
+
+    /*! \brief One small file per user holding its credential.
+
+        Each user has a fixed-size file "<dir>/<uid>.bin" (a single record protected by a CRC) that is
+        replaced atomically on update, so a PIN change only writes that user's file whatever the
+        number of users. At startup the directory is scanned to rebuild the index, a shard which
+        cannot be read locks the account named by its file.
+        It has the same interface as CredentialLog and never needs a compaction.
+    */
+    class CredentialShards {
+        public:
+            CredentialShards(const char* dir)
+            : dir_(dir) {}
+
+            bool exists();
+
+            /*! \brief Loads every shard into \p passwords. Returns false if the directory could not be read. */
+            bool replay(CredentialIndex& passwords);
+
+            /*! \brief Replaces the shard of \p uid. */
+            bool append(AccountUid uid, const Credential& credential, bool replacesRecord);
+
+            /*! \brief Writes one shard per entry of \p passwords. */
+            bool rewrite(const CredentialIndex& passwords);
+
+            bool needsCompaction() const {
+                return false;
+            }
+
+            /*! \brief Size, names and modification times of the shards, so that any change to the directory changes it. */
+            StorageStamp stamp();
+
+            /*! \brief Stamp once the shard of \p uid has been written: only that shard is queried, the others keep
+                the times of the last stamp(). */
+            StorageStamp stamp(AccountUid uid);
+
+            const CredentialStorageStats& stats() const {
+                return stats_;
+            }
+
+        private:
+            struct ShardStamp {
+                s64 size = 0;
+                u32 digest = 0;         ///< CRC32 of the name and of the modification time
+            };
+
+            static std::string shardName(AccountUid uid);
+            std::string shardPath(AccountUid uid) const;
+            bool createDirectory();
+            bool write(AccountUid uid, const Credential& credential, u64 timestamp);
+            bool read(const std::string& path, CredentialRecord& record);
+
+        private:
+            const char* dir_;
+            CredentialStorageStats stats_;
+            std::unordered_map<std::string, ShardStamp> shardStamps_;
+            StorageStamp stamp_;        ///< Sum of the sizes and XOR of the digests of shardStamps_
+    };
+
+}
@@ -8,176 +8,422 @@
 #include <filesystem>
 #include <mutex>
 #include "database.h"
-#include "json.hpp"
+#include "password_json.h"
 #include "logger.h"
+#include "utils.h"
+#include "service_manager.h"
+#include "sd_card.h"
 
-using json = nlohmann::json;
 using namespace alefbet::authenticator::logger;
 using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::services;
 
 static const char* DATA_DIR = "/config/authenticator";
 static const char* DB_FILENAME = "/config/authenticator/passwords.json";
+static const char* DB_IMPORTED_FILENAME = "/config/authenticator/passwords.json.imported";
+static const char* DB_EXPORT_FILENAME = "/config/authenticator/passwords.export.json";
+static const char* LOG_FILENAME = "/config/authenticator/passwords.log";
+#ifdef CREDENTIAL_SHARDS
+static const char* LOG_IMPORTED_FILENAME = "/config/authenticator/passwords.log.imported";
+static const char* SHARDS_DIR = "/config/authenticator/users";
+#endif
 
 namespace alefbet::authenticator::database {
-    static FsFileSystem sdmc;
-    static FsFile handle_database;
     static std::mutex mutex_database;
-    static bool ready = false;
+    static std::mutex mutex_commit;
+    static CommitStats commit_stats;
 
     bool prepare() {
-        if(ready) return true;
+        if(SdCard::get().ready()) return true;
 
-        ready = R_SUCCEEDED(fsOpenSdCardFileSystem(&sdmc));
-        if(!ready) {
-            logToFile("[Database] Could not get access to SD card\n");
-        }
-
-        return ready;
+        LOG_ERROR(Database, "Could not get access to SD card\n");
+        return false;
     }
 
     bool createDataDirectory() 
     {
         if(!prepare()) return false;
 
-        bool result = R_SUCCEEDED(fsFsCreateDirectory(&sdmc, DATA_DIR));
+        // Verify whether data directory exists
+        if(SdCard::get().exists(DATA_DIR)) {
+            return true;
+        }
+
+        bool result = R_SUCCEEDED(SdCard::get().createDirectory(DATA_DIR));
 
         return result;
     }
 
-    Passwords loadPasswords() 
+    static std::string temporaryPath(const char* path) {
+        return std::string(path) + ".tmp";
+    }
+
+    bool commitFile(const char* path, const void* data, size_t size)
     {
-        std::lock_guard<std::mutex> lock(mutex_database);
+        if(!prepare()) return false;
 
-        logToFile("[Database] Loading database at %s\n", DB_FILENAME);
+        std::lock_guard<std::mutex> lock(mutex_commit);
 
-        if(!prepare()) return Passwords{};
+        auto& sdcard = SdCard::get();
+        const u64 start = armGetSystemTick();
+        const auto& tmpPath = temporaryPath(path);
+        u32 metadataOps = 0;
 
-        Passwords passwords;
-        
-        bool opened = R_SUCCEEDED(fsFsOpenFile(&sdmc, DB_FILENAME, FsOpenMode_Read, &handle_database));        
+        // Leftover of a failed commit
+        metadataOps++;
+        sdcard.deleteFile(tmpPath.c_str());
 
-        if(!opened) {
-            logToFile("Could not open database file. Try to create a new file.\n");
-            
-            // Verify whether data directory exists
-            FsDirEntryType type;
-            if(R_FAILED(fsFsGetEntryType(&sdmc, DATA_DIR, &type))) {
-                // The directory does not exist
-                if(!createDataDirectory()) {
-                    logToFile("[Database] The data directory could not be created.\n");
-                    return Passwords{};
-                }
-            }
+        // Preallocate the file so that the write does not have to extend it
+        metadataOps++;
+        if(R_FAILED(sdcard.createFile(tmpPath.c_str(), size))) {
+            LOG_ERROR(Database, "Could not create %s\n", tmpPath.c_str());
+            return false;
+        }
 
-            if(R_FAILED(fsFsCreateFile(&sdmc, DB_FILENAME, 0, 0))) {
-                logToFile("[Database] Could not create a new database file.\n");
-                return Passwords{};
-            }
-        } else {
-            s64 fileSize = 0;
-            
-            if(R_FAILED(fsFileGetSize(&handle_database, &fileSize))) {
-                logToFile("[Database] Could not get database file size\n");
-                fsFileClose(&handle_database);
-                return Passwords{};
-            } else {
-                logToFile("[Database] Database file size is %i\n", fileSize);
-            }
+        // Single page-aligned write, flushed once
+        const size_t alignedSize = ams::util::AlignUp(size, ams::os::MemoryPageSize);
+        u8* buffer = static_cast<u8*>(aligned_alloc(ams::os::MemoryPageSize, alignedSize));
+        if(buffer == nullptr) {
+            return false;
+        }
+        std::memcpy(buffer, data, size);
 
-            if(fileSize == 0) {
-                logToFile("[Database] Database file is empty\n");
-                fsFileClose(&handle_database);
-                return Passwords{};
-            }
+        metadataOps++;
+        ::Result rc = sdcard.write(tmpPath.c_str(), 0, buffer, size, FsWriteOption_Flush);
+        free(buffer);
 
-            u8* data_sessions = new u8[fileSize+1];            
-            if(data_sessions == nullptr) {
-                logToFile("[Database] Could not create a buffer for sessions\n");
-                
-                fsFileClose(&handle_database);
-                return Passwords{};
-            } else {
-                logToFile("[Database] sessions buffer ready at @%p\n", (void*)data_sessions);
-            }
-            
-            u64 dataRead = 0;
-            if(R_FAILED(fsFileRead(&handle_database, 0, data_sessions, fileSize, FsReadOption_None, &dataRead))) {
-                logToFile("[Database] Could not read the database file\n");
-
-                fsFileClose(&handle_database);
-                return Passwords{};
-            } else {
-                logToFile("[Database] Sessions database read\n");
-            }
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Database, "Could not write %s: %i:%i\n", tmpPath.c_str(), R_MODULE(rc), R_DESCRIPTION(rc));
+            return false;
+        }
 
-            data_sessions[fileSize] = '\0';
-            json j_settings = json::parse(data_sessions);
+        // The file system cannot rename over an existing file
+        metadataOps++;
+        sdcard.deleteFile(path);
 
-            std::vector<json> j_entries = j_settings["passwords"].get<std::vector<json>>();
+        // Renaming closes the handle of the temporary file
+        metadataOps++;
+        rc = sdcard.renameFile(tmpPath.c_str(), path);
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Database, "Could not rename %s: %i:%i\n", tmpPath.c_str(), R_MODULE(rc), R_DESCRIPTION(rc));
+            return false;
+        }
 
-            for(const auto& j_entry: j_entries) {
-                auto uidAsString = j_entry["uid"].get<std::string>();
-                auto password = j_entry["password"].get<std::string>();
-                //auto uid = accountUidFromString(uidAsString);
+        commit_stats.commits++;
+        commit_stats.lastLatencyNs = armTicksToNs(armGetSystemTick() - start);
+        commit_stats.lastMetadataOps = metadataOps;
+        commit_stats.bytesWritten += size;
 
-                passwords[uidAsString] = password;
-            }
+        LOG_DEBUG(Database, "Committed %s (%lu bytes) in %lu us, %u metadata operations\n", path, size, commit_stats.lastLatencyNs / 1000, metadataOps);
+
+        return true;
+    }
+
+    void recoverFile(const char* path, FileValidator validate)
+    {
+        if(!prepare()) return;
+
+        std::lock_guard<std::mutex> lock(mutex_commit);
+
+        auto& sdcard = SdCard::get();
+        const auto& tmpPath = temporaryPath(path);
+
+        if(!sdcard.exists(tmpPath.c_str())) return;
 
-            fsFileClose(&handle_database);
-            delete[] data_sessions;
+        if(sdcard.exists(path)) {
+            // The crash happened before the original was replaced, it is still valid
+            LOG_WARN(Database, "Discarding interrupted commit of %s\n", path);
+            sdcard.deleteFile(tmpPath.c_str());
+            return;
+        }
+
+        // The crash happened between the deletion and the rename, the new file is complete unless the data never reached the card
+        std::vector<u8> data;
+        if(R_FAILED(sdcard.readFile(tmpPath.c_str(), data)) || !validate(data)) {
+            LOG_ERROR(Database, "Discarding incomplete commit of %s\n", path);
+            sdcard.deleteFile(tmpPath.c_str());
+            return;
         }
 
-        return passwords;
+        LOG_INFO(Database, "Completing interrupted commit of %s\n", path);
+        sdcard.renameFile(tmpPath.c_str(), path);
     }
 
-    void savePassword(UserUid account, Password newPassword)
+    CommitStats commitStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex_commit);
+        return commit_stats;
+    }
+
+    u64 currentTimestamp()
+    {
+        u64 timestamp = 0;
+        ServiceSession timeService(Time);
+        if(timeService.ready()) {
+            timeService.call([&] { return timeGetCurrentTime(TimeType_UserSystemClock, &timestamp); });
+        }
+        return timestamp;
+    }
+
+    bool loadPasswords(const char* filename, CredentialIndex& passwords) 
     {
-        const auto& passwords = loadPasswords();
-        
         std::lock_guard<std::mutex> lock(mutex_database);
 
-        if(!prepare()) return;
+        LOG_DEBUG(Database, "Loading database at %s\n", filename);
 
-        json j_entries;
-        for(const auto& [uid, password]: passwords) {
-            json j_entry = json::object( {
-                { "uid", uid },                
-                { "password", uid == account ? newPassword : password }
-            });
+        if(!prepare()) return false;
 
-            j_entries.push_back(j_entry);
+        // The file is only read once, at import
+        std::vector<u8> data;
+        ::Result rc = SdCard::get().readFile(filename, data);
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Database, "Could not read the database file: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            return false;
         }
 
-        json j_passwords = json{
-            { "passwords", j_entries }
-        };
-        
-        if(R_FAILED(fsFsDeleteFile(&sdmc, DB_FILENAME))) {
-            logToFile("[Database] Could not delete the current database file\n");            
+        LOG_DEBUG(Database, "Database file size is %lu\n", data.size());
+
+        if(data.empty()) {
+            LOG_WARN(Database, "Database file is empty\n");
+            passwords.clear();
+            return true;
         }
 
-        if(R_FAILED(fsFsCreateFile(&sdmc, DB_FILENAME, 0, 0))) {
-            logToFile("[Database] Could not create the database file\n");
-            return;
-        } else {
-            logToFile("[Database] New database file created\n");
+        // The entries parsed before an error are not returned, a part of the users would be left without a PIN
+        CredentialIndex parsed;
+        const size_t size = data.size();
+        data.push_back('\0');
+        const auto& result = parsePasswordsJson(reinterpret_cast<const char*>(data.data()), size, parsed);
+        if(!result.ok) {
+            LOG_ERROR(Database, "Invalid database file at offset %lu: %s\n", result.offset, result.error);
+            return false;
+        }
+
+        passwords = std::move(parsed);
+        return true;
+    }
+
+    bool writePasswords(const CredentialIndex& passwords, const char* filename)
+    {
+        std::lock_guard<std::mutex> lock(mutex_database);
+
+        if(!prepare()) return false;
+
+        const auto data = serializePasswordsJson(passwords);
+        LOG_DEBUG(Database, "Writing passwords data (size=%lu)\n", data.size());
+
+        bool written = commitFile(filename, data.data(), data.size());
+        if(!written) {
+            LOG_ERROR(Database, "Could not write into database file\n");
+        }
+
+        return written;
+    }
+
+    bool savePassword(AccountUid uid, const Password& password)
+    {
+        return CredentialStore::get().update(uid, CredentialHasher::get().protect(uid, password));
+    }
+
+    bool verifyPassword(AccountUid uid, const Password& password)
+    {
+        const auto& stored = CredentialStore::get().find(uid);
+
+        if(!CredentialHasher::get().verify(uid, stored, password)) return false;
+
+        // The plain password stays usable if the hash cannot be written, it is migrated on the next verification
+        if(stored.kind == Credential::Plain) {
+            LOG_INFO(Database, "Migrating a plain password to a hash\n");
+            savePassword(uid, password);
         }
 
-        if(R_FAILED(fsFsOpenFile(&sdmc, DB_FILENAME, FsOpenMode_Write | FsOpenMode_Append, &handle_database))) {
-            logToFile("[Database] The database file could not be opened for writing\n");
+        return true;
+    }
+
+    CredentialStore::CredentialStore()
+#ifdef CREDENTIAL_SHARDS
+    : storage_(SHARDS_DIR) {}
+#else
+    : storage_(LOG_FILENAME) {}
+#endif
+
+    bool CredentialStore::importJson()
+    {
+        if(!prepare() || !SdCard::get().exists(DB_FILENAME)) {
+            return false;
+        }
+
+        LOG_INFO(Database, "Importing %s\n", DB_FILENAME);
+
+        // The file is kept in place until it has been imported entirely, it can be fixed and imported on the next start
+        CredentialIndex imported;
+        if(!loadPasswords(DB_FILENAME, imported)) {
+            LOG_ERROR(Database, "%s could not be imported\n", DB_FILENAME);
+            return false;
+        }
+
+        CredentialIndex passwords = passwords_;
+        imported.forEach([&](AccountUid uid, const Credential& credential) {
+            passwords.insert(uid, credential);
+        });
+
+        if(!storage_.rewrite(passwords)) {
+            return false;
+        }
+        passwords_ = std::move(passwords);
+
+        // Keep the original file aside, it must not be imported twice
+        SdCard::get().deleteFile(DB_IMPORTED_FILENAME);
+        SdCard::get().renameFile(DB_FILENAME, DB_IMPORTED_FILENAME);
+
+        return true;
+    }
+
+#ifdef CREDENTIAL_SHARDS
+    bool CredentialStore::importLog()
+    {
+        CredentialLog log(LOG_FILENAME);
+        if(!log.exists()) return false;
+
+        LOG_INFO(Database, "Importing %s\n", LOG_FILENAME);
+
+        CredentialIndex imported;
+        if(!log.replay(imported)) return false;
+
+        imported.forEach([&](AccountUid uid, const Credential& credential) {
+            passwords_.insert(uid, credential);
+        });
+
+        if(!storage_.rewrite(passwords_)) {
+            return false;
+        }
+
+        SdCard::get().deleteFile(LOG_IMPORTED_FILENAME);
+        SdCard::get().renameFile(LOG_FILENAME, LOG_IMPORTED_FILENAME);
+
+        return true;
+    }
+#endif
+
+    bool CredentialStore::load()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(!storage_.replay(passwords_)) {
+            passwords_.clear();
+
+            if(storage_.exists()) {
+                LOG_ERROR(Database, "The credential storage exists but could not be loaded\n");
+            }
+        }
+
+#ifdef CREDENTIAL_SHARDS
+        importLog();
+#endif
+        importJson();
+        stamp_ = storage_.stamp();
+        checkedTick_ = armGetSystemTick();
+        loaded_ = true;
+
+        LOG_INFO(Database, "%lu passwords loaded\n", passwords_.size());
+
+        return true;
+    }
+
+    void CredentialStore::reloadIfChanged()
+    {
+        if(!loaded_) {
+            storage_.replay(passwords_);
+            stamp_ = storage_.stamp();
+            checkedTick_ = armGetSystemTick();
+            loaded_ = true;
             return;
         }
 
-        const auto data = j_passwords.dump();
-        const auto s_data = data.c_str();
-        logToFile("[Database] Save passwords: %s\n", s_data);
+        const u64 now = armGetSystemTick();
+        if(armTicksToNs(now - checkedTick_) < STORAGE_CHECK_INTERVAL_MS * 1'000'000ULL) return;
+        checkedTick_ = now;
+
+        const auto& stamp = storage_.stamp();
+        if(stamp == stamp_) return;
+
+        LOG_INFO(Database, "The credential storage has changed, reloading\n");
+        storage_.replay(passwords_);
+        stamp_ = stamp;
+    }
+
+    Credential CredentialStore::find(AccountUid uid)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        reloadIfChanged();
+
+        const Credential* stored = passwords_.find(uid);
+        if(stored == nullptr) return Credential{};
+
+        // Records of an older schema are upgraded when they are first needed
+        Credential credential = *stored;
+        switch(migrateCredential(credential)) {
+            case MigrationApplied:
+                // If it cannot be written the record is migrated again next time
+                LOG_INFO(Database, "Credential migrated to schema %u\n", CredentialSchemaVersion);
+                if(storage_.append(uid, credential, true)) {
+                    passwords_.insert(uid, credential);
+                    stamp_ = storage_.stamp(uid);
+                }
+                break;
+
+            case MigrationFailed:
+                // An empty credential would offer to set a new PIN, the record is kept and nothing matches it
+                LOG_ERROR(Database, "The credential of %s cannot be read, the account is locked\n", accountUidToString(uid).c_str());
+                return Credential::locked();
 
-        logToFile("[Database] Writing passwords data %s (size=%i)\n", s_data, std::strlen(s_data));
-        if(R_FAILED(fsFileWrite(&handle_database, 0, s_data, std::strlen(s_data), FsWriteOption_Flush))) {
-            logToFile("[Database] Could not write into database file\n");
+            case MigrationNone:
+                break;
         }
 
-        fsFileClose(&handle_database);
+        return credential;
+    }
+
+    bool CredentialStore::update(AccountUid uid, const Credential& credential)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        reloadIfChanged();
+
+        // The memory only holds what the storage holds: a credential that could not be written is not answered
+        if(!storage_.append(uid, credential, passwords_.contains(uid))) {
+            LOG_ERROR(Database, "The credential of %s could not be written\n", accountUidToString(uid).c_str());
+            return false;
+        }
+
+        passwords_.insert(uid, credential);
+        stamp_ = storage_.stamp(uid);
+
+        return true;
+    }
+
+    void CredentialStore::compactIfNeeded()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(!storage_.needsCompaction()) return;
+
+        LOG_INFO(Database, "Compacting the credential storage (%u dead records)\n", storage_.stats().deadRecords);
+        storage_.rewrite(passwords_);
+        stamp_ = storage_.stamp();
+    }
+
+    bool CredentialStore::exportJson()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writePasswords(passwords_, DB_EXPORT_FILENAME);
+    }
+
+    size_t CredentialStore::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return passwords_.size();
     }
 
-}
\ No newline at end of file
+}
@@ -1,17 +1,125 @@
 #pragma once
 
-#include <map>
+#include <mutex>
+#include <vector>
 #include <switch.h>
 #include "helpers.h"
+#include "database_types.h"
+#include "credential_index.h"
+#include "credential_log.h"
+#include "credential_shards.h"
+#include "credential_hash.h"
+#include "credential_migration.h"
 
-namespace alefbet::authenticator::database {
+/* Minimum time between two checks of the credential storage for external changes (make DEFINES="-DSTORAGE_CHECK_INTERVAL_MS=...") */
+#ifndef STORAGE_CHECK_INTERVAL_MS
+#define STORAGE_CHECK_INTERVAL_MS 5000
+#endif
 
-    using Password = std::string;
-    using Passwords = std::map<UserUid, Password>;
+namespace alefbet::authenticator::database {
 
+    bool prepare();
     bool createDataDirectory();
 
+    struct CommitStats {
+        u64 commits = 0;
+        u64 lastLatencyNs = 0;
+        u32 lastMetadataOps = 0;    ///< Create, open, delete and rename requests of the last commit
+        u64 bytesWritten = 0;
+    };
+
+    /*! \brief Atomically replaces \p path with \p data.
+
+        The data is written to "<path>.tmp" (preallocated to its final size) with a single flushed
+        write, then renamed over the original. At any time either the old or the new file is complete.
+    */
+    bool commitFile(const char* path, const void* data, size_t size);
+
+    /*! \brief Tells whether \p data is a complete file of its format (magic, CRC). */
+    typedef bool (*FileValidator)(const std::vector<u8>& data);
+
+    /*! \brief Finishes or rolls back a commit interrupted by a crash.
+
+        A temporary file left without its original is only renamed over it if \p validate accepts
+        its content: the file may have kept its preallocated size without the data. Otherwise it
+        is deleted.
+    */
+    void recoverFile(const char* path, FileValidator validate);
+
+    CommitStats commitStats();
+
+    /*! \brief User system clock time, 0 if it is not available. */
+    u64 currentTimestamp();
+
+    /* Storage of the credentials: one append-only log (default) or one file per user (make DEFINES=-DCREDENTIAL_SHARDS) */
+#ifdef CREDENTIAL_SHARDS
+    using CredentialStorage = CredentialShards;
+#else
+    using CredentialStorage = CredentialLog;
+#endif
+
+    /* JSON import/export */    
+    /*! \brief Reads a JSON database into \p passwords. Returns false, \p passwords untouched, if any part of it could not be read. */
+    bool loadPasswords(const char* filename, CredentialIndex& passwords);
+    bool writePasswords(const CredentialIndex& passwords, const char* filename);
+
     /* Data management */    
-    Passwords loadPasswords();
-    void savePassword(UserUid account, Password password);
+    /*! \brief Hashes and stores the password of the user. Returns false if it could not be written. */
+    bool savePassword(AccountUid uid, const Password& password);
+
+    /*! \brief Checks \p password against the stored credential. A plain credential is replaced by a hash on success. */
+    bool verifyPassword(AccountUid uid, const Password& password);
+
+    /*! \brief Process-lifetime copy of the password database.
+
+        The database is loaded once from the credential storage and lookups are answered from memory.
+        Updates are written to the storage. Before a lookup the storage stamp is compared with the
+        last known one, at most every STORAGE_CHECK_INTERVAL_MS, so that external changes are picked
+        up without reloading and without querying the SD card on every lookup.
+        Records written by an older build are migrated to the current schema when they are read, a
+        record of an unknown schema is answered as a locked credential which no PIN matches.
+        A passwords.json file found in the data directory (older installs, manual edits) is imported
+        into the storage and renamed when the store is loaded.
+    */
+    class CredentialStore {
+        public:
+            static CredentialStore& get() {
+                static CredentialStore store;
+
+                return store;
+            }
+
+            bool load();
+
+            /*! \brief Returns the credential of the user, empty if none has been set. */
+            Credential find(AccountUid uid);
+
+            /*! \brief Writes the credential of the user, it is only answered by find() once written. */
+            bool update(AccountUid uid, const Credential& credential);
+
+            /*! \brief Rewrites the log if it holds too many superseded records. */
+            void compactIfNeeded();
+
+            /*! \brief Writes the passwords to passwords.export.json. */
+            bool exportJson();
+
+            size_t size();
+
+        private:
+            CredentialStore();
+
+            void reloadIfChanged();
+            bool importJson();
+#ifdef CREDENTIAL_SHARDS
+            bool importLog();
+#endif
+
+        private:
+            std::mutex mutex_;
+            CredentialStorage storage_;
+            bool loaded_ = false;
+            CredentialIndex passwords_;
+            StorageStamp stamp_;
+            u64 checkedTick_ = 0;       ///< Last comparison of the storage stamp
+    };
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <switch.h>
+#include "helpers.h"
+
+/* Schema of the credentials written by this build, raised by the tests of the migrations (make DEFINES="-DCREDENTIAL_SCHEMA_VERSION=...") */
+#ifndef CREDENTIAL_SCHEMA_VERSION
+#define CREDENTIAL_SCHEMA_VERSION 1
+#endif
+
+namespace alefbet::authenticator::database {
+
+    using Password = std::string;
+
+    constexpr size_t CredentialDataSize = 56;
+    constexpr size_t CredentialSaltSize = 16;
+    constexpr size_t CredentialKeySize = 32;
+
+    /*! \brief Schema of the credentials written by this build, see credential_migration.h. */
+    constexpr u8 CredentialSchemaVersion = CREDENTIAL_SCHEMA_VERSION;
+
+    /*! \brief Salted PBKDF2-HMAC-SHA256 key of a PIN, with the iteration count used to derive it.
+    */
+    struct CredentialHash {
+        u8 salt[CredentialSaltSize] = {};
+        u8 key[CredentialKeySize] = {};
+        u32 iterations = 0;
+        u32 reserved = 0;
+    };
+    static_assert(sizeof(CredentialHash) == CredentialDataSize);
+
+    /*! \brief Fixed-size credential blob.
+    */
+    struct Credential {
+        typedef enum : u8 {
+            Empty = 0,
+            Plain = 1,      ///< data holds the encoded PIN as text (older installs)
+            Hashed = 2,     ///< data holds a CredentialHash
+            Locked = 3      ///< A record which could not be read, no PIN matches it
+        } Kind;
+
+        u8 kind = Empty;
+        u8 length = 0;
+        u8 schema = CredentialSchemaVersion;
+        u8 reserved[5] = {};
+        u8 data[CredentialDataSize] = {};
+
+        static Credential fromPassword(std::string_view password) {
+            Credential credential;
+
+            if(password.empty() || password.size() > CredentialDataSize) return credential;
+
+            credential.kind = Plain;
+            credential.length = static_cast<u8>(password.size());
+            std::memcpy(credential.data, password.data(), password.size());
+
+            return credential;
+        }
+
+        static Credential fromHash(const CredentialHash& hash) {
+            Credential credential;
+
+            credential.kind = Hashed;
+            credential.length = sizeof(hash);
+            std::memcpy(credential.data, &hash, sizeof(hash));
+
+            return credential;
+        }
+
+        CredentialHash hash() const {
+            CredentialHash hash;
+            if(kind == Hashed) {
+                std::memcpy(&hash, data, sizeof(hash));
+            }
+            return hash;
+        }
+
+        std::string_view password() const {
+            return kind == Plain ? std::string_view(reinterpret_cast<const char*>(data), length) : std::string_view();
+        }
+
+        static Credential locked() {
+            Credential credential;
+            credential.kind = Locked;
+            return credential;
+        }
+
+        bool empty() const {
+            return kind == Empty;
+        }
+    };
+    static_assert(sizeof(Credential) == 64);
+
+    /*! \brief Entry of the credential index, as stored in memory and on the SD card.
+    */
+    struct CredentialRecord {
+        AccountUid uid;
+        Credential credential;
+    };
+    static_assert(sizeof(CredentialRecord) == 80);
+
+    struct CredentialStorageStats {
+        u64 appends = 0;
+        u64 bytesWritten = 0;
+        u64 lastAppendNs = 0;
+        u32 lastAppendOps = 0;      ///< SD card requests issued by the last append
+        u32 liveRecords = 0;
+        u32 deadRecords = 0;        ///< Records superseded by a more recent one
+        u32 compactions = 0;
+        u32 recoveredRecords = 0;   ///< Valid records found at the last replay
+        u32 corruptRecords = 0;     ///< Records skipped at the last replay, followed by valid ones
+        u64 discardedBytes = 0;     ///< Bytes dropped after the last valid record
+    };
+
+    /*! \brief Cheap fingerprint of the stored credentials, used to detect external changes.
+    */
+    struct StorageStamp {
+        s64 size = -1;
+        u64 modified = 0;
+
+        bool operator==(const StorageStamp&) const = default;
+    };
+
+}
@@ -0,0 +1,293 @@
+#include "password_json.h"
+#include "credential_hash.h"
+#include <string_view>
+
+using namespace alefbet::authenticator::helpers;
+
+namespace alefbet::authenticator::database {
+
+    namespace {
+
+        class Parser {
+            public:
+                Parser(const char* data, size_t size)
+                : data_(data), size_(size) {}
+
+                JsonParseResult parse(CredentialIndex& passwords) {
+                    skipSpaces();
+                    if(!expect('{')) return result_;
+
+                    bool found = false;
+                    if(!parseMembers([&](std::string_view key) {
+                        if(key == "passwords") {
+                            found = true;
+                            return parseEntries(passwords);
+                        }
+                        return skipValue();
+                    })) return result_;
+
+                    if(!found) {
+                        fail("missing \"passwords\"");
+                        return result_;
+                    }
+
+                    // Nothing but spaces may follow the object
+                    skipSpaces();
+                    if(pos_ < size_) fail("trailing characters");
+                    return result_;
+                }
+
+            private:
+                bool fail(const char* error) {
+                    if(result_.ok) {
+                        result_.ok = false;
+                        result_.error = error;
+                        result_.offset = pos_;
+                    }
+                    return false;
+                }
+
+                void skipSpaces() {
+                    while(pos_ < size_ && (data_[pos_] == ' ' || data_[pos_] == '\n' || data_[pos_] == '\r' || data_[pos_] == '\t')) {
+                        pos_++;
+                    }
+                }
+
+                bool peek(char c) {
+                    skipSpaces();
+                    return pos_ < size_ && data_[pos_] == c;
+                }
+
+                bool expect(char c) {
+                    if(!peek(c)) return fail("unexpected character");
+                    pos_++;
+                    return true;
+                }
+
+                /* Calls handler(key) for each member of the object whose '{' has been consumed */
+                template<typename F>
+                bool parseMembers(F&& handler) {
+                    if(peek('}')) {
+                        pos_++;
+                        return true;
+                    }
+
+                    while(true) {
+                        // Keys are compared raw, an escaped key is simply unknown
+                        std::string_view key;
+                        bool escaped = false;
+                        if(!scanString(key, escaped)) return false;
+                        if(!expect(':')) return false;
+                        if(!handler(key)) return false;
+
+                        if(peek(',')) {
+                            pos_++;
+                            continue;
+                        }
+                        return expect('}');
+                    }
+                }
+
+                bool parseEntries(CredentialIndex& passwords) {
+                    if(!expect('[')) return false;
+
+                    if(peek(']')) {
+                        pos_++;
+                        return true;
+                    }
+
+                    while(true) {
+                        if(!parseEntry(passwords)) return false;
+
+                        if(peek(',')) {
+                            pos_++;
+                            continue;
+                        }
+                        return expect(']');
+                    }
+                }
+
+                bool parseEntry(CredentialIndex& passwords) {
+                    if(!expect('{')) return false;
+
+                    std::string_view uid, password;
+                    std::string uidStorage, passwordStorage;
+                    bool hasUid = false, hasPassword = false;
+
+                    if(!parseMembers([&](std::string_view key) {
+                        if(key == "uid") {
+                            hasUid = true;
+                            return parseString(uid, uidStorage);
+                        } else if(key == "password") {
+                            hasPassword = true;
+                            return parseString(password, passwordStorage);
+                        }
+                        return skipValue();
+                    })) return false;
+
+                    if(!hasUid || !hasPassword) return fail("incomplete entry");
+
+                    AccountUid accountUid = {};
+                    if(!parseAccountUid(uid, accountUid) || !accountUidIsValid(&accountUid)) return fail("invalid uid");
+
+                    CredentialHash hash;
+                    if(decodeCredentialHash(password, hash)) {
+                        passwords.insert(accountUid, Credential::fromHash(hash));
+                    } else if(!password.empty() && password.size() <= CredentialDataSize) {
+                        passwords.insert(accountUid, Credential::fromPassword(password));
+                    } else {
+                        return fail("invalid password");
+                    }
+
+                    result_.entries++;
+                    return true;
+                }
+
+                /* Moves past a string and returns its raw contents */
+                bool scanString(std::string_view& raw, bool& escaped) {
+                    if(!expect('"')) return false;
+
+                    const size_t start = pos_;
+                    escaped = false;
+                    while(pos_ < size_ && data_[pos_] != '"') {
+                        if(data_[pos_] == '\\') {
+                            escaped = true;
+                            pos_++;
+                        }
+                        pos_++;
+                    }
+
+                    if(pos_ >= size_) return fail("unterminated string");
+
+                    raw = std::string_view(data_ + start, pos_ - start);
+                    pos_++;
+                    return true;
+                }
+
+                /* Strings without escape sequences are returned as a view of the input,
+                   escaped strings are decoded into storage */
+                bool parseString(std::string_view& out, std::string& storage) {
+                    bool escaped = false;
+                    if(!scanString(out, escaped)) return false;
+                    if(!escaped) return true;
+
+                    storage.clear();
+                    for(size_t i = 0; i < out.size(); i++) {
+                        if(out[i] != '\\') {
+                            storage.push_back(out[i]);
+                            continue;
+                        }
+
+                        switch(out[++i]) {
+                            case '"':  storage.push_back('"'); break;
+                            case '\\': storage.push_back('\\'); break;
+                            case '/':  storage.push_back('/'); break;
+                            case 'n':  storage.push_back('\n'); break;
+                            case 't':  storage.push_back('\t'); break;
+                            case 'r':  storage.push_back('\r'); break;
+                            case 'b':  storage.push_back('\b'); break;
+                            case 'f':  storage.push_back('\f'); break;
+                            default:   return fail("unsupported escape sequence");
+                        }
+                    }
+
+                    out = storage;
+                    return true;
+                }
+
+                /* Unknown values are skipped recursively, the depth is bounded so that a crafted file cannot exhaust the stack */
+                bool skipValue(u32 depth = 0) {
+                    if(depth >= MaxDepth) return fail("nested too deeply");
+
+                    skipSpaces();
+                    if(pos_ >= size_) return fail("unexpected end of input");
+
+                    std::string_view ignored;
+                    bool escaped = false;
+                    switch(data_[pos_]) {
+                        case '"':
+                            return scanString(ignored, escaped);
+                        case '{':
+                            pos_++;
+                            return parseMembers([&](std::string_view) { return skipValue(depth + 1); });
+                        case '[':
+                            pos_++;
+                            if(peek(']')) {
+                                pos_++;
+                                return true;
+                            }
+                            while(true) {
+                                if(!skipValue(depth + 1)) return false;
+                                if(peek(',')) {
+                                    pos_++;
+                                    continue;
+                                }
+                                return expect(']');
+                            }
+                        default: {
+                            // Numbers and literals
+                            const size_t start = pos_;
+                            while(pos_ < size_ && std::string_view(",}] \n\r\t").find(data_[pos_]) == std::string_view::npos) {
+                                pos_++;
+                            }
+                            if(pos_ == start) return fail("unexpected character");
+                            return true;
+                        }
+                    }
+                }
+
+            private:
+                static constexpr u32 MaxDepth = 32;
+
+                const char* data_;
+                size_t size_;
+                size_t pos_ = 0;
+                JsonParseResult result_;
+        };
+
+        void appendEscaped(std::string& out, std::string_view value) {
+            out.push_back('"');
+            for(const char c: value) {
+                switch(c) {
+                    case '"':  out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\r': out += "\\r"; break;
+                    default:   out.push_back(c); break;
+                }
+            }
+            out.push_back('"');
+        }
+
+    }
+
+    JsonParseResult parsePasswordsJson(const char* data, size_t size, CredentialIndex& passwords) {
+        Parser parser(data, size);
+        return parser.parse(passwords);
+    }
+
+    std::string serializePasswordsJson(const CredentialIndex& passwords) {
+        std::string out = "{\"passwords\":[";
+
+        bool first = true;
+        passwords.forEach([&](AccountUid uid, const Credential& credential) {
+            if(!first) out.push_back(',');
+            first = false;
+
+            out += "{\"uid\":";
+            appendEscaped(out, accountUidToString(uid));
+            out += ",\"password\":";
+            if(credential.kind == Credential::Hashed) {
+                appendEscaped(out, encodeCredentialHash(credential.hash()));
+            } else {
+                appendEscaped(out, credential.password());
+            }
+            out.push_back('}');
+        });
+
+        out += "]}";
+        return out;
+    }
+
+}
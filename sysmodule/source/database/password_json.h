@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <switch.h>
+#include "credential_index.h"
+
+namespace alefbet::authenticator::database {
+
+    struct JsonParseResult {
+        bool ok = true;
+        size_t offset = 0;              ///< Position of the error in the input
+        const char* error = nullptr;
+        size_t entries = 0;             ///< Number of entries parsed
+    };
+
+    /*! \brief Parses a password database in place.
+
+        Only the {"passwords":[{"uid":"...","password":"..."}]} schema is supported. Values are
+        read directly from the input buffer and inserted in \p passwords; no document is built.
+        Hashed passwords use the textual form of encodeCredentialHash(), anything else is
+        read as a plain password. Unknown keys are skipped. Malformed input is reported through the result instead of aborting.
+    */
+    JsonParseResult parsePasswordsJson(const char* data, size_t size, CredentialIndex& passwords);
+
+    /*! \brief Serializes the password database with the same schema. */
+    std::string serializePasswordsJson(const CredentialIndex& passwords);
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <switch.h>
+#include <algorithm>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace alefbet {
+    namespace authenticator {
+        namespace gfx {
+
+            /**
+             * @brief Divides by 15 without a division, exact for the sums of two products of 4 bits channels (0 to 225)
+             *
+             * @param n Blended channel, scaled by 15
+             * @return Channel
+             */
+            constexpr inline u16 div15(u16 n) {
+                return (n * 0x89) >> 11;
+            }
+
+            /**
+             * @brief Blends a RGBA4444 color over a RGBA4444 pixel, the alpha of the color weighting the channels and adding up to the alpha of the pixel
+             *
+             * @param pixel Pixel of the framebuffer
+             * @param color Color drawn over it
+             * @return Blended pixel
+             */
+            constexpr inline u16 blendPixel(u16 pixel, u16 color) {
+                const u16 alpha = color >> 12;
+                const u16 inverse = 0xF - alpha;
+
+                u16 end = std::min<u16>((pixel >> 12) + alpha, 0xF) << 12;
+
+                for (u32 shift = 0; shift < 12; shift += 4)
+                    end |= div15(((color >> shift) & 0xF) * alpha + ((pixel >> shift) & 0xF) * inverse) << shift;
+
+                return end;
+            }
+
+            /**
+             * @brief Blends a RGBA4444 color over a run of contiguous pixels, 8 pixels at a time with NEON
+             *
+             * @param run First pixel
+             * @param count Number of pixels
+             * @param color Color drawn over them
+             */
+            inline void blendRun(u16 *run, u32 count, u16 color) {
+                u32 i = 0;
+
+#ifdef __ARM_NEON
+                const u16 alpha = color >> 12;
+
+                const uint16x8_t mask = vdupq_n_u16(0xF);
+                const uint16x8_t reciprocal = vdupq_n_u16(0x89);
+                const uint16x8_t inverse = vdupq_n_u16(0xF - alpha);
+                const uint16x8_t colorR = vdupq_n_u16((color & 0xF) * alpha);
+                const uint16x8_t colorG = vdupq_n_u16(((color >> 4) & 0xF) * alpha);
+                const uint16x8_t colorB = vdupq_n_u16(((color >> 8) & 0xF) * alpha);
+                const uint16x8_t colorA = vdupq_n_u16(alpha);
+
+                for (; i + 8 <= count; i += 8) {
+                    const uint16x8_t pixels = vld1q_u16(run + i);
+
+                    uint16x8_t r = vmlaq_u16(colorR, vandq_u16(pixels, mask), inverse);
+                    uint16x8_t g = vmlaq_u16(colorG, vandq_u16(vshrq_n_u16(pixels, 4), mask), inverse);
+                    uint16x8_t b = vmlaq_u16(colorB, vandq_u16(vshrq_n_u16(pixels, 8), mask), inverse);
+                    const uint16x8_t a = vminq_u16(vaddq_u16(vshrq_n_u16(pixels, 12), colorA), mask);
+
+                    r = vshrq_n_u16(vmulq_u16(r, reciprocal), 11);
+                    g = vshrq_n_u16(vmulq_u16(g, reciprocal), 11);
+                    b = vshrq_n_u16(vmulq_u16(b, reciprocal), 11);
+
+                    vst1q_u16(run + i, vorrq_u16(vorrq_u16(r, vshlq_n_u16(g, 4)), vorrq_u16(vshlq_n_u16(b, 8), vshlq_n_u16(a, 12))));
+                }
+#endif
+
+                for (; i < count; i++)
+                    run[i] = blendPixel(run[i], color);
+            }
+
+        }
+    }
+}
@@ -0,0 +1,229 @@
+#pragma once
+#include <switch.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gui/renderer.hpp"
+#include "logger.h"
+
+namespace alefbet {
+    namespace authenticator {
+        namespace gfx {
+
+            typedef enum {
+                NodeRect,
+                NodeText,
+                NodeCircle
+            } NodeType;
+
+            /**
+             * @brief Element of a display list
+             *
+             * Rectangles use x, y, w and h. Circles are centered on x and y, w being the radius. Texts start at x, or are
+             * centered in the list, on the baseline y and h is the font size.
+             */
+            struct DisplayNode {
+                NodeType type;
+                s32 x = 0, y = 0, w = 0, h = 0;
+                Color color = Color(0);
+                bool filled = false;
+                bool centered = false;
+                std::string text;
+
+                bool dirty = true;                                  ///< Changed since the last frame
+                Rect bounds;                                        ///< Pixels covered by the last frame
+                s32 textX = 0;                                      ///< Position of the text once centered
+                std::unordered_map<std::string, s32> widths;        ///< Width of the texts already measured
+            };
+
+            /**
+             * @brief Retained scene drawn by the renderer
+             *
+             * Nodes are identified by the index returned when they are added and are drawn in that order over a
+             * background. A frame only invalidates the nodes which changed since the previous one, at their old and new
+             * place, then draws the nodes overlapping the damage. A frame where nothing changed is not drawn at all.
+             */
+            class DisplayList {
+                public:
+                    void reset(u16 width, u16 height, Color background) {
+                        nodes_.clear();
+                        width_ = width;
+                        height_ = height;
+                        background_ = background;
+                        drawn_ = false;
+                    }
+
+                    u32 addRect(s32 x, s32 y, s32 w, s32 h, Color color) {
+                        DisplayNode node = { NodeRect, x, y, w, h, color, false, false, {}, true, {}, 0, {} };
+                        return add(std::move(node));
+                    }
+
+                    u32 addCircle(s32 centerX, s32 centerY, u16 radius, bool filled, Color color) {
+                        DisplayNode node = { NodeCircle, centerX, centerY, radius, 0, color, filled, false, {}, true, {}, 0, {} };
+                        return add(std::move(node));
+                    }
+
+                    /**
+                     * @brief Adds a text
+                     *
+                     * @param x X pos, ignored when the text is centered
+                     * @param y Baseline
+                     * @param fontSize Height of the text in pixels
+                     * @param centered Center the text horizontally in the list
+                     */
+                    u32 addText(const std::string& text, s32 x, s32 y, s32 fontSize, Color color, bool centered = false) {
+                        DisplayNode node = { NodeText, x, y, 0, fontSize, color, false, centered, text, true, {}, 0, {} };
+                        return add(std::move(node));
+                    }
+
+                    void setText(u32 id, const std::string& text, Color color) {
+                        auto& node = nodes_[id];
+                        if (node.text == text && node.color.rgba == color.rgba)
+                            return;
+
+                        node.text = text;
+                        node.color = color;
+                        node.dirty = true;
+                    }
+
+                    void setFilled(u32 id, bool filled) {
+                        auto& node = nodes_[id];
+                        if (node.filled == filled)
+                            return;
+
+                        node.filled = filled;
+                        node.dirty = true;
+                    }
+
+                    void setColor(u32 id, Color color) {
+                        auto& node = nodes_[id];
+                        if (node.color.rgba == color.rgba)
+                            return;
+
+                        node.color = color;
+                        node.dirty = true;
+                    }
+
+                    /**
+                     * @brief Draws the whole list again by the next frames, once the content of the screen is lost
+                     */
+                    void invalidate() {
+                        drawn_ = false;
+                    }
+
+                    /**
+                     * @brief Draws the changes since the previous frame
+                     *
+                     * @return Whether a frame was drawn
+                     */
+                    bool render() {
+                        auto& renderer = Renderer::get();
+                        bool changed = !drawn_;
+
+                        if (!drawn_)
+                            renderer.invalidateAll();
+
+                        for (auto& node : nodes_) {
+                            if (!node.dirty)
+                                continue;
+
+                            renderer.invalidate(node.bounds.x0, node.bounds.y0, node.bounds.x1 - node.bounds.x0, node.bounds.y1 - node.bounds.y0);
+                            this->layout(node);
+                            renderer.invalidate(node.bounds.x0, node.bounds.y0, node.bounds.x1 - node.bounds.x0, node.bounds.y1 - node.bounds.y0);
+
+                            node.dirty = false;
+                            changed = true;
+                        }
+
+                        if (!changed)
+                            return false;
+
+                        drawn_ = true;
+
+                        renderer.startFrame();
+                        renderer.clearScreen(background_);
+
+                        u32 drawnNodes = 0;
+                        for (const auto& node : nodes_) {
+                            if (!renderer.isDamaged(node.bounds))
+                                continue;
+
+                            this->draw(node);
+                            drawnNodes++;
+                        }
+
+                        renderer.endFrame();
+
+                        LOG_DEBUG(Renderer, "Display list frame: %u of %lu nodes drawn\n", drawnNodes, nodes_.size());
+
+                        return true;
+                    }
+
+                private:
+                    u32 add(DisplayNode&& node) {
+                        nodes_.push_back(std::move(node));
+                        return nodes_.size() - 1;
+                    }
+
+                    /**
+                     * @brief Computes the pixels covered by a node, texts being measured once per string
+                     */
+                    void layout(DisplayNode& node) {
+                        switch (node.type) {
+                            case NodeRect:
+                                node.bounds = { node.x, node.y, node.x + node.w, node.y + node.h };
+                                break;
+
+                            case NodeCircle:
+                                node.bounds = { node.x - node.w, node.y - node.w, node.x + node.w + 1, node.y + node.w + 1 };
+                                break;
+
+                            case NodeText: {
+                                auto it = node.widths.find(node.text);
+                                if (it == node.widths.end()) {
+                                    const auto& dimensions = Renderer::get().drawString(node.text.c_str(), false, 0, 0, node.h, Color(0, 0, 0, 0));
+                                    it = node.widths.emplace(node.text, dimensions.first).first;
+                                }
+
+                                const s32 width = it->second;
+                                node.textX = node.centered ? (width_ - width) / 2 : node.x;
+
+                                // Glyphs go above the baseline, below it for descenders and slightly aside
+                                const s32 margin = node.h / 4;
+                                node.bounds = { node.textX - margin, node.y - node.h, node.textX + width + margin, node.y + node.h };
+                                break;
+                            }
+                        }
+
+                        node.bounds = node.bounds.intersected({ 0, 0, width_, height_ });
+                    }
+
+                    void draw(const DisplayNode& node) {
+                        auto& renderer = Renderer::get();
+
+                        switch (node.type) {
+                            case NodeRect:
+                                renderer.drawRect(node.x, node.y, node.w, node.h, node.color);
+                                break;
+
+                            case NodeCircle:
+                                renderer.drawCircle(node.x, node.y, node.w, node.filled, node.color);
+                                break;
+
+                            case NodeText:
+                                renderer.drawString(node.text.c_str(), false, node.textX, node.y, node.h, node.color);
+                                break;
+                        }
+                    }
+
+                private:
+                    std::vector<DisplayNode> nodes_;
+                    s32 width_ = 0;
+                    s32 height_ = 0;
+                    Color background_ = Color(0);
+                    bool drawn_ = false;                ///< The screen shows the list, only the changes need to be drawn
+            };
+
+        }
+    }
+}
@@ -1,15 +1,19 @@
 #include "gui_controller.h"
 #include "logger.h"
 #include "gui/renderer.hpp"
+#include "gui/display_list.hpp"
 #include "utils.h"
 #include "helpers.h"
 #include "database/database.h"
+#include "service_manager.h"
+#include <iterator>
 #include <mutex>
 
 using namespace alefbet::authenticator::logger;
 using namespace alefbet::authenticator::gfx;
 using namespace alefbet::authenticator::helpers;
 using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
 
 constexpr Color textColor =         Color(0xf, 0xf, 0xf, 0xf);    // White
 constexpr Color circleColor =       Color(0xf, 0xf, 0xf, 0xf);    // White
@@ -18,8 +22,20 @@ constexpr Color titleColor =        Color(0x1, 0xc, 0xe, 0xf);    // Light blue
 constexpr Color errorColor =        Color(0xf, 0x0, 0x0, 0xf);    // Plain red
 constexpr Color successColor =      Color(0x0, 0xf, 0xd, 0xf);    // Green
 
+constexpr s32 MessageY = 348;
+constexpr s32 MessageFontSize = 62;
+constexpr s32 CirclesX[] = { 416, 550, 680, 818 };
+constexpr s32 CirclesY = 496;
+constexpr u16 CircleRadius = 24;
+
 static std::mutex s_mutexVisible;
 
+/* Retained content of the authentication panel, built by the monitor thread and drawn by the GUI thread */
+static std::mutex s_mutexPanel;
+static DisplayList s_panel;
+static u32 s_messageNode = 0;
+static u32 s_circleNodes[std::size(CirclesX)];
+
 /* There should only be a single transfer memory (for nv). */
 alignas(ams::os::MemoryPageSize) constinit u8 g_nv_transfer_memory[0x40000];
 extern "C" ::Result __nx_nv_create_tmem(TransferMemory *t, u32 *out_size, Permission perm) {
@@ -38,11 +54,16 @@ bool GuiController::isVisible() const {
 }
 
 void GuiController::init() {
-    logToFile("[Gui] Initialize GUI\n");
+    LOG_INFO(Gui, "Initialize GUI\n");
+
+    // Keep the input sessions open for the lifetime of the sysmodule
+    auto& services = ServiceManager::get();
+    services.acquire(Hid);
+    services.acquire(HidSys);
 }
 
 void GuiController::start() {
-    logToFile("[Gui] starting loop\n");    
+    LOG_INFO(Gui, "starting loop\n");    
 
     while(true) {        
         if(isVisible()) {
@@ -57,24 +78,22 @@ void GuiController::start() {
         svcSleepThread(100'000'000); // Wait 20 ms
     }
 
-    logToFile("[Gui] loop ended\n");
+    LOG_INFO(Gui, "loop ended\n");
 }
 
-void GuiController::showAuthenticationPanel() {        
-    logToFile("[Gui] Show authentication panel\n");
+void GuiController::showAuthenticationPanel(const UserData& user) {        
+    LOG_INFO(Gui, "Show authentication panel\n");
 
     keysDown_.clear();
     enteredPin_.clear();
     user_.clear();
 
     // Verify whether a PIN has been set for the user
-    user_ = getCurrentUser();
-    auto passwords = loadPasswords();
-    const auto& uid = accountUidToString(user_.uid);
-    const auto& password = passwords[uid];
+    user_ = user;
+    const auto& credential = CredentialStore::get().find(user_.uid);
     
     // If there is no password for the user we need a setup
-    pinStage_ = password.empty() ? PinSetup : PinVerification;
+    pinStage_ = credential.empty() ? PinSetup : PinVerification;
     
     width_ = 1216; // Width must be a multiple of 64
     height_ = 768;
@@ -83,6 +102,7 @@ void GuiController::showAuthenticationPanel() {
     u16 posY = (ScreenHeight - height_) / 2; // Centered
 
     showOverlay(width_, height_, posX, posY);    
+    buildPanel();
 
     setVisible(true);
 
@@ -92,76 +112,69 @@ void GuiController::showAuthenticationPanel() {
     requestForeground(true);
 }   
 
+void GuiController::buildPanel() {
+    std::lock_guard<std::mutex> mutex(s_mutexPanel);
+    s_panel.reset(width_, height_, backgroundColor);
+
+    // The title
+    s_panel.addText("Authentication", 384, 116, 62, titleColor);
+
+    // The message, set by the stage of the PIN entry
+    s_messageNode = s_panel.addText("", 0, MessageY, MessageFontSize, textColor, true);
+
+    // The circles, filled as the keys are pressed
+    for(size_t i = 0; i < std::size(CirclesX); i++) {
+        s_circleNodes[i] = s_panel.addCircle(CirclesX[i], CirclesY, CircleRadius, false, circleColor);
+    }
+}
+
 void GuiController::refreshPanel() {
     //if(!isVisible()) return;
 
-    logToFile("[Gui] refreshing panel\n");
+    LOG_TRACE(Gui, "refreshing panel\n");
 
-    auto& renderer = Renderer::get();
-    renderer.startFrame();
-    clearScreen(false);
-        
-    // Draw the background
-    renderer.drawRect(0, 0, width_, height_, backgroundColor);
+    std::string message;
+    Color messageColor = textColor;
 
-    // Draw the title
-    renderer.drawString("Authentication", false, 384, 116, 62, titleColor);    
-    
     switch(pinStage_) {
-        case PinSetup: {
+        case PinSetup:
             // If the user does not already have a code we ask him to create one
-            std::string str = user_.nickname + ", please enter a new PIN.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, textColor);            
+            message = user_.nickname + ", please enter a new PIN.";
             break;
-        }
-        case PinSetupVerification: {
-            std::string str = "Please re-enter your PIN.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, textColor);
+        case PinSetupVerification:
+            message = "Please re-enter your PIN.";
             break;
-        }
-        case PinsDontMatch: {
-            std::string str = "The PINs don't match. Try again.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, errorColor);
+        case PinsDontMatch:
+            message = "The PINs don't match. Try again.";
+            messageColor = errorColor;
             break;
-        }
-        case PinError: {
-            std::string str = "Wrong PIN.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, errorColor);
+        case PinError:
+            message = "Wrong PIN.";
+            messageColor = errorColor;
             break;
-        }
-        case PinOk: {
-            std::string str = "Correct PIN.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, successColor);
+        case PinNotSaved:
+            message = "The PIN could not be saved. Try again.";
+            messageColor = errorColor;
             break;
-        }
-        case PinVerification: {
+        case PinOk:
+            message = "Correct PIN.";
+            messageColor = successColor;
+            break;
+        case PinVerification:
             // Otherwise we ask the user password
-            std::string str = user_.nickname + ", please enter your PIN.";
-            const auto& width = calculateTextWidth(str, 62);
-            renderer.drawString(str.c_str(), false, (width_ - width)/2, 348, 62, textColor);  
-            break;  
-        }
+            message = user_.nickname + ", please enter your PIN.";
+            break;
     }
-    
-    // Draw the circles
-    renderer.drawCircle(416, 496, 24, keysDown_.size() >= 1, circleColor);
-    renderer.drawCircle(550, 496, 24, keysDown_.size() >= 2, circleColor);
-    renderer.drawCircle(680, 496, 24, keysDown_.size() >= 3, circleColor);
-    renderer.drawCircle(818, 496, 24, keysDown_.size() > 3, circleColor);
 
-    renderer.endFrame();    
-}
+    std::lock_guard<std::mutex> mutex(s_mutexPanel);
+    s_panel.setText(s_messageNode, message, messageColor);
 
-int GuiController::calculateTextWidth(const std::string& text, int fontSize, bool monospace)
-{
-    auto& renderer = Renderer::get();
-    const auto& dimension = renderer.drawString(text.c_str(), monospace, 0, 100, fontSize, Color(0, 0, 0, 0));
-    return dimension.first;
+    for(size_t i = 0; i < std::size(CirclesX); i++) {
+        s_panel.setFilled(s_circleNodes[i], keysDown_.size() > i);
+    }
+
+    // Only the nodes which changed are drawn again, nothing when none did
+    s_panel.render();
 }
 
 void GuiController::hideAll() {
@@ -172,18 +185,15 @@ void GuiController::hideAll() {
 
     requestForeground(false);
 
-    logToFile("[Gui] Hide remaining time panel\n");
+    LOG_INFO(Gui, "Hide remaining time panel\n");
     clearScreen();
 
     // We need to free all video resources
     renderer.exit();    
-
-    hidsysExit();
-    hidExit();    
 }
 
 void GuiController::showOverlay(u16 width, u16 height, u16 posX, u16 posY) {
-    logToFile("[Gui] show Overlay of size %ix%i\n", width, height);
+    LOG_DEBUG(Gui, "show Overlay of size %ix%i\n", width, height);
 
     auto& renderer = Renderer::get();    
     renderer.init(width, height, posX, posY);
@@ -194,6 +204,7 @@ void GuiController::clearScreen(bool ownFrame) {
     auto& renderer = Renderer::get();
 
     if(ownFrame) {
+        renderer.invalidateAll();
         renderer.startFrame();
     }
 
@@ -206,10 +217,11 @@ void GuiController::clearScreen(bool ownFrame) {
 
 void GuiController::handlePinInput() {
     // When this function is called it means that a PIN has been entered
-    // There are 2 possibilities:
+    // There are 3 possibilities:
     // - This is the new PIN and we have to ask the user to re-enter for verification
     // - This is the control PIN and we have to verify it
-    if(pinStage_ == PinSetup || pinStage_ == PinsDontMatch) {
+    // - This is the PIN of a user who already has one and we have to check it
+    if(pinStage_ == PinSetup || pinStage_ == PinsDontMatch || pinStage_ == PinNotSaved) {
         enteredPin_ = encodePassword(keysDown_);
         keysDown_.clear();
         pinStage_ = PinSetupVerification;
@@ -220,11 +232,18 @@ void GuiController::handlePinInput() {
         
         pinStage_ = verifPin == enteredPin_ ? PinOk : PinsDontMatch;
 
-        if(pinStage_ == PinOk) {
-            const auto& uid = accountUidToString(user_.uid);
-            savePassword(uid, verifPin);
+        // A PIN which could not be stored would not be asked next time, it has to be entered again
+        if(pinStage_ == PinOk && !savePassword(user_.uid, verifPin)) {
+            pinStage_ = PinNotSaved;
         }
         
+        needsRefresh_ = true;
+    } else if(pinStage_ == PinVerification || pinStage_ == PinError) {
+        const auto& pin = encodePassword(keysDown_);
+        keysDown_.clear();
+
+        pinStage_ = verifyPassword(user_.uid, pin) ? PinOk : PinError;
+
         needsRefresh_ = true;
     }
  }
@@ -248,32 +267,29 @@ Result GuiController::hidsysEnableAppletToGetInput(bool enable, u64 aruid) {
 void GuiController::requestForeground(bool enabled) {
     u64 applicationAruid = 0, appletAruid = 0;
 
-    //logToFile("[Gui] Request foreground\n");
+    //LOG_INFO(Gui, "Request foreground\n");
     Result rc = 0;
     for (u64 programId = 0x0100000000001000UL; programId < 0x0100000000001020UL; programId++) {
         rc = pmdmntGetProcessId(&appletAruid, programId);
-        //logToFile("[Gui] programId=%i, appletAruid=%i, result=%i:%i\n", programId, appletAruid, R_MODULE(rc), R_DESCRIPTION(rc));
+        //LOG_DEBUG(Gui, "programId=%i, appletAruid=%i, result=%i:%i\n", programId, appletAruid, R_MODULE(rc), R_DESCRIPTION(rc));
 
         if (appletAruid != 0) {
             rc = hidsysEnableAppletToGetInput(!enabled, appletAruid);
-            //logToFile("[Gui] hidsysEnableAppletToGetInput -> false, result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            //LOG_DEBUG(Gui, "hidsysEnableAppletToGetInput -> false, result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
         }
     }
 
     rc = pmdmntGetApplicationProcessId(&applicationAruid);
-    //logToFile("[Gui] pmdmntGetApplicationProcessId, applicationAruid=%i, result=%i:%i\n", applicationAruid, R_MODULE(rc), R_DESCRIPTION(rc));
+    //LOG_DEBUG(Gui, "pmdmntGetApplicationProcessId, applicationAruid=%i, result=%i:%i\n", applicationAruid, R_MODULE(rc), R_DESCRIPTION(rc));
     rc = hidsysEnableAppletToGetInput(!enabled, applicationAruid);
-    //logToFile("[Gui] hidsysEnableAppletToGetInput -> false, applicationAruid=%i, result=%i:%i\n", applicationAruid, R_MODULE(rc), R_DESCRIPTION(rc));
+    //LOG_DEBUG(Gui, "hidsysEnableAppletToGetInput -> false, applicationAruid=%i, result=%i:%i\n", applicationAruid, R_MODULE(rc), R_DESCRIPTION(rc));
 
     rc = hidsysEnableAppletToGetInput(true, 0);
-    //logToFile("[Gui] hidsysEnableAppletToGetInput -> true (0), result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+    //LOG_DEBUG(Gui, "hidsysEnableAppletToGetInput -> true (0), result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
 }
 
 void GuiController::initUserInput() {
-    logToFile("[Gui] Initialize user input\n");
-
-    hidInitialize();
-    hidsysInitialize();
+    LOG_INFO(Gui, "Initialize user input\n");
 
     // Allow only Player 1 and handheld mode
     HidNpadIdType id_list[2] = { HidNpadIdType_No1, HidNpadIdType_Handheld };
@@ -308,7 +324,8 @@ void GuiController::verifyUserInput() {
     u64 keysDown = kDown_p1 | kDown_handheld;
 
     if(keysDown != 0) {
-        logToFile("[Gui] keysDown=%i\n", keysDown);
+        // The keys are not logged: the flight recorder would keep the PIN
+        LOG_TRACE(Gui, "PIN key %lu\n", keysDown_.size() + 1);
         keysDown_.push_back(keysDown); 
 
         if(keysDown_.size() == 4) {
@@ -10,14 +10,14 @@ class GuiController {
     public:
         void init();
         void start();
-        void showAuthenticationPanel();
+        void showAuthenticationPanel(const UserData& user);
         void hideAll();
 
     private:
         void showOverlay(u16 width, u16 height, u16 posX, u16 posY);
         void clearScreen(bool ownFrame = true);
+        void buildPanel();
         void refreshPanel();
-        int calculateTextWidth(const std::string& text, int fontSize, bool monospace = false);
         Result hidsysEnableAppletToGetInput(bool enable, u64 aruid);
         void requestForeground(bool enabled);
 
@@ -35,7 +35,8 @@ class GuiController {
             PinVerification,
             PinsDontMatch,
             PinOk,
-            PinError
+            PinError,
+            PinNotSaved
         } PinStage;
 
     private:
@@ -5,9 +5,11 @@
 #include <algorithm>
 #include <switch/types.h>
 #include <unordered_map>
+#include <vector>
 #include <cwctype>
 #include "utils.h"
 #include "logger.h"
+#include "blend.hpp"
 
 #define PACKED __attribute__((packed))
 
@@ -33,6 +35,88 @@ namespace alefbet {
                 constexpr inline Color(u8 r, u8 g, u8 b, u8 a): r(r), g(g), b(b), a(a) {}
             };
 
+            /**
+             * @brief Rectangle of the framebuffer, the end coordinates are excluded
+             */
+            struct Rect {
+                s32 x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+                constexpr bool empty() const { return x0 >= x1 || y0 >= y1; }
+                constexpr u32 area() const { return empty() ? 0 : (x1 - x0) * (y1 - y0); }
+                constexpr bool contains(s32 x, s32 y) const { return x >= x0 && y >= y0 && x < x1 && y < y1; }
+                constexpr bool overlaps(const Rect &other) const { return x0 < other.x1 && other.x0 < x1 && y0 < other.y1 && other.y0 < y1; }
+                constexpr Rect united(const Rect &other) const { return { std::min(x0, other.x0), std::min(y0, other.y0), std::max(x1, other.x1), std::max(y1, other.y1) }; }
+                constexpr Rect intersected(const Rect &other) const { return { std::max(x0, other.x0), std::max(y0, other.y0), std::min(x1, other.x1), std::min(y1, other.y1) }; }
+            };
+
+            constexpr u32 DamageMaxRects = 4;       ///< Rectangles kept per framebuffer, further ones are merged
+
+            /**
+             * @brief Regions of a framebuffer which changed since it was last drawn
+             *
+             * The rectangles never overlap so that no pixel is drawn twice: a rectangle overlapping others is merged
+             * with them, and when all are taken it is merged with the one it grows the least.
+             */
+            struct Damage {
+                Rect rects[DamageMaxRects];
+                u32 count = 0;
+
+                void add(Rect rect) {
+                    if (rect.empty())
+                        return;
+
+                    while (true) {
+                        u32 merged = count;
+
+                        for (u32 i = 0; i < count && merged == count; i++)
+                            if (rects[i].overlaps(rect))
+                                merged = i;
+
+                        if (merged == count && count == DamageMaxRects) {
+                            u32 growth = UINT32_MAX;
+
+                            for (u32 i = 0; i < count; i++) {
+                                const u32 grown = rects[i].united(rect).area() - rects[i].area();
+                                if (grown < growth) {
+                                    growth = grown;
+                                    merged = i;
+                                }
+                            }
+                        }
+
+                        if (merged == count)
+                            break;
+
+                        rect = rect.united(rects[merged]);
+                        rects[merged] = rects[--count];
+                    }
+
+                    rects[count++] = rect;
+                }
+
+                bool overlaps(const Rect &rect) const {
+                    for (u32 i = 0; i < count; i++)
+                        if (rects[i].overlaps(rect))
+                            return true;
+
+                    return false;
+                }
+
+                bool contains(s32 x, s32 y) const {
+                    for (u32 i = 0; i < count; i++)
+                        if (rects[i].contains(x, y))
+                            return true;
+
+                    return false;
+                }
+            };
+
+            struct RendererStats {
+                u64 frames = 0;
+                u64 pixels = 0;                     ///< Pixels written by all frames
+                u64 lastFramePixels = 0;
+            };
+
             class Renderer {
                 public:
                     static Renderer& get() {
@@ -52,8 +136,13 @@ namespace alefbet {
                         FramebufferHeight = height;
                         LayerWidth  = FramebufferWidth;
                         LayerHeight = FramebufferHeight;
+
+                        this->buildOffsetTables();
+
+                        // The content of the framebuffers is unknown
+                        this->invalidateAll();
                         
-                        logToFile("[Renderer] LayerWidth=%i, LayerHeight=%i, LayerPosX=%i, LayerPosY=%i, FramebufferWidth=%i, FramebufferHeight=%i\n", LayerWidth, LayerHeight, LayerPosX, LayerPosY, FramebufferWidth, FramebufferHeight);
+                        LOG_DEBUG(Renderer, "LayerWidth=%i, LayerHeight=%i, LayerPosX=%i, LayerPosY=%i, FramebufferWidth=%i, FramebufferHeight=%i\n", LayerWidth, LayerHeight, LayerPosX, LayerPosY, FramebufferWidth, FramebufferHeight);
 
                         if (this->m_initialized)
                             return;
@@ -76,7 +165,7 @@ namespace alefbet {
                         setExit();
                         smExit();
 
-                        logToFile("[Renderer] Result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+                        LOG_DEBUG(Renderer, "Result=%i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
 
                         this->m_initialized = true;
                     }        
@@ -99,13 +188,15 @@ namespace alefbet {
                      * @param color Color
                      */
                     inline void setPixel(s32 x, s32 y, Color color) {
-                        if (x < 0 || y < 0 || x >= FramebufferWidth || y >= FramebufferHeight)
+                        if (!this->m_clip.contains(x, y))
                             return;
 
                         u32 offset = this->getPixelOffset(x, y);
 
-                        if (offset != UINT32_MAX)
+                        if (offset != UINT32_MAX) {
                             static_cast<Color*>(this->getCurrentFramebuffer())[offset] = color;
+                            this->m_framePixels++;
+                        }
                     }
 
                     /**
@@ -119,7 +210,7 @@ namespace alefbet {
                     inline u8 blendColor(u8 src, u8 dst, u8 alpha) {
                         u8 oneMinusAlpha = 0x0F - alpha;
 
-                        return (dst * alpha + src * oneMinusAlpha) / float(0xF);
+                        return div15(dst * alpha + src * oneMinusAlpha);
                     }
 
                     /**
@@ -130,7 +221,7 @@ namespace alefbet {
                      * @param color Color
                      */
                     inline void setPixelBlendSrc(s32 x, s32 y, Color color) {
-                        if (x < 0 || y < 0 || x >= FramebufferWidth || y >= FramebufferHeight)
+                        if (!this->m_clip.contains(x, y))
                             return;
 
                         u32 offset = this->getPixelOffset(x, y);
@@ -150,6 +241,17 @@ namespace alefbet {
                         this->setPixel(x, y, end);
                     }
 
+                    /**
+                     * @brief Blends a color over a pixel of the framebuffer
+                     *
+                     * @param src Current pixel
+                     * @param color Color drawn over it
+                     * @return Resulting pixel
+                     */
+                    inline Color blendPixelDst(Color src, Color color) {
+                        return blendPixel(src.rgba, color.rgba);
+                    }
+
                     /**
                      * @brief Draws a single destination blended pixel onto the screen
                      *
@@ -158,7 +260,7 @@ namespace alefbet {
                      * @param color Color
                      */
                     inline void setPixelBlendDst(s32 x, s32 y, Color color) {
-                        if (x < 0 || y < 0 || x >= FramebufferWidth || y >= FramebufferHeight)
+                        if (!this->m_clip.contains(x, y))
                             return;
 
                         u32 offset = this->getPixelOffset(x, y);
@@ -167,15 +269,106 @@ namespace alefbet {
                             return;
 
                         Color src((static_cast<u16*>(this->getCurrentFramebuffer()))[offset]);
-                        Color dst(color);
-                        Color end(0);
 
-                        end.r = this->blendColor(src.r, dst.r, dst.a);
-                        end.g = this->blendColor(src.g, dst.g, dst.a);
-                        end.b = this->blendColor(src.b, dst.b, dst.a);
-                        end.a = std::min(dst.a + src.a, 0xF);
+                        this->setPixel(x, y, this->blendPixelDst(src, color));
+                    }
 
-                        this->setPixel(x, y, end);
+                    /**
+                     * @brief Visits the pixels of a rectangle as runs of contiguous pixels, in the order of the swizzled framebuffer
+                     *
+                     * The rectangle is clipped to the damage of the frame. The 16x8 tiles aligned on the GOB grid are 128 contiguous
+                     * pixels (four 64 bytes sectors), they are visited in rows. The lines around them are split in aligned groups of
+                     * 8 contiguous pixels, then single pixels.
+                     *
+                     * @param x X pos
+                     * @param y Y pos
+                     * @param w Width
+                     * @param h Height
+                     * @param func Called with each run and its number of pixels
+                     */
+                    template<typename F>
+                    inline void forEachRun(s32 x, s32 y, s32 w, s32 h, F&& func) {
+                        const Rect rect = { x, y, x + w, y + h };
+
+                        for (u32 i = 0; i < this->m_clip.count; i++) {
+                            const Rect part = rect.intersected(this->m_clip.rects[i]);
+
+                            if (!part.empty())
+                                this->forEachRunIn(part, func);
+                        }
+                    }
+
+                    template<typename F>
+                    inline void forEachRunIn(const Rect &rect, F &func) {
+                        const s32 x0 = rect.x0;
+                        const s32 y0 = rect.y0;
+                        const s32 x1 = rect.x1;
+                        const s32 y1 = rect.y1;
+
+                        Color *framebuffer = static_cast<Color*>(this->getCurrentFramebuffer());
+
+                        auto run = [&](Color *pixels, u32 count) {
+                            func(pixels, count);
+                            this->m_framePixels += count;
+                        };
+
+                        auto span = [&](s32 line, s32 spanX0, s32 spanX1) {
+                            Color *row = framebuffer + this->m_rowOffsets[line];
+
+                            for (s32 spanX = spanX0; spanX < spanX1;) {
+                                if ((spanX & 7) == 0 && spanX + 8 <= spanX1) {
+                                    run(row + this->m_colOffsets[spanX], 8);
+                                    spanX += 8;
+                                } else {
+                                    run(row + this->m_colOffsets[spanX], 1);
+                                    spanX++;
+                                }
+                            }
+                        };
+
+                        // Tiles entirely inside the rectangle
+                        const s32 tileX0 = (x0 + 15) & ~15;
+                        const s32 tileX1 = x1 & ~15;
+                        const s32 tileY0 = (y0 + 7) & ~7;
+                        const s32 tileY1 = y1 & ~7;
+
+                        if (tileX0 >= tileX1 || tileY0 >= tileY1) {
+                            for (s32 line = y0; line < y1; line++)
+                                span(line, x0, x1);
+
+                            return;
+                        }
+
+                        for (s32 line = y0; line < tileY0; line++)
+                            span(line, x0, x1);
+
+                        for (s32 tileY = tileY0; tileY < tileY1; tileY += 8) {
+                            for (s32 tileX = tileX0; tileX < tileX1; tileX += 16)
+                                run(framebuffer + this->getPixelOffset(tileX, tileY), 128);
+
+                            for (s32 line = tileY; line < tileY + 8; line++) {
+                                span(line, x0, tileX0);
+                                span(line, tileX1, x1);
+                            }
+                        }
+
+                        for (s32 line = tileY1; line < y1; line++)
+                            span(line, x0, x1);
+                    }
+
+                    /**
+                     * @brief Fills a rectangle with a color, without blending
+                     *
+                     * @param x X pos
+                     * @param y Y pos
+                     * @param w Width
+                     * @param h Height
+                     * @param color Color
+                     */
+                    inline void fillRect(s32 x, s32 y, s32 w, s32 h, Color color) {
+                        this->forEachRun(x, y, w, h, [color](Color *run, u32 count) {
+                            std::fill_n(run, count, color);
+                        });
                     }
 
                     /**
@@ -188,12 +381,21 @@ namespace alefbet {
                      * @param color Color
                      */
                     inline void drawRect(s32 x, s32 y, s32 w, s32 h, Color color) {
-                        for (s32 x1 = x; x1 < (x + w); x1++)
-                            for (s32 y1 = y; y1 < (y + h); y1++)
-                                this->setPixelBlendDst(x1, y1, color);
+                        // An opaque color replaces the pixels
+                        if (color.a == 0xF) {
+                            this->fillRect(x, y, w, h, color);
+                            return;
+                        }
+
+                        this->forEachRun(x, y, w, h, [color](Color *run, u32 count) {
+                            blendRun(reinterpret_cast<u16*>(run), count, color.rgba);
+                        });
                     }
 
                     void drawCircle(s32 centerX, s32 centerY, u16 radius, bool filled, Color color) {
+                        if (!this->m_clip.overlaps({ centerX - radius, centerY - radius, centerX + radius + 1, centerY + radius + 1 }))
+                            return;
+
                         s32 x = radius;
                         s32 y = 0;
                         s32 radiusError = 0;
@@ -202,23 +404,11 @@ namespace alefbet {
 
                         while (x >= y) {
                             if(filled) {
-                                for (s32 i = centerX - x; i <= centerX + x; i++) {
-                                    s32 y0 = centerY + y;
-                                    s32 y1 = centerY - y;
-                                    s32 x0 = i;
-
-                                    this->setPixelBlendDst(x0, y0, color);
-                                    this->setPixelBlendDst(x0, y1, color);
-                                }
-
-                                for (s32 i = centerX - y; i <= centerX + y; i++) {
-                                    s32 y0 = centerY + x;
-                                    s32 y1 = centerY - x;
-                                    s32 x0 = i;
-
-                                    this->setPixelBlendDst(x0, y0, color);
-                                    this->setPixelBlendDst(x0, y1, color);
-                                }
+                                // Horizontal lines of the disc, blended as runs
+                                this->drawRect(centerX - x, centerY + y, 2 * x + 1, 1, color);
+                                this->drawRect(centerX - x, centerY - y, 2 * x + 1, 1, color);
+                                this->drawRect(centerX - y, centerY + x, 2 * y + 1, 1, color);
+                                this->drawRect(centerX - y, centerY - x, 2 * y + 1, 1, color);
 
                                 y++;
                                 radiusError += yChange;
@@ -259,6 +449,9 @@ namespace alefbet {
                      * @param bmp Pointer to bitmap data
                      */
                     void drawBitmap(s32 x, s32 y, s32 w, s32 h, const u8 *bmp) {
+                        if (!this->m_clip.overlaps({ x, y, x + w, y + h }))
+                            return;
+
                         for (s32 y1 = 0; y1 < h; y1++) {
                             for (s32 x1 = 0; x1 < w; x1++) {
                                 const Color color = { static_cast<u8>(bmp[0] >> 4), static_cast<u8>(bmp[1] >> 4), static_cast<u8>(bmp[2] >> 4), static_cast<u8>(bmp[3] >> 4) };
@@ -351,14 +544,15 @@ namespace alefbet {
 
                                 auto x = currX + glyph->bounds[0];
                                 auto y = currY + glyph->bounds[1];
-                                for (s32 bmpY = 0; bmpY < glyph->height; bmpY++) {
+                                const s32 height = this->m_clip.overlaps({ x, y, x + glyph->width, y + glyph->height }) ? glyph->height : 0;
+                                for (s32 bmpY = 0; bmpY < height; bmpY++) {
                                     for (s32 bmpX = 0; bmpX < glyph->width; bmpX++) {
                                         auto bmpColor = glyph->glyphBmp[glyph->width * bmpY + bmpX] >> 4;
                                         if (bmpColor == 0xF) {
                                             this->setPixel(x + bmpX, y + bmpY, color);
                                         } else if (bmpColor != 0x0) {
                                             Color tmpColor = color;
-                                            tmpColor.a = bmpColor * (float(tmpColor.a) / 0xF);
+                                            tmpColor.a = (bmpColor * tmpColor.a) / 0xF;
                                             this->setPixelBlendDst(x + bmpX, y + bmpY, tmpColor);
                                         }
                                     }
@@ -430,11 +624,54 @@ namespace alefbet {
                         if(!m_initialized) return;
                         this->m_currentFramebuffer = framebufferBegin(&this->m_framebuffer, nullptr);
                         //this->fillScreen({ 0x00, 0x00, 0x00, 0x00 });
+
+                        // Only the regions which changed since this framebuffer was last drawn are drawn again
+                        Damage &damage = this->m_damage[this->getCurrentFramebufferSlot()];
+                        this->m_clip = damage;
+                        this->m_framePixels = 0;
+                        damage = Damage();
+                    }
+
+                    /**
+                     * @brief Marks a region as changed, it is redrawn in every framebuffer by the next frames
+                     *
+                     * @param x X pos
+                     * @param y Y pos
+                     * @param w Width
+                     * @param h Height
+                     */
+                    void invalidate(s32 x, s32 y, s32 w, s32 h) {
+                        const Rect rect = Rect{ x, y, x + w, y + h }.intersected({ 0, 0, FramebufferWidth, FramebufferHeight });
+
+                        for (auto &damage : this->m_damage)
+                            damage.add(rect);
+                    }
+
+                    void invalidateAll() {
+                        this->invalidate(0, 0, FramebufferWidth, FramebufferHeight);
+                    }
+
+                    /**
+                     * @brief Whether a region is drawn by the current frame
+                     */
+                    bool isDamaged(const Rect &rect) const {
+                        return this->m_clip.overlaps(rect);
+                    }
+
+                    const RendererStats& stats() const {
+                        return this->m_stats;
                     }
 
                     inline void fillScreen(Color color) {
                         if(!m_initialized) return;
-                        std::fill_n(static_cast<Color*>(this->getCurrentFramebuffer()), this->getFramebufferSize() / sizeof(Color), color);
+
+                        // A fully damaged frame is filled at once, including the alignment padding
+                        if (this->m_clip.count == 1 && this->m_clip.rects[0].area() == static_cast<u32>(FramebufferWidth * FramebufferHeight)) {
+                            std::fill_n(static_cast<Color*>(this->getCurrentFramebuffer()), this->getFramebufferSize() / sizeof(Color), color);
+                            this->m_framePixels += FramebufferWidth * FramebufferHeight;
+                        } else {
+                            this->fillRect(0, 0, FramebufferWidth, FramebufferHeight, color);
+                        }
                     }
 
                     inline void clearScreen() {
@@ -442,6 +679,16 @@ namespace alefbet {
                         this->fillScreen({ 0x00, 0x00, 0x00, 0x00 });
                     }
 
+                    /**
+                     * @brief Clears the screen and draws a background over the whole of it, in a single pass
+                     *
+                     * @param background Background color, blended over the cleared screen
+                     */
+                    inline void clearScreen(Color background) {
+                        if(!m_initialized) return;
+                        this->fillScreen(this->blendPixelDst({ 0x00, 0x00, 0x00, 0x00 }, background));
+                    }
+
                     inline void endFrame() {
                         if(!m_initialized) return;
                         
@@ -449,6 +696,12 @@ namespace alefbet {
                         framebufferEnd(&this->m_framebuffer);
 
                         this->m_currentFramebuffer = nullptr;
+                        this->m_clip = Damage();
+
+                        this->m_stats.frames++;
+                        this->m_stats.pixels += this->m_framePixels;
+                        this->m_stats.lastFramePixels = this->m_framePixels;
+                        LOG_DEBUG(Renderer, "Frame %lu: %lu pixels drawn\n", this->m_stats.frames, this->m_framePixels);
                     }
 
                     static void setOpacity(float opacity) {
@@ -464,7 +717,7 @@ namespace alefbet {
                      * @param y Y Pos
                      * @return Offset
                      */
-                    u32 getPixelOffset(s32 x, s32 y) {
+                    inline u32 getPixelOffset(s32 x, s32 y) {
                         /*if (!this->m_scissoringStack.empty()) {
                             auto currScissorConfig = this->m_scissoringStack.top();
                             if (x < currScissorConfig.x ||
@@ -474,32 +727,27 @@ namespace alefbet {
                                     return UINT32_MAX;
                         }*/
 
-                        u32 tmpPos = ((y & 127) / 16) + (x / 32 * 8) + ((y / 16 / 8) * (((FramebufferWidth / 2) / 16 * 8)));
-                        tmpPos *= 16 * 16 * 4;
-
-                        tmpPos += ((y % 16) / 8) * 512 + ((x % 32) / 16) * 256 + ((y % 8) / 2) * 64 + ((x % 16) / 8) * 32 + (y % 2) * 16 + (x % 8) * 2;
-
-                        return tmpPos / 2;
+                        return this->m_rowOffsets[y] + this->m_colOffsets[x];
                     }
 
                     void exit() {
                         if (!this->m_initialized)
                             return;
 
-                        logToFile("[Renderer] exit\n");
+                        LOG_TRACE(Renderer, "exit\n");
                         framebufferClose(&this->m_framebuffer);
-                        logToFile("[Renderer] fb closed\n");
+                        LOG_TRACE(Renderer, "fb closed\n");
                         nwindowClose(&this->m_window);
-                        logToFile("[Renderer] window closed\n");
+                        LOG_TRACE(Renderer, "window closed\n");
                         //viDestroyManagedLayer(&this->m_layer);
                         Result rc = viCloseLayer(&this->m_layer);
-                        logToFile("[Renderer] layer closed %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+                        LOG_TRACE(Renderer, "layer closed %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
                         rc = viCloseDisplay(&this->m_display);
-                        logToFile("[Renderer] display closed %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+                        LOG_TRACE(Renderer, "display closed %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
                         eventClose(&this->m_vsyncEvent);
-                        logToFile("[Renderer] event closed\n");
+                        LOG_TRACE(Renderer, "event closed\n");
                         viExit();
-                        logToFile("[Renderer] vi closed\n");
+                        LOG_TRACE(Renderer, "vi closed\n");
                         this->m_initialized = false;
                     }
 
@@ -513,6 +761,29 @@ namespace alefbet {
                         return serviceDispatchIn(viGetSession_IManagerDisplayService(), 6000, in);
                     }
 
+                    /**
+                     * @brief Precomputes the block-linear addressing of the framebuffer
+                     *
+                     * The swizzled offset of a pixel is the sum of a part which only depends on its row
+                     * (block row, GOB and line within the GOB) and a part which only depends on its column
+                     * (block, half GOB and 8 pixels group), each part being looked up instead of computed.
+                     */
+                    void buildOffsetTables() {
+                        if (this->m_colOffsets.size() == FramebufferWidth && this->m_rowOffsets.size() == FramebufferHeight)
+                            return;
+
+                        // Blocks are 32 pixels wide and 128 lines high (16 GOBs of 64 bytes x 8 lines), 8 KB each
+                        const u32 blockRowStride = (FramebufferWidth / 2) / 16 * 8;
+
+                        this->m_colOffsets.resize(FramebufferWidth);
+                        for (u32 x = 0; x < FramebufferWidth; x++)
+                            this->m_colOffsets[x] = ((x / 32 * 8) * 16 * 16 * 4 + ((x % 32) / 16) * 256 + ((x % 16) / 8) * 32 + (x % 8) * 2) / 2;
+
+                        this->m_rowOffsets.resize(FramebufferHeight);
+                        for (u32 y = 0; y < FramebufferHeight; y++)
+                            this->m_rowOffsets[y] = ((((y & 127) / 16) + (y / 16 / 8) * blockRowStride) * 16 * 16 * 4 + ((y % 16) / 8) * 512 + ((y % 8) / 2) * 64 + (y % 2) * 16) / 2;
+                    }
+
                     inline void* getCurrentFramebuffer() {
                         return this->m_currentFramebuffer;
                     }
@@ -638,27 +909,27 @@ namespace alefbet {
                         if (!fb || !fb->has_init)
                             return;
 
-                        logToFile("1\n");
+                        LOG_TRACE(Renderer, "1\n");
                         if (fb->buf_linear)
                             free(fb->buf_linear);
 
                         if (fb->buf) {                            
                             nwindowReleaseBuffers(fb->win);
-                            logToFile("2\n");
+                            LOG_TRACE(Renderer, "2\n");
                             nvMapClose(&fb->map);
-                            logToFile("3\n");
+                            LOG_TRACE(Renderer, "3\n");
                             free(fb->buf);
-                            logToFile("4\n");
+                            LOG_TRACE(Renderer, "4\n");
                         }
 
                         memset(fb, 0, sizeof(*fb));
-                        logToFile("5\n");
+                        LOG_TRACE(Renderer, "5\n");
                         nvFenceExit();
-                        logToFile("6\n");
+                        LOG_TRACE(Renderer, "6\n");
                         nvMapExit();
-                        logToFile("7\n");
+                        LOG_TRACE(Renderer, "7\n");
                         nvExit();
-                        logToFile("8\n");
+                        LOG_TRACE(Renderer, "8\n");
                     }*/
 
                 private:
@@ -680,6 +951,14 @@ namespace alefbet {
                     NWindow m_window;
                     Framebuffer m_framebuffer;
                     void *m_currentFramebuffer = nullptr;
+                    std::vector<u32> m_rowOffsets;      ///< Offset of the first pixel of each line, in pixels
+                    std::vector<u32> m_colOffsets;      ///< Offset of each column within its line, in pixels
+
+                    static constexpr u32 MaxFramebuffers = 3;
+                    Damage m_damage[MaxFramebuffers];   ///< Regions to draw again, per framebuffer slot
+                    Damage m_clip;                      ///< Regions drawn by the current frame
+                    u64 m_framePixels = 0;
+                    RendererStats m_stats;
             };
 
         }
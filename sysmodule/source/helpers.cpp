@@ -5,17 +5,21 @@
 #include <iostream>
 #include <vector>
 #include <string_view>
-#include <ranges>
+#include <charconv>
 #include <codecvt>
 #include <switch.h>
 #include "logger.h"
+#include "service_manager.h"
+#include "sd_card.h"
+#include "profile_table.h"
+#include "title_cache.h"
 #ifdef CAN_REBOOT_TO_PAYLOAD
 #include "ams_bpc.h"
 #endif
 
 using namespace alefbet::authenticator::logger;
 using namespace alefbet::authenticator::structs;
-using std::operator""sv;
+using namespace alefbet::authenticator::services;
 
 namespace alefbet::authenticator::helpers {    
 
@@ -33,123 +37,55 @@ namespace alefbet::authenticator::helpers {
         return std::to_string(uid.uid[0]) + ":" + std::to_string(uid.uid[1]);
     }
 
-    AccountUid accountUidFromString(const UserUid& uid_str) {
-        AccountUid uid;
+    bool parseAccountUid(std::string_view uid_str, AccountUid& uid) {
+        const auto separator = uid_str.find(':');
+        if(separator == std::string_view::npos) return false;
 
-        std::vector<std::string> parts;
-        for (const auto part : std::views::split(uid_str, ":"sv)) {
-            parts.push_back(std::string(part.begin(), part.end()));
-        }
-        
-        if(parts.size() != 2) {
-            logToFile("[Helpers] Incorrect split of AccountUid %s.\n", uid_str.c_str());
-            return uid;
-        }
+        const char* first = uid_str.data();
+        const char* middle = first + separator;
+        const char* last = first + uid_str.size();
 
-        uid.uid[0] = std::stoull(parts[0]);
-        uid.uid[1] = std::stoull(parts[1]);
+        const auto& high = std::from_chars(first, middle, uid.uid[0]);
+        const auto& low = std::from_chars(middle + 1, last, uid.uid[1]);
 
-        return uid;
+        return high.ec == std::errc() && high.ptr == middle && low.ec == std::errc() && low.ptr == last;
     }
 
-    UserData getUserFromAccountUid(AccountUid uid) {
-        UserData user;
-
-        ::Result rc = accountInitialize(AccountServiceType_Administrator);
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not initialize account service: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
-            user.nickname = UserNickname("ERR#003");
-            return user;
-        }
-
-        AccountProfile profile;
-        AccountUserData user_data;
-        AccountProfileBase base;
-        rc = accountGetProfile(&profile, uid); 
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get account profile: %i\n", rc);
-            accountExit();
-            user.nickname = UserNickname("ERR#005");
-            return user;
-        } else {
-            logToFile("[Helpers] accountGetProfile() ok\n");
-        }
+    AccountUid accountUidFromString(const UserUid& uid_str) {
+        AccountUid uid = {};
 
-        rc = accountProfileGet(&profile, &user_data, &base);
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get user data: %i\n", rc);
-            accountProfileClose(&profile);
-            accountExit();
-            user.nickname = UserNickname("ERR#006");
-            return user;
-        } else {
-            logToFile("[Helpers] accountProfileGet() ok\n");
+        if(!parseAccountUid(uid_str, uid)) {
+            LOG_ERROR(Helpers, "Incorrect split of AccountUid %s.\n", uid_str.c_str());
+            return AccountUid{};
         }
-        
-        user.uid = uid;
-        user.nickname = UserNickname(base.nickname);
-        UserUid uidstr = accountUidToString(uid);
-        //logToFile("[Helpers] uid=%s, Nickname=%s\n", uidstr.c_str(), user.nickname.c_str());
 
-        accountProfileClose(&profile);
-        accountExit();
+        return uid;
+    }
 
-        return user;
+    UserData getUserFromAccountUid(AccountUid uid) {
+        return ProfileTable::get().find(uid);
     }
 
     UserData getCurrentUser() {
         UserData user;
 
-        ::Result rc = accountInitialize(AccountServiceType_Administrator);
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not initialize account service: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        ServiceSession account(Account);
+        if(!account.ready()) {
+            LOG_ERROR(Helpers, "Could not initialize account service\n");
             user.nickname = UserNickname("ERR#003");
             return user;
         }
 
         AccountUid uid;
-        rc = accountGetPreselectedUser(&uid);
-        //logToFile("rc=%i, Uid=%i.%i\n", rc, uid.uid[0], uid.uid[1]);
-        rc = accountGetLastOpenedUser(&uid);            
+        ::Result rc = account.call([&] { return accountGetLastOpenedUser(&uid); });
         if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get preselected user: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
-            accountExit();
+            LOG_ERROR(Helpers, "Could not get preselected user: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
             user.nickname = UserNickname("ERR#004");
             return user;
         }
 
-        logToFile("[Helpers] user uid: %i.%i\n", uid.uid[0], uid.uid[1]);
-        user.uid = uid;
-
-        AccountProfile profile;
-        AccountUserData user_data;
-        AccountProfileBase base;
-        rc = accountGetProfile(&profile, uid); 
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get account profile: %i\n", rc);
-            accountExit();
-            user.nickname = UserNickname("ERR#005");
-            return user;
-        } /*else {
-            logToFile("[Helpers] accountGetProfile() ok\n");
-        }*/
-
-        rc = accountProfileGet(&profile, &user_data, &base);
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get user data: %i\n", rc);
-            accountProfileClose(&profile);
-            accountExit();
-            user.nickname = UserNickname("ERR#006");
-            return user;
-        } /*else {
-            logToFile("[Helpers] accountProfileGet() ok\n");
-        }*/
-        
-        user.nickname = UserNickname(base.nickname);
-        logToFile("[Helpers] uid=%i:%i, Nickname=%s\n", user.uid.uid[0], user.uid.uid[1], user.nickname.c_str());
-
-        accountProfileClose(&profile);
-        accountExit();
+        user = ProfileTable::get().find(uid);
+        LOG_TRACE(Helpers, "uid=%i:%i, Nickname=%s\n", user.uid.uid[0], user.uid.uid[1], user.nickname.c_str());
 
         return user;
     }
@@ -159,11 +95,11 @@ namespace alefbet::authenticator::helpers {
 
         ::Result rc = pmdmntGetApplicationProcessId(&process_id);
         if(R_FAILED(rc)) {
-            //logToFile("[Helpers] Could not get application process ID: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            //LOG_ERROR(Helpers, "Could not get application process ID: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
             return 0;
         }
 
-        //logToFile("[Helpers] process ID=%i\n", process_id);
+        //LOG_DEBUG(Helpers, "process ID=%i\n", process_id);
 
         return process_id;
     }
@@ -173,51 +109,39 @@ namespace alefbet::authenticator::helpers {
 
         ::Result rc = pmdmntGetProgramId(&title_id, process_id);
         if(R_FAILED(rc)) {
-            //logToFile("[Helpers] Could not get the title ID for the process %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            //LOG_ERROR(Helpers, "Could not get the title ID for the process %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
             return 0;
         }
         
         auto formatted_title_id = titleIdToString(title_id);
-        //logToFile("[Helpers] title formatted ID=%s, ID=%i, pid=%i\n", formatted_title_id.c_str(), title_id, process_id);
+        //LOG_DEBUG(Helpers, "title formatted ID=%s, ID=%i, pid=%i\n", formatted_title_id.c_str(), title_id, process_id);
 
         return title_id;
     }
 
     std::string getApplicationName(u64 title_id) {
-        NsApplicationControlData control;
-        u64 actual_size = 0;
-        
-        ::Result rc = nsGetApplicationControlData(NsApplicationControlSource_Storage, title_id, std::addressof(control), sizeof(control), &actual_size);
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get application control data for title %s\n", titleIdToString(title_id));
-            return "Unknown";
-        }
-
-        NacpLanguageEntry* langEntry = nullptr;
-        rc = nacpGetLanguageEntry(&control.nacp, &langEntry);
-
-        return std::string(langEntry->name);
+        return TitleCache::get().name(title_id);
     }
 
     std::string today() {        
-        ::Result rc = timeInitialize();
-        if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not connect to time service\n");
+        ServiceSession timeService(Time);
+        if(!timeService.ready()) {
+            LOG_ERROR(Helpers, "Could not connect to time service\n");
             return "";
         }
 
         u64 ts;
         TimeCalendarTime time;
         TimeCalendarAdditionalInfo info;
-        rc = timeGetCurrentTime(TimeType_LocalSystemClock, &ts);        
+        ::Result rc = timeService.call([&] { return timeGetCurrentTime(TimeType_LocalSystemClock, &ts); });        
         if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not get current time (err %i:%i)\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            LOG_ERROR(Helpers, "Could not get current time (err %i:%i)\n", R_MODULE(rc), R_DESCRIPTION(rc));
             return "";
         }
 
         rc = timeToCalendarTimeWithMyRule(ts, &time, &info);
         if(R_FAILED(rc)) {
-            logToFile("[Helpers] Could not convert timestamp\n");
+            LOG_ERROR(Helpers, "Could not convert timestamp\n");
             return "";
         }
         
@@ -235,7 +159,7 @@ namespace alefbet::authenticator::helpers {
         std::string pin;
 
         if(password.size() != 4) {
-            logToFile("[Helpers] The PIN size is wrong.");
+            LOG_ERROR(Helpers, "The PIN size is wrong.");
             return pin;
         }
 
@@ -245,89 +169,79 @@ namespace alefbet::authenticator::helpers {
     }
 
 #ifdef CAN_REBOOT_TO_PAYLOAD
-    static FsFileSystem sdmc;
-    
+    constexpr const char* PayloadFilename = "/atmosphere/reboot_payload.bin";
+
     bool readPayloadFile(u8* buffer, u64 buffer_size) {
-        FsFile handle;
-        
-        ::Result res = fsOpenSdCardFileSystem(&sdmc);
-        if(R_FAILED(res)) {
-            logToFile("[Helpers] Could not open SDMC\n");
-            return false;
-        }
+        auto& sdcard = services::SdCard::get();
 
-        res = fsFsOpenFile(&sdmc, "/atmosphere/reboot_payload.bin", FsOpenMode_Read, &handle);
-        if(R_FAILED(res)) {
-            logToFile("[Helpers] Could not open payload file\n");
+        if(!sdcard.ready()) {
+            LOG_ERROR(Helpers, "Could not open SDMC\n");
             return false;
         }
 
         s64 fileSize = 0;
-        res = fsFileGetSize(&handle, &fileSize);
+        ::Result res = sdcard.getSize(PayloadFilename, &fileSize);
         if(R_FAILED(res)) {
-            logToFile("[Helpers] Could not get file size\n");
-            fsFileClose(&handle);
+            LOG_ERROR(Helpers, "Could not open payload file\n");
             return false;
         }
 
-        logToFile("[Helpers] Payload file size is %i bytes\n", fileSize);
+        LOG_INFO(Helpers, "Payload file size is %i bytes\n", fileSize);
 
         u64 dataRead = 0;
-        res = fsFileRead(&handle, 0, buffer, buffer_size, FsReadOption_None, &dataRead);
+        res = sdcard.read(PayloadFilename, 0, buffer, buffer_size, &dataRead);
+        sdcard.close(PayloadFilename);
         if(R_FAILED(res)) {
-            logToFile("[Helpers] Could not read %i bytes from payload file\n", buffer_size);
-            fsFileClose(&handle);
+            LOG_ERROR(Helpers, "Could not read %i bytes from payload file\n", buffer_size);
             return false;
         }
 
-        fsFileClose(&handle);
-
-        logToFile("[Helpers] Read %i bytes from payload file\n", dataRead);
+        LOG_INFO(Helpers, "Read %i bytes from payload file\n", dataRead);
         return true;
     }
 
     #define IRAM_PAYLOAD_MAX_SIZE 0x24000
     //static u8 g_reboot_payload[IRAM_PAYLOAD_MAX_SIZE];
     bool rebootToPayload() {
-        logToFile("[Helpers] Try to reboot to payload\n");
+        LOG_INFO(Helpers, "Try to reboot to payload\n");
       
         u8 *g_reboot_payload = new u8[IRAM_PAYLOAD_MAX_SIZE];
         smInitialize();
         if(!readPayloadFile(g_reboot_payload, IRAM_PAYLOAD_MAX_SIZE)) {
-            logToFile("[Helpers] No payload, shutting down.");
+            LOG_WARN(Helpers, "No payload, shutting down.");
             bpcShutdownSystem();
             return false;
         }
 
-        logToFile("1\n");
+        LOG_TRACE(Helpers, "1\n");
         ::Result rc = spsmInitialize();        
         if(R_FAILED(rc)) {
-            logToFile("[Helpers] Failed to initialize SPSM\n");
+            LOG_ERROR(Helpers, "Failed to initialize SPSM\n");
             bpcShutdownSystem();
             return false;
         }
-        logToFile("2\n");
+        LOG_TRACE(Helpers, "2\n");
         
         smExit(); //Required to connect to ams:bpc       
-        logToFile("3\n");
+        LOG_TRACE(Helpers, "3\n");
 
         rc = amsBpcInitialize();
         if (R_FAILED(rc)) {
-            logToFile("[Helpers] Failed to initialize ams:bpc: %i\n", rc);
-            logToFile("[Helpers] Shutting down.\n");
+            LOG_ERROR(Helpers, "Failed to initialize ams:bpc: %i\n", rc);
+            LOG_INFO(Helpers, "Shutting down.\n");
             bpcShutdownSystem();
             return false;
         }
-        logToFile("4\n");        
+        LOG_TRACE(Helpers, "4\n");        
 
-        logToFile("[Helpers] Calling amsBpcSetRebootPayload\n");        
+        LOG_DEBUG(Helpers, "Calling amsBpcSetRebootPayload\n");        
         if (R_FAILED(amsBpcSetRebootPayload(g_reboot_payload, IRAM_PAYLOAD_MAX_SIZE))) {
-            logToFile("[Helpers] Failed to set reboot to payload: %i\n", rc);
-            logToFile("[Helpers] Shutting down.\n");
+            LOG_ERROR(Helpers, "Failed to set reboot to payload: %i\n", rc);
+            LOG_INFO(Helpers, "Shutting down.\n");
 
             bpcShutdownSystem();
         } else {
-            logToFile("[Helpers] Rebooting to payload\n");
+            LOG_INFO(Helpers, "Rebooting to payload\n");
 
             spsmShutdown(true);
         }
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <switch.h>
 #include <vector>
 
@@ -33,9 +34,22 @@ namespace alefbet::authenticator {
     }
 
     namespace helpers {        
+        struct AccountUidHash {
+            size_t operator()(const AccountUid& uid) const {
+                return static_cast<size_t>(uid.uid[0] ^ (uid.uid[1] * 0x9E3779B97F4A7C15ULL));
+            }
+        };
+
+        struct AccountUidEqual {
+            bool operator()(const AccountUid& a, const AccountUid& b) const {
+                return a.uid[0] == b.uid[0] && a.uid[1] == b.uid[1];
+            }
+        };
+
         std::string titleIdToString(u64 titleId);
         UserUid accountUidToString(AccountUid uid);
         AccountUid accountUidFromString(const UserUid& uid);
+        bool parseAccountUid(std::string_view uid_str, AccountUid& uid);
 
         structs::UserData getCurrentUser();
         structs::UserData getUserFromAccountUid(AccountUid uid);
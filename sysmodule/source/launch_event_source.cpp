@@ -0,0 +1,124 @@
+#include "launch_event_source.h"
+#include "logger.h"
+
+using namespace alefbet::authenticator::logger;
+
+// Hook types used by pm:dmnt ClearHook
+constexpr u32 PmHookType_Application = BIT(1);
+
+/* Lookups of the pid of a hooked application, which pm may not have registered yet */
+constexpr u32 ProcessIdAttempts = 10;
+constexpr s64 ProcessIdRetryNs = 5'000'000;
+
+namespace alefbet::authenticator::srv {
+
+    static bool applicationProcessId(u64& pid) {
+        for(u32 attempt = 0; attempt < ProcessIdAttempts; attempt++) {
+            if(attempt > 0) svcSleepThread(ProcessIdRetryNs);
+
+            if(R_SUCCEEDED(pmdmntGetApplicationProcessId(&pid)) && pid != 0) return true;
+        }
+
+        pid = 0;
+        return false;
+    }
+
+    PmLaunchEventSource::PmLaunchEventSource() {
+        ueventCreate(&interrupt_, true);
+    }
+
+    bool PmLaunchEventSource::open() {
+        if(hooked_) return true;
+        if(!MONITOR_LAUNCH_HOOK) return false;
+
+        return hook();
+    }
+
+    void PmLaunchEventSource::close() {
+        if(!hooked_) return;
+
+        if(hosversionAtLeast(6,0,0)) {
+            pmdmntClearHook(PmHookType_Application);
+        }
+
+        eventClose(&event_);
+        hooked_ = false;
+    }
+
+    bool PmLaunchEventSource::hook() {
+        ::Result rc = pmdmntHookToCreateApplicationProcess(&event_);
+        if(R_FAILED(rc)) {
+            // Most likely held by another process (dmnt), the monitor polls in the meantime
+            if(hookFailures_++ == 0) {
+                LOG_ERROR(Monitor, "Could not hook application creation: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            } else {
+                LOG_DEBUG(Monitor, "Could not hook application creation (%u failures)\n", hookFailures_);
+            }
+            hooked_ = false;
+            return false;
+        }
+
+        if(hookFailures_ > 0) {
+            LOG_INFO(Monitor, "Application creation hooked after %u failures\n", hookFailures_);
+            hookFailures_ = 0;
+        }
+        hooked_ = true;
+        return true;
+    }
+
+    LaunchEvent PmLaunchEventSource::wait(s64 timeoutNs) {
+        LaunchEvent event;
+
+        if(!hooked_) {
+            event.type = LaunchEvent::Failed;
+            return event;
+        }
+
+        s32 index = -1;
+        ::Result rc = waitMulti(&index, timeoutNs < 0 ? UINT64_MAX : static_cast<u64>(timeoutNs), waiterForEvent(&event_), waiterForUEvent(&interrupt_));
+        event.tick = armGetSystemTick();
+
+        if(R_FAILED(rc)) {
+            if(R_VALUE(rc) != KERNELRESULT(TimedOut)) {
+                LOG_ERROR(Monitor, "Waiting for launch event failed: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+                event.type = LaunchEvent::Failed;
+            }
+            return event;
+        }
+
+        if(index != 0) return event;
+
+        event.type = LaunchEvent::Launched;
+
+        // The process has been created but not started yet
+        applicationProcessId(event.pid);
+
+        return event;
+    }
+
+    void PmLaunchEventSource::interrupt() {
+        ueventSignal(&interrupt_);
+    }
+
+    void PmLaunchEventSource::acknowledge(LaunchEvent& event) {
+        if(event.type != LaunchEvent::Launched) return;
+
+        // The hooked application stays suspended until it is explicitly started
+        if(event.pid == 0 && !applicationProcessId(event.pid)) {
+            LOG_ERROR(Monitor, "The launched application could not be found, it cannot be started\n");
+        }
+
+        if(event.pid != 0) {
+            ::Result rc = pmdmntStartProcess(event.pid);
+            if(R_FAILED(rc)) {
+                LOG_ERROR(Monitor, "Could not start process %li: %i:%i\n", event.pid, R_MODULE(rc), R_DESCRIPTION(rc));
+            }
+        }
+
+        // pm returns the same event each time, so drop our copy before hooking again
+        eventClose(&event_);
+        hooked_ = false;
+        hook();
+    }
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <switch.h>
+
+/* Hooks the application launches through pm:dmnt, 0 leaves the hook to Atmosphère's cheat manager and
+   polls instead (make DEFINES="-DMONITOR_LAUNCH_HOOK=0") */
+#ifndef MONITOR_LAUNCH_HOOK
+#define MONITOR_LAUNCH_HOOK 1
+#endif
+
+namespace alefbet::authenticator::srv {
+
+    /*! \brief Describes what woke up the monitor thread.
+    */
+    struct LaunchEvent {
+        typedef enum {
+            None,           ///< The wait timed out, nothing happened
+            Launched,       ///< An application process has been created
+            Failed          ///< The event source is not usable anymore
+        } Type;
+
+        Type type = None;   ///< None is also returned by a wait() that was interrupted
+        u64 pid = 0;        ///< Process ID of the launched application (0 if unknown)
+        u64 tick = 0;       ///< System tick at which the event has been observed
+    };
+
+    /*! \brief Source of application launch events used by the monitor.
+
+        The monitor blocks on this interface instead of sleeping between polls, so any
+        implementation (process manager hook, scripted stand-in...) can drive the same loop.
+    */
+    class LaunchEventSource {
+        public:
+            virtual ~LaunchEventSource() = default;
+
+            /*! \brief Starts listening for launches. Returns false if the source is unavailable. */
+            virtual bool open() = 0;
+
+            /*! \brief Stops listening and releases the underlying resources. */
+            virtual void close() = 0;
+
+            /*! \brief Blocks until a launch happens or \p timeoutNs expires. */
+            virtual LaunchEvent wait(s64 timeoutNs) = 0;
+
+            /*! \brief Makes the pending or the next wait() return, from another thread. */
+            virtual void interrupt() = 0;
+
+            /*! \brief Releases the launched process (if needed) and waits for the next launch.
+                The pid of the event is filled if it was not known yet.
+            */
+            virtual void acknowledge(LaunchEvent& event) = 0;
+    };
+
+    /*! \brief Launch events coming from the process manager (pm:dmnt).
+
+        The application hook is one-shot: pm signals the event when the application process is
+        created and leaves it suspended until pmdmntStartProcess() is called. acknowledge() starts
+        the process and re-arms the hook for the next launch. The process may not be registered
+        yet when the event is signaled, its pid is looked up again before giving up on it.
+
+        pm only hands the hook to one process at a time, and dmnt's cheat manager also takes it when
+        it runs: whoever hooks first gets the launches, open() fails for the other one. Between a
+        launch and its re-arming the hook is free, so the two may swap it, which dmnt does not expect:
+        it re-hooks unconditionally. Builds that must not compete with dmnt set MONITOR_LAUNCH_HOOK to 0.
+    */
+    class PmLaunchEventSource : public LaunchEventSource {
+        public:
+            PmLaunchEventSource();
+
+            bool open() override;
+            void close() override;
+            LaunchEvent wait(s64 timeoutNs) override;
+            void interrupt() override;
+            void acknowledge(LaunchEvent& event) override;
+
+        private:
+            bool hook();
+
+        private:
+            Event event_ = {};
+            UEvent interrupt_;
+            bool hooked_ = false;
+            u32 hookFailures_ = 0;          ///< Consecutive failures, only the first one is reported
+    };
+
+}
@@ -0,0 +1,172 @@
+#include "log_compress.h"
+#include "sd_card.h"
+#include <cstdlib>
+#include <cstring>
+
+constexpr size_t BlockSize = 16 * 1024;
+constexpr size_t BlockCapacity = BlockSize + BlockSize / 255 + 16;
+constexpr u32 HashBits = 12;
+constexpr size_t MinMatch = 4;
+constexpr size_t LastLiterals = 5;          ///< The block must end with literals
+constexpr size_t MatchSafeDistance = 12;    ///< No match may start this close to the end
+constexpr u32 FrameMagic = 0x184D2204;
+constexpr u8 FrameFlags = 0x60;             ///< Version 1, independent blocks, no checksums
+constexpr u8 FrameBlockMaxSize = 0x40;      ///< 64 KB
+constexpr u32 UncompressedBlock = 0x80000000;
+
+namespace alefbet::authenticator::logger {
+
+    static u32 read32(const u8* p) {
+        u32 value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static u32 hashOf(u32 sequence) {
+        return (sequence * 2654435761u) >> (32 - HashBits);
+    }
+
+    static u8* writeLength(u8* out, size_t length) {
+        for(; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = static_cast<u8>(length);
+        return out;
+    }
+
+    size_t compressBlock(const u8* src, size_t size, u8* dst, size_t capacity) {
+        if(capacity < BlockCapacity || size > BlockSize) return 0;
+
+        // 8 KB, too much for the stack of the flusher (the only caller): stored once and cleared per block
+        static u16 table[1 << HashBits];
+        std::memset(table, 0, sizeof(table));
+        const u8* anchor = src;
+        const u8* end = src + size;
+        const u8* matchLimit = size > MatchSafeDistance ? end - MatchSafeDistance : src;
+        u8* out = dst;
+
+        for(const u8* ip = src + 1; ip < matchLimit;) {
+            const u32 hash = hashOf(read32(ip));
+            const u8* ref = src + table[hash];
+            table[hash] = static_cast<u16>(ip - src);
+
+            if(ref >= ip || ip - ref > 0xFFFF || read32(ref) != read32(ip)) {
+                ip++;
+                continue;
+            }
+
+            size_t matchLength = MinMatch;
+            while(ip + matchLength < end - LastLiterals && ref[matchLength] == ip[matchLength]) {
+                matchLength++;
+            }
+
+            const size_t literals = ip - anchor;
+            u8* token = out++;
+            *token = static_cast<u8>((literals >= 15 ? 15 : literals) << 4);
+            if(literals >= 15) out = writeLength(out, literals - 15);
+            std::memcpy(out, anchor, literals);
+            out += literals;
+
+            const u16 offset = static_cast<u16>(ip - ref);
+            *out++ = static_cast<u8>(offset);
+            *out++ = static_cast<u8>(offset >> 8);
+
+            const size_t extra = matchLength - MinMatch;
+            *token |= static_cast<u8>(extra >= 15 ? 15 : extra);
+            if(extra >= 15) out = writeLength(out, extra - 15);
+
+            ip += matchLength;
+            anchor = ip;
+        }
+
+        const size_t literals = end - anchor;
+        *out++ = static_cast<u8>((literals >= 15 ? 15 : literals) << 4);
+        if(literals >= 15) out = writeLength(out, literals - 15);
+        std::memcpy(out, anchor, literals);
+        out += literals;
+
+        return out - dst;
+    }
+
+    /* XXH32 of a short buffer (< 16 bytes), for the frame header checksum */
+    static u32 xxh32Short(const u8* data, size_t size) {
+        constexpr u32 Prime1 = 2654435761u, Prime2 = 2246822519u, Prime3 = 3266489917u, Prime5 = 374761393u;
+        auto rotl = [](u32 x, int r) { return (x << r) | (x >> (32 - r)); };
+
+        u32 hash = Prime5 + static_cast<u32>(size);
+        for(size_t i = 0; i < size; i++) {
+            hash += data[i] * Prime5;
+            hash = rotl(hash, 11) * Prime1;
+        }
+
+        hash ^= hash >> 15;
+        hash *= Prime2;
+        hash ^= hash >> 13;
+        hash *= Prime3;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    bool compressFile(const char* src, const char* dst, CompressStats* stats) {
+        auto& sdcard = services::SdCard::get();
+
+        sdcard.deleteFile(dst);
+        if(R_FAILED(sdcard.createFile(dst, 0))) return false;
+
+        u8* buffer = static_cast<u8*>(malloc(BlockSize + sizeof(u32) + BlockCapacity));
+        if(buffer == nullptr) return false;
+        u8* block = buffer + BlockSize;
+
+        u8 header[7];
+        std::memcpy(header, &FrameMagic, sizeof(FrameMagic));
+        header[4] = FrameFlags;
+        header[5] = FrameBlockMaxSize;
+        header[6] = static_cast<u8>(xxh32Short(header + 4, 2) >> 8);
+
+        s64 written = 0;
+        bool ok = R_SUCCEEDED(sdcard.write(dst, written, header, sizeof(header)));
+        written += sizeof(header);
+
+        s64 readOffset = 0;
+        while(ok) {
+            u64 dataRead = 0;
+            if(R_FAILED(sdcard.read(src, readOffset, buffer, BlockSize, &dataRead))) {
+                ok = false;
+                break;
+            }
+            if(dataRead == 0) break;
+            readOffset += dataRead;
+
+            // Keep the block uncompressed when compression does not pay
+            u32 size = static_cast<u32>(compressBlock(buffer, dataRead, block + sizeof(u32), BlockCapacity));
+            u32 blockHeader = size;
+            if(size == 0 || size >= dataRead) {
+                size = static_cast<u32>(dataRead);
+                blockHeader = size | UncompressedBlock;
+                std::memcpy(block + sizeof(u32), buffer, size);
+            }
+            std::memcpy(block, &blockHeader, sizeof(blockHeader));
+
+            ok = R_SUCCEEDED(sdcard.write(dst, written, block, sizeof(u32) + size));
+            written += sizeof(u32) + size;
+        }
+
+        const u32 endMark = 0;
+        ok = ok && R_SUCCEEDED(sdcard.write(dst, written, &endMark, sizeof(endMark), FsWriteOption_Flush));
+        written += sizeof(endMark);
+
+        free(buffer);
+
+        // Both files are done with, their handles would only take cache entries
+        sdcard.close(src);
+        sdcard.close(dst);
+
+        if(stats != nullptr) {
+            stats->bytesIn += readOffset;
+            stats->bytesOut += written;
+        }
+
+        return ok;
+    }
+
+}
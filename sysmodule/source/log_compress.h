@@ -0,0 +1,24 @@
+#pragma once
+#include <switch.h>
+
+namespace alefbet::authenticator::logger {
+
+    struct CompressStats {
+        u64 bytesIn = 0;
+        u64 bytesOut = 0;
+    };
+
+    /*! \brief Compresses \p src into \p dst as an LZ4 frame (readable with "lz4 -d").
+
+        The file is streamed in independent blocks so that only one block and its compressed
+        form are held in memory. The compressor is a greedy single-probe one: it favors speed
+        over ratio, which is good enough for log text.
+    */
+    bool compressFile(const char* src, const char* dst, CompressStats* stats = nullptr);
+
+    /*! \brief Compresses a single block in the LZ4 block format. Returns the compressed size, 0 if it does not fit \p capacity.
+        Its hash table is static: the logger compresses from the flusher thread only.
+    */
+    size_t compressBlock(const u8* src, size_t size, u8* dst, size_t capacity);
+
+}
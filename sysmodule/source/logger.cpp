@@ -1,24 +1,154 @@
 #include "logger.h"
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <cstdarg>
 #include <cstring>
+#include <cstdio>
+#include <vector>
+#include <strings.h>
 #include <cassert>
 #include <switch.h>
 #include "utils.h"
+#include "log_compress.h"
+#include "sd_card.h"
 
+#ifdef LOG_BINARY
+constexpr const char* LogFilename = "/atmosphere/logs/authenticator_svc.bin";
+#else
 constexpr const char* LogFilename = "/atmosphere/logs/authenticator_svc.log";
+#endif
+constexpr const char* LogLevelsFilename = "/config/authenticator/log_levels.txt";
+constexpr const char* FlightFilename = "/atmosphere/logs/authenticator_flight.bin";
+
+/* Ring buffer sizing, can be overridden per deployment (make DEFINES="-DLOG_RING_SLOTS=...") */
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 64
+#endif
+
+#ifndef LOG_FLUSH_INTERVAL_MS
+#define LOG_FLUSH_INTERVAL_MS 1000
+#endif
+
+/* Size cap of a log file and number of rotated files kept (make DEFINES="-DLOG_MAX_SIZE_KB=... -DLOG_GENERATIONS=...").
+   Rotated files are compressed to LZ4 frames with -DLOG_COMPRESS_ROTATED. */
+#ifndef LOG_MAX_SIZE_KB
+#define LOG_MAX_SIZE_KB 512
+#endif
+
+#ifndef LOG_GENERATIONS
+#define LOG_GENERATIONS 3
+#endif
+
+#ifdef LOG_COMPRESS_ROTATED
+constexpr const char* RotatedSuffix = ".lz4";
+#else
+constexpr const char* RotatedSuffix = "";
+#endif
+
+constexpr size_t LogSlotCount = LOG_RING_SLOTS;
+constexpr size_t LogSlotSize = 256;
+constexpr size_t LogHighWater = LogSlotCount / 2;
+constexpr size_t LogBatchSize = ams::os::MemoryPageSize;
+constexpr size_t LogScanSize = 1024;
+constexpr size_t FlusherStackSize = ams::util::AlignUp(16_KB, ams::os::MemoryPageSize);
+constexpr int FlusherPriority = 0x3F; // Lowest
+constexpr s64 LogMaxSize = LOG_MAX_SIZE_KB * 1024LL;
+constexpr int LogGenerations = LOG_GENERATIONS;
+
+constexpr size_t FlightSlotCount = LOG_FLIGHT_SLOTS > 0 ? LOG_FLIGHT_SLOTS : 1;
+constexpr u32 CrashDumpTimeoutMs = 1000;
+constexpr size_t WatchdogCount = 4;
+
+static_assert((LogSlotCount & (LogSlotCount - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+static_assert((FlightSlotCount & (FlightSlotCount - 1)) == 0, "LOG_FLIGHT_SLOTS must be a power of two");
+static_assert(LogMaxSize >= static_cast<s64>(LogBatchSize), "LOG_MAX_SIZE_KB must hold at least one batch");
 
 namespace alefbet {
     namespace authenticator {
 
         namespace {
-            static std::mutex s_mutex;                
-            static constinit char g_format_buffer[2 * ams::os::MemoryPageSize];
-            static FsFileSystem sdmc;
-            static bool ready = false;
-            static FsFile handle;
-            static size_t offset = 0;
-            static bool opened = false;    
+            /* A line is formatted directly into its slot. The slot sequence tells whether it is free
+               for the producer that reserved its position or ready for the flusher. It is stored
+               relative to the slot index so that the zero-initialized ring is empty. */
+            struct LogSlot {
+                std::atomic<u64> sequence;
+                u32 size;
+                char text[LogSlotSize - sizeof(std::atomic<u64>) - sizeof(u32)];
+            };
+            static_assert(sizeof(LogSlot) == LogSlotSize);
+            static_assert(sizeof(LogSlot::text) >= logger::LogRecordMaxSize);
+
+            /* A flight recorder event. The stamp is the position of the event plus one once it is written,
+               0 while it is being written, so that the dump skips a slot being overwritten. */
+            struct FlightSlot {
+                std::atomic<u64> stamp;
+                u8 data[logger::FlightRecordSize];
+            };
+            static_assert(sizeof(FlightSlot) == 64);
+
+            /* A watchdog deadline in ticks, 0 when free and Tripped once it has fired */
+            struct Watchdog {
+                std::atomic<u64> deadline;
+                const char* name;
+            };
+            constexpr u64 WatchdogClaimed = ~0ULL;
+            constexpr u64 WatchdogTripped = ~0ULL - 1;
+
+            /* Start of a binary log file */
+            struct LogFileHeader {
+                u32 magic;
+                u32 version;
+                u64 tickFrequency;
+            };
+            constexpr u32 LogFileMagic = 0x424C4141; // "AALB"
+            constexpr u32 LogFileVersion = 1;
+#ifdef LOG_BINARY
+            constexpr s64 EmptyLogSize = sizeof(LogFileHeader);
+#else
+            constexpr s64 EmptyLogSize = 0;
+#endif
+
+            static constinit LogSlot g_slots[LogSlotCount] = {};
+            static constinit std::atomic<u64> s_head = 0;       ///< Next position to reserve
+            static constinit std::atomic<u64> s_tail = 0;       ///< Next position to flush
+            static constinit std::atomic<u64> s_lines = 0;
+            static constinit std::atomic<u64> s_dropped = 0;
+            static constinit std::atomic<bool> s_running = false;
+
+            static std::mutex s_mutex;                          ///< Held while draining
+            alignas(ams::os::MemoryPageSize) static constinit char g_batch_buffer[LogBatchSize];
+            static constinit char g_scan_buffer[LogScanSize];   ///< findEnd() must not clobber a pending batch
+            static s64 offset = 0;                              ///< End of the data, the file itself is preallocated
+            static bool positioned = false;                     ///< Whether offset was found for the current file
+            static bool opened = false;
+            static u64 reportedDrops = 0;
+            static u64 batches = 0;
+            static u64 bytesWritten = 0;
+            static u64 rotations = 0;
+            static logger::CompressStats compressed;
+
+            static constinit std::atomic<u8> g_levels[] = {
+                logger::LogInfo, logger::LogInfo, logger::LogInfo, logger::LogInfo,
+                logger::LogInfo, logger::LogInfo, logger::LogInfo, logger::LogInfo
+            };
+            static_assert(sizeof(g_levels) / sizeof(g_levels[0]) == logger::LogCategoryCount);
+
+            constexpr const char* CategoryNames[] = { "Main", "Monitor", "Gui", "Renderer", "Font", "Database", "Helpers", "Services" };
+            constexpr const char* LevelNames[] = { "trace", "debug", "info", "warn", "error", "none" };
+
+            static constinit FlightSlot g_flight[FlightSlotCount] = {};
+            static constinit std::atomic<u64> s_flightHead = 0;
+            static constinit std::atomic_flag s_dumping = ATOMIC_FLAG_INIT;
+            static constinit std::atomic<bool> s_frozen = false;           ///< A crash is being dumped, later events are not recorded
+            static constinit std::atomic<bool> s_crashPending = false;     ///< The flusher has a crash dump to write
+            static constinit char g_crash_reason[64] = {};
+            static constinit u8 g_dump_buffer[LogBatchSize];
+            static constinit Watchdog g_watchdogs[WatchdogCount] = {};
+
+            static UEvent s_wakeup;
+            static Thread s_flusher;
+            alignas(ams::os::MemoryPageSize) static constinit u8 g_flusher_stack[FlusherStackSize];
         }
 
         typedef struct HipcMetadata {
@@ -34,80 +164,554 @@ namespace alefbet {
             u32 num_move_handles;
         } HipcMetadata;
 
-        namespace logger {           
-            
+        namespace logger {
+
+            bool isEnabled(LogLevel level, LogCategory category) {
+                return level >= g_levels[category].load(std::memory_order_relaxed);
+            }
+
+            void setLogLevel(LogCategory category, LogLevel level) {
+                g_levels[category].store(level, std::memory_order_relaxed);
+            }
+
             bool prepare() {
-                if(ready) return true;
+                return services::SdCard::get().ready();
+            }
+
+            /*! Finds the end of the data in a log file, the rest being preallocated space or a torn write */
+            static s64 findEnd() {
+                auto& sdcard = services::SdCard::get();
+
+                s64 size = 0;
+                if(R_FAILED(sdcard.getSize(LogFilename, &size))) return 0;
+
+#ifdef LOG_BINARY
+                // Records are walked by their size since their last bytes can be zeros
+                s64 end = sizeof(LogFileHeader);
+                while(end + static_cast<s64>(sizeof(LogRecordHeader)) <= size) {
+                    u64 dataRead = 0;
+                    if(R_FAILED(sdcard.read(LogFilename, end, g_scan_buffer, LogScanSize, &dataRead))) break;
+
+                    size_t position = 0;
+                    while(position + sizeof(LogRecordHeader) <= dataRead) {
+                        LogRecordHeader header;
+                        std::memcpy(&header, g_scan_buffer + position, sizeof(header));
+                        if(header.size < sizeof(header) || header.size > LogRecordMaxSize) return end + position;
+                        if(position + header.size > dataRead) break;
+                        position += header.size;
+                    }
+
+                    if(position == 0) break;
+                    end += position;
+                }
+
+                return std::min(end, size);
+#else
+                // Text never holds zeros: scan back for the last written byte
+                for(s64 end = size; end > 0;) {
+                    const s64 start = std::max<s64>(end - LogScanSize, 0);
+                    u64 dataRead = 0;
+                    if(R_FAILED(sdcard.read(LogFilename, start, g_scan_buffer, end - start, &dataRead))) return 0;
+
+                    for(s64 i = static_cast<s64>(dataRead); i > 0; i--) {
+                        if(g_scan_buffer[i - 1] != '\0') return start + i;
+                    }
+                    end = start;
+                }
+
+                return 0;
+#endif
+            }
+
+            static void generationPath(char* path, size_t size, int generation, const char* suffix = RotatedSuffix) {
+                snprintf(path, size, "%s.%d%s", LogFilename, generation, suffix);
+            }
+
+            /*! Moves a generation, compressed or kept as is because it could not be compressed. */
+            static void shiftGeneration(int generation) {
+                auto& sdcard = services::SdCard::get();
+                char from[FS_MAX_PATH], to[FS_MAX_PATH];
+
+                for(const char* suffix : { RotatedSuffix, "" }) {
+                    generationPath(from, sizeof(from), generation, suffix);
+                    generationPath(to, sizeof(to), generation + 1, suffix);
+                    sdcard.renameFile(from, to);
+
+                    if(*RotatedSuffix == '\0') break;
+                }
+            }
+
+            /*! Turns the current file into generation 1, the oldest generation is deleted. Called with the file closed. */
+            static void rotate(s64 used) {
+                auto& sdcard = services::SdCard::get();
+                char to[FS_MAX_PATH];
+
+                // Give back the preallocated space that was not used
+                sdcard.setSize(LogFilename, used);
+                sdcard.close(LogFilename);
+
+                if(LogGenerations > 0) {
+                    generationPath(to, sizeof(to), LogGenerations);
+                    sdcard.deleteFile(to);
+                    generationPath(to, sizeof(to), LogGenerations, "");
+                    sdcard.deleteFile(to);
 
-                ready = R_SUCCEEDED(fsOpenSdCardFileSystem(&sdmc));
+                    for(int generation = LogGenerations - 1; generation > 0; generation--) {
+                        shiftGeneration(generation);
+                    }
+
+                    generationPath(to, sizeof(to), 1);
+#ifdef LOG_COMPRESS_ROTATED
+                    if(logger::compressFile(LogFilename, to, &compressed)) {
+                        sdcard.deleteFile(LogFilename);
+                    } else {
+                        // The generation is kept uncompressed rather than lost
+                        sdcard.deleteFile(to);
+                        generationPath(to, sizeof(to), 1, "");
+                        sdcard.renameFile(LogFilename, to);
+                    }
+#else
+                    sdcard.renameFile(LogFilename, to);
+#endif
+                } else {
+                    sdcard.deleteFile(LogFilename);
+                }
 
-                return ready;
+                rotations++;
+                offset = 0;
+                positioned = false;
             }
 
             bool openFile() {
                 if(opened) return true;
                 if(!prepare()) return false;
 
-                // Try to open the file
-                opened = R_SUCCEEDED(fsFsOpenFile(&sdmc, LogFilename, FsOpenMode_Write | FsOpenMode_Append, &handle));
+                auto& sdcard = services::SdCard::get();
+
+                // A new file is preallocated so that appends never extend it
+                if(!sdcard.exists(LogFilename)) {
+                    if(R_FAILED(sdcard.createFile(LogFilename, LogMaxSize))) return false;
+                    offset = 0;
+                    positioned = true;
+                }
+
+                if(!positioned) {
+                    offset = findEnd();
+                    positioned = true;
+                }
+
+                opened = true;
 
-                // If the file could not be opened 
-                if(!opened) {
-                    // try to create a new one
-                    if(R_SUCCEEDED(fsFsCreateFile(&sdmc, LogFilename, 0, 0))) {
-                        // Then open it
-                        opened = R_SUCCEEDED(fsFsOpenFile(&sdmc, LogFilename, FsOpenMode_Write | FsOpenMode_Append, &handle));
+#ifdef LOG_BINARY
+                if(offset == 0) {
+                    const LogFileHeader header = { LogFileMagic, LogFileVersion, armGetSystemTickFreq() };
+                    if(R_SUCCEEDED(sdcard.write(LogFilename, 0, &header, sizeof(header)))) {
+                        offset = sizeof(header);
                     }
-                }                 
-                
+                }
+#endif
+
                 return opened;
             }
-            
+
             void clearLog() {
+                std::lock_guard<std::mutex> lock(s_mutex);
+
                 if(opened) return;
-                if(prepare()) {
-                    fsFsDeleteFile(&sdmc, LogFilename);
+                if(!prepare()) return;
+
+                // The log of the previous boot becomes generation 1
+                const s64 used = findEnd();
+                if(used > EmptyLogSize) {
+                    rotate(used);
                 }
-            }          
+            }
 
-            void logToFile(const char* fmt, ...) {
+            /*! Gives back the preallocated space that was not used, when the sysmodule stops */
+            static void trimFile() {
                 std::lock_guard<std::mutex> lock(s_mutex);
 
-                if(openFile()) {
-                    std::va_list vl;
-                    va_start(vl, fmt);
-                    vsnprintf(g_format_buffer, sizeof(g_format_buffer), fmt, vl);
-                    va_end(vl);    
-                    
-                    size_t size = std::strlen(g_format_buffer);
-                    if(R_SUCCEEDED(fsFileWrite(&handle, offset, g_format_buffer, size, FsWriteOption_Flush))) {
-                        offset += size;                        
+                if(!positioned || !prepare()) return;
+
+                services::SdCard::get().setSize(LogFilename, offset);
+                closeFile();
+            }
+
+            static int findName(const char* const* names, size_t count, const char* name) {
+                for(size_t i = 0; i < count; i++) {
+                    if(strcasecmp(names[i], name) == 0) return static_cast<int>(i);
+                }
+                return -1;
+            }
+
+            void loadLogLevels() {
+                if(!prepare()) return;
+
+                std::vector<u8> content;
+                if(R_FAILED(services::SdCard::get().readFile(LogLevelsFilename, content))) return;
+
+                char data[512] = {};
+                std::memcpy(data, content.data(), std::min(content.size(), sizeof(data) - 1));
+
+                char* context = nullptr;
+                for(char* line = strtok_r(data, "\r\n", &context); line != nullptr; line = strtok_r(nullptr, "\r\n", &context)) {
+                    char category[16], level[16];
+                    if(sscanf(line, "%15s %15s", category, level) != 2) continue;
+
+                    const int levelIndex = findName(LevelNames, LogNone + 1, level);
+                    if(levelIndex < 0) continue;
+
+                    if(std::strcmp(category, "*") == 0) {
+                        for(int i = 0; i < LogCategoryCount; i++) {
+                            setLogLevel(static_cast<LogCategory>(i), static_cast<LogLevel>(levelIndex));
+                        }
+                    } else {
+                        const int categoryIndex = findName(CategoryNames, LogCategoryCount, category);
+                        if(categoryIndex >= 0) {
+                            setLogLevel(static_cast<LogCategory>(categoryIndex), static_cast<LogLevel>(levelIndex));
+                        }
                     }
+                }
+            }
+
+            static void writeBatch(size_t size) {
+                if(size == 0) return;
 
+                if(offset + static_cast<s64>(size) > LogMaxSize && offset > EmptyLogSize) {
                     closeFile();
-                }                        
-                
+                    rotate(offset);
+                    if(!openFile()) return;
+                }
+
+                if(R_SUCCEEDED(services::SdCard::get().write(LogFilename, offset, g_batch_buffer, size))) {
+                    offset += size;
+                    bytesWritten += size;
+                }
+                batches++;
+            }
+
+            /* Single consumer, called with s_mutex held. \p out must have room for a full slot. */
+            static bool takeSlot(char* out, size_t& size) {
+                const u64 position = s_tail.load(std::memory_order_relaxed);
+                const u64 index = position & (LogSlotCount - 1);
+                auto& slot = g_slots[index];
+
+                if(slot.sequence.load(std::memory_order_acquire) + index != position + 1) {
+                    return false;
+                }
+
+                std::memcpy(out, slot.text, slot.size);
+                size = slot.size;
+
+                slot.sequence.store(position + LogSlotCount - index, std::memory_order_release);
+                s_tail.store(position + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            void flush() {
+                std::lock_guard<std::mutex> lock(s_mutex);
+
+                if(s_head.load(std::memory_order_acquire) == s_tail.load(std::memory_order_relaxed)) return;
+                if(!openFile()) return;
+
+                size_t used = 0;
+                size_t size = 0;
+                for(;;) {
+                    if(used + LogSlotSize > LogBatchSize) {
+                        writeBatch(used);
+                        used = 0;
+                    }
+
+                    if(!takeSlot(g_batch_buffer + used, size)) break;
+                    used += size;
+                }
+
+                const u64 dropped = s_dropped.load(std::memory_order_relaxed);
+                if(dropped != reportedDrops) {
+                    if(used + LogSlotSize > LogBatchSize) {
+                        writeBatch(used);
+                        used = 0;
+                    }
+#ifdef LOG_BINARY
+                    LogRecordWriter<> writer(logFormatId("[Logger] %lu lines dropped\n"), LogWarn, LogCategory_Main);
+                    writer.add(dropped - reportedDrops);
+                    std::memcpy(g_batch_buffer + used, writer.data(), writer.size());
+                    used += writer.size();
+#else
+                    used += snprintf(g_batch_buffer + used, LogBatchSize - used, "[Logger] %lu lines dropped\n", dropped - reportedDrops);
+#endif
+                    reportedDrops = dropped;
+                }
+
+                // The handle stays open in the SD card cache between batches
+                writeBatch(used);
+                services::SdCard::get().flush(LogFilename);
+            }
+
+            /* Reserves a slot without blocking. Returns nullptr (and counts the line) if the ring is full. */
+            static LogSlot* reserveSlot(u64& position) {
+                position = s_head.load(std::memory_order_relaxed);
+
+                for(;;) {
+                    LogSlot* slot = &g_slots[position & (LogSlotCount - 1)];
+                    const u64 sequence = slot->sequence.load(std::memory_order_acquire) + (position & (LogSlotCount - 1));
+
+                    if(sequence == position) {
+                        if(s_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return slot;
+                    } else if(sequence < position) {
+                        s_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;
+                    } else {
+                        position = s_head.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            static void publishSlot(LogSlot* slot, u64 position) {
+                slot->sequence.store(position + 1 - (position & (LogSlotCount - 1)), std::memory_order_release);
+                s_lines.fetch_add(1, std::memory_order_relaxed);
+
+                if(!s_running.load(std::memory_order_relaxed)) {
+                    // No flusher yet (early boot) or anymore: keep the lines on the SD card right away
+                    flush();
+                } else if(position + 1 - s_tail.load(std::memory_order_relaxed) == LogHighWater) {
+                    ueventSignal(&s_wakeup);
+                }
+            }
+
+            void logToFile(const char* fmt, ...) {
+                u64 position;
+                LogSlot* slot = reserveSlot(position);
+                if(slot == nullptr) return;
+
+                std::va_list vl;
+                va_start(vl, fmt);
+                const int size = vsnprintf(slot->text, sizeof(slot->text), fmt, vl);
+                va_end(vl);
+                slot->size = size < 0 ? 0 : std::min<u32>(size, sizeof(slot->text) - 1);
+
+                publishSlot(slot, position);
+            }
+
+            void logRecord(const u8* data, size_t size) {
+                u64 position;
+                LogSlot* slot = reserveSlot(position);
+                if(slot == nullptr) return;
+
+                slot->size = std::min(size, sizeof(slot->text));
+                std::memcpy(slot->text, data, slot->size);
+
+                publishSlot(slot, position);
+            }
+
+            void recordFlight(const u8* data, size_t size) {
+                if(s_frozen.load(std::memory_order_relaxed)) return;
+
+                const u64 position = s_flightHead.fetch_add(1, std::memory_order_relaxed);
+                auto& slot = g_flight[position & (FlightSlotCount - 1)];
+
+                slot.stamp.store(0, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                std::memcpy(slot.data, data, std::min(size, sizeof(slot.data)));
+                slot.stamp.store(position + 1, std::memory_order_release);
+            }
+
+            bool dumpFlightRecorder(const char* reason) {
+                if(!FlightRecorderEnabled) return false;
+
+                // A crash while dumping must not dump again
+                if(s_dumping.test_and_set(std::memory_order_acquire)) return false;
+                if(!prepare()) {
+                    s_dumping.clear(std::memory_order_release);
+                    return false;
+                }
+
+                // The raw session is used: the crash may have happened with the SD card lock held
+                FsFileSystem* sdmc = services::SdCard::get().fs();
+                FsFile file;
+                fsFsDeleteFile(sdmc, FlightFilename);
+                if(R_FAILED(fsFsCreateFile(sdmc, FlightFilename, 0, 0)) || R_FAILED(fsFsOpenFile(sdmc, FlightFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) {
+                    s_dumping.clear(std::memory_order_release);
+                    return false;
+                }
+
+                const LogFileHeader header = { LogFileMagic, LogFileVersion, armGetSystemTickFreq() };
+                std::memcpy(g_dump_buffer, &header, sizeof(header));
+                size_t used = sizeof(header);
+
+                LogRecordWriter<> writer(logFormatId("[Logger] Flight recorder dump: %s\n"), LogError, LogCategory_Main);
+                writer.add(reason);
+                std::memcpy(g_dump_buffer + used, writer.data(), writer.size());
+                used += writer.size();
+
+                s64 written = 0;
+                const u64 head = s_flightHead.load(std::memory_order_acquire);
+                for(u64 position = head > FlightSlotCount ? head - FlightSlotCount : 0; position < head; position++) {
+                    const auto& slot = g_flight[position & (FlightSlotCount - 1)];
+                    if(slot.stamp.load(std::memory_order_acquire) != position + 1) continue;
+
+                    u8 data[FlightRecordSize];
+                    std::memcpy(data, slot.data, sizeof(data));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if(slot.stamp.load(std::memory_order_relaxed) != position + 1) continue;
+
+                    u16 size;
+                    std::memcpy(&size, data + offsetof(LogRecordHeader, size), sizeof(size));
+                    if(size < sizeof(LogRecordHeader) || size > sizeof(data)) continue;
+
+                    if(used + size > sizeof(g_dump_buffer)) {
+                        fsFileWrite(&file, written, g_dump_buffer, used, FsWriteOption_None);
+                        written += used;
+                        used = 0;
+                    }
+                    std::memcpy(g_dump_buffer + used, data, size);
+                    used += size;
+                }
+
+                fsFileWrite(&file, written, g_dump_buffer, used, FsWriteOption_Flush);
+                fsFileClose(&file);
+
+                s_dumping.clear(std::memory_order_release);
+                return true;
+            }
+
+            void dumpFlightRecorderOnCrash(const char* reason) {
+                if(!FlightRecorderEnabled) return;
+
+                // Snapshot: the events of the other threads, which keep running, must not overwrite the ones leading to the crash
+                s_frozen.store(true, std::memory_order_release);
+                std::strncpy(g_crash_reason, reason, sizeof(g_crash_reason) - 1);
+
+                if(s_running.load(std::memory_order_acquire) && threadGetCurHandle() != s_flusher.handle) {
+                    s_crashPending.store(true, std::memory_order_release);
+                    ueventSignal(&s_wakeup);
+
+                    for(u32 waited = 0; waited < CrashDumpTimeoutMs && s_crashPending.load(std::memory_order_acquire); waited += 10) {
+                        svcSleepThread(10'000'000);
+                    }
+
+                    if(!s_crashPending.load(std::memory_order_acquire)) return;
+                }
+
+                // The flusher crashed or is stuck, the dump runs on the exception stack
+                dumpFlightRecorder(g_crash_reason);
+            }
+
+            WatchdogScope::WatchdogScope(const char* name, u32 timeoutMs) : slot_(-1) {
+                if(!FlightRecorderEnabled) return;
+
+                for(size_t i = 0; i < WatchdogCount; i++) {
+                    u64 expected = 0;
+                    if(g_watchdogs[i].deadline.compare_exchange_strong(expected, WatchdogClaimed, std::memory_order_acquire)) {
+                        g_watchdogs[i].name = name;
+                        g_watchdogs[i].deadline.store(armGetSystemTick() + armNsToTicks(timeoutMs * 1'000'000ULL), std::memory_order_release);
+                        slot_ = static_cast<int>(i);
+                        return;
+                    }
+                }
+            }
+
+            WatchdogScope::~WatchdogScope() {
+                if(slot_ >= 0) {
+                    g_watchdogs[slot_].deadline.store(0, std::memory_order_release);
+                }
+            }
+
+            /* Called by the flusher: a scope still open after its deadline dumps the flight recorder once */
+            static void checkWatchdogs() {
+                const u64 now = armGetSystemTick();
+
+                for(auto& watchdog : g_watchdogs) {
+                    u64 deadline = watchdog.deadline.load(std::memory_order_acquire);
+                    if(deadline == 0 || deadline >= WatchdogTripped || now < deadline) continue;
+                    if(!watchdog.deadline.compare_exchange_strong(deadline, WatchdogTripped, std::memory_order_acquire)) continue;
+
+                    LOG_ERROR(Main, "Watchdog %s tripped\n", watchdog.name);
+                    dumpFlightRecorder(watchdog.name);
+                }
+            }
+
+            static void flusherMain(void*) {
+                while(s_running.load(std::memory_order_relaxed)) {
+                    waitSingle(waiterForUEvent(&s_wakeup), LOG_FLUSH_INTERVAL_MS * 1'000'000ULL);
+
+                    // Before the log: the crashed thread is waiting for it
+                    if(s_crashPending.load(std::memory_order_acquire)) {
+                        dumpFlightRecorder(g_crash_reason);
+                        s_crashPending.store(false, std::memory_order_release);
+                    }
+
+                    flush();
+                    checkWatchdogs();
+                }
+
+                flush();
+            }
+
+            bool startFlusher() {
+                if(s_running) return true;
+
+                ueventCreate(&s_wakeup, true);
+
+                ::Result rc = threadCreate(&s_flusher, flusherMain, nullptr, g_flusher_stack, sizeof(g_flusher_stack), FlusherPriority, -2);
+                if(R_FAILED(rc)) return false;
+
+                s_running = true;
+                if(R_FAILED(threadStart(&s_flusher))) {
+                    s_running = false;
+                    threadClose(&s_flusher);
+                    return false;
+                }
+
+                return true;
+            }
+
+            void stopFlusher() {
+                if(!s_running) return;
+
+                s_running = false;
+                ueventSignal(&s_wakeup);
+                threadWaitForExit(&s_flusher);
+                threadClose(&s_flusher);
+
+                trimFile();
+            }
+
+            LoggerStats stats() {
+                std::lock_guard<std::mutex> lock(s_mutex);
+
+                LoggerStats stats;
+                stats.lines = s_lines.load(std::memory_order_relaxed);
+                stats.dropped = s_dropped.load(std::memory_order_relaxed);
+                stats.batches = batches;
+                stats.bytesWritten = bytesWritten;
+                stats.rotations = rotations;
+                stats.compressedIn = compressed.bytesIn;
+                stats.compressedOut = compressed.bytesOut;
+
+                return stats;
             }
 
             void debugHipcMetaHeader(void* hdr) {
                 HipcMetadata* h = (HipcMetadata*)hdr;
 
-                logToFile("HipcHeader contents:\n");
-                logToFile("  type               : %u\n", h->type);
-                logToFile("  num_send_statics   : %u\n", h->num_send_statics);
-                logToFile("  num_send_buffers   : %u\n", h->num_send_buffers);
-                logToFile("  num_recv_buffers   : %u\n", h->num_recv_buffers);
-                logToFile("  num_exch_buffers   : %u\n", h->num_exch_buffers);
-                logToFile("  num_data_words     : %u\n", h->num_data_words);
-                logToFile("  num_recv_statics   : %u\n", h->num_recv_statics);
-                logToFile("  send_pid           : %u\n", h->send_pid);
-                logToFile("  num_copy_handles   : %u\n", h->num_copy_handles);
-                logToFile("  num_move_handles   : %u\n", h->num_move_handles);
+                LOG_TRACE(Services, "HipcHeader contents:\n");
+                LOG_TRACE(Services, "  type               : %u\n", h->type);
+                LOG_TRACE(Services, "  num_send_statics   : %u\n", h->num_send_statics);
+                LOG_TRACE(Services, "  num_send_buffers   : %u\n", h->num_send_buffers);
+                LOG_TRACE(Services, "  num_recv_buffers   : %u\n", h->num_recv_buffers);
+                LOG_TRACE(Services, "  num_exch_buffers   : %u\n", h->num_exch_buffers);
+                LOG_TRACE(Services, "  num_data_words     : %u\n", h->num_data_words);
+                LOG_TRACE(Services, "  num_recv_statics   : %u\n", h->num_recv_statics);
+                LOG_TRACE(Services, "  send_pid           : %u\n", h->send_pid);
+                LOG_TRACE(Services, "  num_copy_handles   : %u\n", h->num_copy_handles);
+                LOG_TRACE(Services, "  num_move_handles   : %u\n", h->num_move_handles);
             }
 
             void closeFile() {
                 if(opened) {
-                    fsFileClose(&handle);
+                    services::SdCard::get().close(LogFilename);
                     opened = false;
                 }
             }
@@ -115,4 +719,4 @@ namespace alefbet {
         }
     }
 
-}
\ No newline at end of file
+}
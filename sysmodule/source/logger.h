@@ -1,10 +1,217 @@
 #pragma once
 #include <string>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <switch.h>
+
+/* Lowest level compiled in, can be overridden per deployment (make DEFINES="-DLOG_MIN_LEVEL=0" for traces) */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1
+#endif
+
+/* Events kept by the flight recorder, 0 to remove it (make DEFINES="-DLOG_FLIGHT_SLOTS=0") */
+#ifndef LOG_FLIGHT_SLOTS
+#define LOG_FLIGHT_SLOTS 2048
+#endif
+
+/* Lowest level kept by the flight recorder, traces by default. Below it the events and their arguments are compiled out (make DEFINES="-DLOG_FLIGHT_MIN_LEVEL=2" for info and above) */
+#ifndef LOG_FLIGHT_MIN_LEVEL
+#define LOG_FLIGHT_MIN_LEVEL 0
+#endif
 
 namespace alefbet {
     namespace authenticator { 
         namespace logger {
+            typedef enum : u8 {
+                LogTrace,
+                LogDebug,
+                LogInfo,
+                LogWarn,
+                LogError,
+                LogNone
+            } LogLevel;
+
+            typedef enum : u8 {
+                LogCategory_Main,
+                LogCategory_Monitor,
+                LogCategory_Gui,
+                LogCategory_Renderer,
+                LogCategory_Font,
+                LogCategory_Database,
+                LogCategory_Helpers,
+                LogCategory_Services,
+                LogCategoryCount
+            } LogCategory;
+
+            constexpr LogLevel MinLogLevel = static_cast<LogLevel>(LOG_MIN_LEVEL);
+            constexpr bool FlightRecorderEnabled = LOG_FLIGHT_SLOTS > 0;
+            constexpr LogLevel FlightMinLogLevel = static_cast<LogLevel>(LOG_FLIGHT_MIN_LEVEL);
+
+            /*! \brief Levels kept at runtime, per category (LogInfo by default). */
+            bool isEnabled(LogLevel level, LogCategory category);
+            void setLogLevel(LogCategory category, LogLevel level);
+
+            /*! \brief Reads "<Category> <level>" lines from /config/authenticator/log_levels.txt ("*" for all categories). */
+            void loadLogLevels();
+
+            struct LoggerStats {
+                u64 lines = 0;
+                u64 dropped = 0;        ///< Lines lost because the ring buffer was full
+                u64 batches = 0;        ///< Writes issued to the SD card
+                u64 bytesWritten = 0;
+                u64 rotations = 0;      ///< Files that reached LOG_MAX_SIZE_KB (or were left by the previous boot)
+                u64 compressedIn = 0;   ///< Rotated bytes, and their size once compressed (LOG_COMPRESS_ROTATED)
+                u64 compressedOut = 0;
+            };
+
+            /*! \brief Lines are formatted into a lock-free ring buffer and written to the SD card
+                in batches by a low priority thread, every LOG_FLUSH_INTERVAL_MS or when the ring
+                is half full. Until startFlusher() is called each line is flushed synchronously.
+            */
+            bool startFlusher();
+            void stopFlusher();
+
+            /*! \brief Writes the pending lines now. */
+            void flush();
+            LoggerStats stats();
+
+            /* Binary log (make DEFINES=-DLOG_BINARY): records hold the id of the format string, the tick
+               and the raw arguments. tools/logdecode.py turns the file back into text. */
+            typedef enum : u8 {
+                LogArgSigned = 1,
+                LogArgUnsigned,
+                LogArgDouble,
+                LogArgString,       ///< u8 length followed by the characters
+                LogArgPointer
+            } LogArgType;
+
+            struct LogRecordHeader {
+                u32 formatId;
+                u16 size;           ///< Size of the record, header included
+                u8 level;
+                u8 category;
+                u64 tick;
+            };
+
+            constexpr size_t LogRecordMaxSize = 240;
+
+            /*! \brief FNV-1a hash of a format string, computed by the compiler. */
+            consteval u32 logFormatId(const char* format) {
+                u32 hash = 2166136261u;
+                for(; *format != '\0'; format++) {
+                    hash = (hash ^ static_cast<u8>(*format)) * 16777619u;
+                }
+                return hash;
+            }
+
+            template<size_t Capacity = LogRecordMaxSize>
+            class LogRecordWriter {
+                public:
+                    LogRecordWriter(u32 formatId, LogLevel level, LogCategory category) {
+                        LogRecordHeader header = { formatId, sizeof(header), level, category, armGetSystemTick() };
+                        std::memcpy(data_, &header, sizeof(header));
+                        size_ = sizeof(header);
+                    }
+
+                    template<typename T>
+                    void add(T value) {
+                        if constexpr(std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+                            const size_t length = value != nullptr ? strnlen(value, 255) : 0;
+                            const u8 prefix[2] = { LogArgString, static_cast<u8>(length) };
+                            put(prefix, sizeof(prefix));
+                            put(value, length);
+                        } else if constexpr(std::is_pointer_v<T>) {
+                            putValue(LogArgPointer, reinterpret_cast<uintptr_t>(value));
+                        } else if constexpr(std::is_floating_point_v<T>) {
+                            putValue(LogArgDouble, static_cast<double>(value));
+                        } else if constexpr(std::is_signed_v<T>) {
+                            putValue(LogArgSigned, static_cast<s64>(value));
+                        } else {
+                            putValue(LogArgUnsigned, static_cast<u64>(value));
+                        }
+                    }
+
+                    const u8* data() {
+                        const u16 size = static_cast<u16>(size_);
+                        std::memcpy(data_ + offsetof(LogRecordHeader, size), &size, sizeof(size));
+                        return data_;
+                    }
+
+                    size_t size() const {
+                        return size_;
+                    }
+
+                private:
+                    template<typename V>
+                    void putValue(LogArgType type, V value) {
+                        const u8 tag = type;
+                        put(&tag, sizeof(tag));
+                        put(&value, sizeof(value));
+                    }
+
+                    void put(const void* data, size_t size) {
+                        // Arguments that do not fit are cut, the decoder prints what is left
+                        size = std::min(size, Capacity - size_);
+                        std::memcpy(data_ + size_, data, size);
+                        size_ += size;
+                    }
+
+                private:
+                    u8 data_[Capacity];
+                    size_t size_ = 0;
+            };
+
+            /*! \brief Queues an encoded record, dropped if the ring is full. */
+            void logRecord(const u8* data, size_t size);
+
+            /* Flight recorder: the last LOG_FLIGHT_SLOTS events are kept in memory as binary records,
+               cut to FlightRecordSize bytes, and only written to the SD card by dumpFlightRecorder(). */
+            constexpr size_t FlightRecordSize = 56;
+
+            void recordFlight(const u8* data, size_t size);
+
+            template<typename... Args>
+            void logFlight(u32 formatId, LogLevel level, LogCategory category, Args... args) {
+                LogRecordWriter<FlightRecordSize> writer(formatId, level, category);
+                (writer.add(args), ...);
+                recordFlight(writer.data(), writer.size());
+            }
+
+            /*! \brief Writes the flight recorder to /atmosphere/logs/authenticator_flight.bin (read with tools/logdecode.py).
+                Called on fatal errors and watchdog trips, it does not go through the ring buffer nor allocate.
+            */
+            bool dumpFlightRecorder(const char* reason);
+
+            /*! \brief Called by the exception handler: freezes the flight recorder and has the flusher thread write
+                it, so that the file system requests do not run on the exception stack. The dump is written by the
+                caller if the flusher is the crashed thread or does not answer within a second.
+            */
+            void dumpFlightRecorderOnCrash(const char* reason);
+
+            /*! \brief Dumps the flight recorder if the scope is still open after \p timeoutMs. The deadline is
+                checked by the flusher thread, so a trip is detected within LOG_FLUSH_INTERVAL_MS.
+            */
+            class WatchdogScope {
+                public:
+                    WatchdogScope(const char* name, u32 timeoutMs);
+                    ~WatchdogScope();
+
+                private:
+                    int slot_;
+            };
+
+            template<typename... Args>
+            void logBinary(u32 formatId, LogLevel level, LogCategory category, Args... args) {
+                LogRecordWriter<> writer(formatId, level, category);
+                (writer.add(args), ...);
+                logRecord(writer.data(), writer.size());
+            }
+
             bool openFile();
+
+            /*! \brief Starts a new log file: the one of the previous boot is rotated to generation 1. */
             void clearLog();
             void logToFile(const char *fmt, ...);
             void debugHipcMetaHeader(void* hdr);
@@ -14,3 +221,33 @@ namespace alefbet {
     }
 }
 
+/* Leveled logging front end. The category tag is prepended at compile time. Below MinLogLevel the
+   call to the log file is removed by the compiler, below FlightMinLogLevel the flight recorder one
+   is: a call below both thresholds, its arguments and its format string do not exist in the binary. */
+#ifdef LOG_BINARY
+#define LOG_WRITE(level, category, fmt, ...) \
+    alefbet::authenticator::logger::logBinary(alefbet::authenticator::logger::logFormatId("[" #category "] " fmt), \
+        level, alefbet::authenticator::logger::LogCategory_##category __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOG_WRITE(level, category, fmt, ...) \
+    alefbet::authenticator::logger::logToFile("[" #category "] " fmt __VA_OPT__(,) __VA_ARGS__)
+#endif
+
+#define LOG_AT(level, category, fmt, ...) \
+    do { \
+        if constexpr(alefbet::authenticator::logger::FlightRecorderEnabled && level >= alefbet::authenticator::logger::FlightMinLogLevel) { \
+            alefbet::authenticator::logger::logFlight(alefbet::authenticator::logger::logFormatId("[" #category "] " fmt), \
+                level, alefbet::authenticator::logger::LogCategory_##category __VA_OPT__(,) __VA_ARGS__); \
+        } \
+        if constexpr(level >= alefbet::authenticator::logger::MinLogLevel) { \
+            if(alefbet::authenticator::logger::isEnabled(level, alefbet::authenticator::logger::LogCategory_##category)) { \
+                LOG_WRITE(level, category, fmt __VA_OPT__(,) __VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
+#define LOG_TRACE(category, fmt, ...)   LOG_AT(alefbet::authenticator::logger::LogTrace, category, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_DEBUG(category, fmt, ...)   LOG_AT(alefbet::authenticator::logger::LogDebug, category, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_INFO(category, fmt, ...)    LOG_AT(alefbet::authenticator::logger::LogInfo, category, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARN(category, fmt, ...)    LOG_AT(alefbet::authenticator::logger::LogWarn, category, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(category, fmt, ...)   LOG_AT(alefbet::authenticator::logger::LogError, category, fmt __VA_OPT__(,) __VA_ARGS__)
@@ -1,4 +1,5 @@
 #include <switch.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
@@ -7,6 +8,10 @@
 #include "logger.h"
 #include "utils.h"
 #include "monitor.h"
+#include "service_manager.h"
+#include "sd_card.h"
+#include "profile_table.h"
+#include "database/database.h"
 #include "gui/gui_controller.h"
 
 using namespace alefbet::authenticator::logger;
@@ -75,7 +80,20 @@ extern "C" {
         //hidInitialize();
         //hidsysInitialize();
         pmdmntInitialize();
-        nsInitialize();        
+    }
+
+    // On a crash the flight recorder is written to the SD card, then the crash is reported as usual.
+    // The dump is handed to the flusher thread, the stack is sized for the case where it must be written here.
+    alignas(16) u8 __nx_exception_stack[0x4000];
+    u64 __nx_exception_stack_size = sizeof(__nx_exception_stack);
+
+    void __libnx_exception_handler(ThreadExceptionDump* ctx)
+    {
+        char reason[64];
+        snprintf(reason, sizeof(reason), "exception %x at pc %lx, lr %lx", ctx->error_desc, ctx->pc.x, ctx->lr.x);
+        dumpFlightRecorderOnCrash(reason);
+
+        svcReturnFromException(KERNELRESULT(UnhandledUserInterrupt));
     }
 
     void __wrap_exit(void)
@@ -96,10 +114,10 @@ extern "C" {
         for(int s = 0x1000 ; s <= 0x150000 ; s += 5000) {
             void* ptr = aligned_alloc(0x1000, s);
             if(ptr != nullptr) {
-                logToFile("Allocation of %i bytes succeeded. @ptr=%p\n", s, (void*)ptr);
+                LOG_DEBUG(Main, "Allocation of %i bytes succeeded. @ptr=%p\n", s, (void*)ptr);
                 free(ptr);
             } else {
-                logToFile("Allocation of %i bytes failed\n", s);    
+                LOG_ERROR(Main, "Allocation of %i bytes failed\n", s);    
                 break;                                            
             }            
         } 
@@ -111,7 +129,7 @@ namespace alefbet::authenticator {
     void startMonitor(void* args) {
         GuiController* gui = static_cast<GuiController*>(args);
         alefbet::authenticator::srv::Monitor* monitor = new alefbet::authenticator::srv::Monitor(gui);
-        logToFile("@monitor=%p\n", monitor);
+        LOG_DEBUG(Main, "@monitor=%p\n", monitor);
 
         // Start monitoring
         monitor->start();
@@ -122,7 +140,7 @@ namespace alefbet::authenticator {
 
     void startGui(void* args) {
         GuiController* gui = static_cast<GuiController*>(args);
-        logToFile("@gui=%p\n", gui);
+        LOG_DEBUG(Main, "@gui=%p\n", gui);
         
         gui->init();
         gui->start();
@@ -136,10 +154,25 @@ int main(int argc, char **argv)
         exit(1);
 
     clearLog();
-    logToFile("[Main] Authenticator starting\n");
+    loadLogLevels();
+    LOG_INFO(Main, "Authenticator starting\n");
+
+    // From now on lines are written to the SD card in batches
+    if(!startFlusher()) {
+        LOG_ERROR(Main, "Could not start the log flusher, logging synchronously\n");
+    }
 
     //testMemory();
 
+    // Keep the sessions used on the launch path open for the lifetime of the sysmodule
+    auto& services = alefbet::authenticator::services::ServiceManager::get();
+    services.acquire(alefbet::authenticator::services::Account);
+    services.acquire(alefbet::authenticator::services::Ns);
+    services.acquire(alefbet::authenticator::services::Time);
+
+    alefbet::authenticator::helpers::ProfileTable::get().load();
+    alefbet::authenticator::database::CredentialStore::get().load();
+
     ::Result rc = 0;    
 
     GuiController* gui = new GuiController;
@@ -148,13 +181,15 @@ int main(int argc, char **argv)
     Thread threadGui;
     rc = threadCreate(&threadGui, alefbet::authenticator::startGui, gui, g_thread_gui_memory, ThreadGuiStackRequiredSizeAligned, 0x2c, -2);
     if(R_FAILED(rc)) {
-        logToFile("Could not create the GUI thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not create the GUI thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("startup");
         return 8;
     }
 
     rc = threadStart(&threadGui);
     if(R_FAILED(rc)) {
-        logToFile("Could not start the GUI thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not start the GUI thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("startup");
         return 5;
     }
 
@@ -162,29 +197,39 @@ int main(int argc, char **argv)
     Thread threadMonitor;    
     rc = threadCreate(&threadMonitor, alefbet::authenticator::startMonitor, gui, g_thread_monitor_memory, ThreadMonitorStackRequiredSizeAligned, 0x2c, -2);
     if(R_FAILED(rc)) {
-        logToFile("Could not create the monitor thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not create the monitor thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("startup");
         return 4;
 
     }
     rc = threadStart(&threadMonitor); // Run the monitor's loop
     if(R_FAILED(rc)) {
-        logToFile("Could not start the monitor thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not start the monitor thread, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("startup");
         return 5;
     }
     
     rc = threadWaitForExit(&threadMonitor);
     if(R_FAILED(rc)) {
-        logToFile("Could not wait for the monitor thread to end, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not wait for the monitor thread to end, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("shutdown");
         return 7;
     }
 
     rc = threadWaitForExit(&threadGui);
     if(R_FAILED(rc)) {
-        logToFile("Could not wait for the GUI thread to end, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        LOG_ERROR(Main, "Could not wait for the GUI thread to end, error %i:%i.\n", R_MODULE(rc), R_DESCRIPTION(rc));
+        dumpFlightRecorder("shutdown");
         return 7;
     }
 
-    logToFile("[Main] Authenticator ended\n");
+    services.logStats();
+    alefbet::authenticator::services::SdCard::get().logStats();
+
+    const auto& logStats = stats();
+    LOG_INFO(Main, "Authenticator ended (%lu log lines, %lu dropped, %lu writes, %lu rotations)\n", logStats.lines, logStats.dropped, logStats.batches, logStats.rotations);
+    stopFlusher();
+    alefbet::authenticator::services::SdCard::get().closeAll();
 
     return 0;
 }
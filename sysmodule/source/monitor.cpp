@@ -2,13 +2,23 @@
 #include "logger.h"
 #include "literals.h"
 #include "helpers.h"
+#include "profile_table.h"
+#include "database/database.h"
+#include <algorithm>
 #include <chrono>
 
 using namespace std::chrono;
 using namespace alefbet::authenticator::logger;
 using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::database;
 
-constexpr s64 MainLoopDelayInNanos = 5'000'000'000; // 5 seconds
+/* Handling an event (launch, close, maintenance) past this delay dumps the flight recorder */
+constexpr u32 EventWatchdogMs = 5000;
+
+/* Attempts to get a lost launch event source back, further and further apart, before polling for good */
+constexpr s64 EventSourceRetryMinNs = 1'000'000'000;
+constexpr s64 EventSourceRetryMaxNs = 60'000'000'000;
+constexpr u32 EventSourceRetries = 8;
 
 namespace alefbet::authenticator::srv {
 
@@ -20,70 +30,200 @@ namespace alefbet::authenticator::srv {
     /*!
         \brief Monitors running game and show the authentication window if a new game has been started.
 
-        The monitoring is done by looking at the currently running game and compare with the previous value.
+        The monitor blocks on the launch event source and wakes up as soon as an application is created.
+        While a game is running it also wakes up, as decided by the scheduler, to detect when the game
+        is closed or the user switched. If no event source is available it falls back to polling.
+        The maintenance following a closed game (profile refresh, credential compaction) only runs
+        once no game is running, never between a launch and the authentication panel.
     */
     void Monitor::loop() {        
-        logToFile("[Monitor] Starting monitoring loop\n");
+        LOG_INFO(Monitor, "Starting monitoring loop\n");
 
         currentTitle_ = 0;
         currentUser_ = UserData{};
 
-        logToFile("[Monitor] Monitoring loop has started\n");
+        LOG_INFO(Monitor, "Monitoring loop has started\n");
         
-        while(true) {            
+        while(!exiting_) {
 
             if(!running_) {
-                // Do nothing
-                svcSleepThread(500'000'000); // Wait for 500 ms
+                // A stopped monitor must not hold the launched applications
+                if(listening_) {
+                    eventSource_->close();
+                    listening_ = false;
+                }
+
+                scheduler_.sleepIdle();
                 continue;
             }                    
 
             if(firstStart_) {
-                // On the first start we wait for 30 seconds
-                svcSleepThread(MainLoopDelayInNanos);
+                // On the first start we wait for the system to be ready
+                scheduler_.sleepStartup();
                 firstStart_ = false;
             }
 
-            const auto& currentAppPid = getRunningApplicationPid();
-            if(currentAppPid != 0) {
-                handleRunningApp(currentAppPid);
-            } else {
-                // The app has been closed?
-                if(currentTitle_ > 0) {
-                    logToFile("[Monitor] The game has been closed\n");
+            if(!listening_) {
+                listening_ = true;
+                reopenAt_ = 0;
+                reopenDelayNs_ = EventSourceRetryMinNs;
+                reopenAttempts_ = 0;
+                if(!eventSource_->open()) {
+                    LOG_WARN(Monitor, "No launch event source, falling back to polling\n");
+                }
+
+                // A game may have been started before the event source was ready
+                poll();
+            }
+
+            // Only wake up periodically when a game may be closed
+            const s64 timeout = currentTitle_ > 0 ? scheduler_.nextDelay() : -1;
+            auto event = eventSource_->wait(timeout);
 
-                    // Hide the panel                    
-                    guiController_->hideAll();
+            if(event.type == LaunchEvent::Failed) {
+                // Polling fallback, the detection latency is bounded by the delay
+                const s64 delay = scheduler_.currentDelay();
+                scheduler_.sleep();
 
-                    currentTitle_ = 0;
-                    currentUser_.clear();
+                WatchdogScope watchdog("monitor poll", EventWatchdogMs);
+                if(poll()) {
+                    scheduler_.recordDetection(delay);
                 }
+                runMaintenance();
+
+                reopenEventSource();
+                continue;
             }
-                          
-            svcSleepThread(MainLoopDelayInNanos); //Wait            
+
+            scheduler_.recordWakeup();
+            WatchdogScope watchdog("monitor event", EventWatchdogMs);
+
+            if(event.type == LaunchEvent::Launched) {
+                // Start the game as soon as possible, the panel will be shown over it
+                eventSource_->acknowledge(event);
+
+                if(event.pid != 0) {
+                    // A new launch means a new session, even for the same title
+                    handleClosedApp();
+                    handleRunningApp(query_.take(event.pid));
+                    scheduler_.recordDetection(armTicksToNs(armGetSystemTick() - event.tick));
+                }
+                continue;
+            }
+
+            // Interrupted by stop() or shutdown()
+            if(!running_) continue;
+
+            // Timeout: has the game been closed or the user changed?
+            poll();
+            runMaintenance();
+        }
+
+        if(listening_) {
+            eventSource_->close();
+            listening_ = false;
+        }
+        query_.close();
+
+        LOG_INFO(Monitor, "Stopped monitoring.\n");
+    }
+
+    /*!
+        \brief Checks the running application. Returns true if the authentication panel has been requested.
+    */
+    bool Monitor::poll() {
+        const auto& snapshot = query_.take();
+        if(snapshot.pid != 0) {
+            return handleRunningApp(snapshot);
         }
 
-        logToFile("[Monitor] Stopped monitoring.\n");
+        handleClosedApp();
+        return false;
+    }
+
+    /*!
+        \brief Tries to get the event source back while polling.
+
+        The attempts are backed off up to a minute apart and stop after a few failures: the pm:dmnt
+        hook is single, once another process holds it the monitor keeps polling until it is restarted.
+    */
+    void Monitor::reopenEventSource() {
+        if(reopenAttempts_ >= EventSourceRetries || scheduler_.clock()->now() < reopenAt_) return;
+
+        if(eventSource_->open()) {
+            LOG_INFO(Monitor, "The launch event source is available again\n");
+            reopenAttempts_ = 0;
+            reopenDelayNs_ = EventSourceRetryMinNs;
+            return;
+        }
+
+        if(++reopenAttempts_ == EventSourceRetries) {
+            LOG_WARN(Monitor, "The launch event source is still unavailable, polling until the monitor is restarted\n");
+            return;
+        }
+
+        reopenAt_ = scheduler_.clock()->now() + reopenDelayNs_;
+        reopenDelayNs_ = std::min(reopenDelayNs_ * 2, EventSourceRetryMaxNs);
     }
 
     void Monitor::stop() {
-        logToFile("[Monitor] Stopping monitor\n");
+        LOG_INFO(Monitor, "Stopping monitor\n");
         running_ = false;
+        eventSource_->interrupt();
+    }
+
+    void Monitor::shutdown() {
+        LOG_INFO(Monitor, "Shutting the monitor down\n");
+        exiting_ = true;
+        stop();
     }
 
-    void Monitor::handleRunningApp(u64 pid) {
-        const auto& currentTitle = getRunningApplicationTitleId(pid);
-        const auto& currentUser = getCurrentUser();
+    bool Monitor::handleRunningApp(const PlatformSnapshot& snapshot) {
+        const auto& currentTitle = snapshot.programId;
+        const auto& currentUser = snapshot.user;
+
+        if(currentTitle_ > 0 && currentUser != currentUser_) {
+            scheduler_.notify(MonitorScheduler::UserSwitched);
+        }
 
         if(currentTitle != currentTitle_ && currentUser != currentUser_) {
-            logToFile("[Monitor] handle running app %i\n", pid);
+            LOG_DEBUG(Monitor, "handle running app %i (%u IPC calls)\n", snapshot.pid, snapshot.ipcCalls);
 
             currentTitle_ = currentTitle;
             currentUser_ = currentUser;
 
-            logToFile("[Monitor] The current game and/or user has changed\n");
+            LOG_INFO(Monitor, "The current game and/or user has changed\n");
             
-            guiController_->showAuthenticationPanel();
+            guiController_->showAuthenticationPanel(currentUser_);
+            scheduler_.notify(MonitorScheduler::GameLaunched);
+            return true;
         }
+
+        return false;
+    }
+
+    void Monitor::handleClosedApp() {
+        if(currentTitle_ == 0) return;
+
+        LOG_INFO(Monitor, "The game has been closed\n");
+
+        // Hide the panel
+        guiController_->hideAll();
+
+        currentTitle_ = 0;
+        currentUser_.clear();
+
+        // A launch also closes the previous game, its maintenance waits until no game is running
+        maintenanceDue_ = true;
+
+        scheduler_.notify(MonitorScheduler::GameClosed);
+    }
+
+    void Monitor::runMaintenance() {
+        if(!maintenanceDue_ || currentTitle_ != 0) return;
+
+        maintenanceDue_ = false;
+        ProfileTable::get().refresh();
+        CredentialStore::get().compactIfNeeded();
     }
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include <switch.h>
+#include <atomic>
 #include "helpers.h"
+#include "launch_event_source.h"
+#include "monitor_scheduler.h"
+#include "platform_snapshot.h"
 #include "gui/gui_controller.h"
 
 using namespace alefbet::authenticator::structs;
@@ -11,25 +15,45 @@ namespace alefbet::authenticator::srv {
     */
     class Monitor {
         public:         
-            Monitor(GuiController* gui) 
-            : guiController_(gui) {}
+            Monitor(GuiController* gui, LaunchEventSource* eventSource = nullptr, Clock* clock = nullptr)
+            : guiController_(gui), eventSource_(eventSource != nullptr ? eventSource : &pmEventSource_), scheduler_(clock) {}
             void start();
+
+            /*! \brief Pauses the monitor: the launch hook is released until start() is called again. */
             void stop();
+
+            /*! \brief Makes loop() return once the event source is closed. */
+            void shutdown();
+
             void loop();
             bool isRunning() const {
                 return running_;
             } 
 
         private:
-            void handleRunningApp(u64 pid);
+            bool handleRunningApp(const PlatformSnapshot& snapshot);
+            void handleClosedApp();
+            void runMaintenance();
+            void reopenEventSource();
+            bool poll();
             GuiController* getGuiController();
 
         private:
-            bool running_ = false;
+            std::atomic<bool> running_ = false;
+            std::atomic<bool> exiting_ = false;
+            bool listening_ = false;            ///< The event source has been opened and not closed since
+            u64 reopenAt_ = 0;                  ///< Time of the next attempt to open the event source again
+            s64 reopenDelayNs_ = 0;
+            u32 reopenAttempts_ = 0;
+            bool maintenanceDue_ = false;       ///< A game has been closed, the maintenance waits for the monitor to be idle
             u64 currentTitle_ = 0;
             UserData currentUser_;
             bool firstStart_ = true;
             GuiController* guiController_ = nullptr;
+            PmLaunchEventSource pmEventSource_;
+            LaunchEventSource* eventSource_ = nullptr;
+            MonitorScheduler scheduler_;
+            PlatformQuery query_;
     };    
 
 };
\ No newline at end of file
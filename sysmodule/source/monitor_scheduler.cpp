@@ -0,0 +1,82 @@
+#include "monitor_scheduler.h"
+#include "logger.h"
+#include <algorithm>
+
+using namespace alefbet::authenticator::logger;
+
+constexpr u64 OneMinuteInNanos = 60'000'000'000;
+
+namespace alefbet::authenticator::srv {
+
+    u64 SystemClock::now() {
+        return armTicksToNs(armGetSystemTick());
+    }
+
+    void SystemClock::sleep(s64 ns) {
+        svcSleepThread(ns);
+    }
+
+    void MonitorScheduler::notify(Transition transition) {
+        LOG_DEBUG(Monitor, "Transition %i, entering burst mode\n", transition);
+
+        delayNs_ = limits_.minDelayNs;
+        burstEnd_ = clock_->now() + limits_.burstDurationNs;
+    }
+
+    s64 MonitorScheduler::nextDelay() {
+        const s64 delay = delayNs_;
+
+        // Stay at the minimum delay during a burst, then back off
+        if(clock_->now() >= burstEnd_) {
+            delayNs_ = std::min(delayNs_ * static_cast<s64>(limits_.backoffFactor), limits_.maxDelayNs);
+        }
+
+        return delay;
+    }
+
+    void MonitorScheduler::sleep() {
+        clock_->sleep(nextDelay());
+        recordWakeup();
+    }
+
+    void MonitorScheduler::sleepIdle() {
+        clock_->sleep(limits_.idleDelayNs);
+        recordWakeup();
+    }
+
+    void MonitorScheduler::sleepStartup() {
+        clock_->sleep(limits_.startupDelayNs);
+        recordWakeup();
+    }
+
+    void MonitorScheduler::recordWakeup() {
+        const u64 now = clock_->now();
+
+        if(now - minuteStart_ >= OneMinuteInNanos) {
+            stats_.wakeupsLastMinute = wakeupsThisMinute_;
+            wakeupsThisMinute_ = 0;
+            minuteStart_ = now;
+        }
+
+        stats_.wakeups++;
+        wakeupsThisMinute_++;
+    }
+
+    void MonitorScheduler::recordDetection(u64 latencyNs) {
+        if(stats_.detections == 0 || latencyNs < stats_.minLatencyNs) {
+            stats_.minLatencyNs = latencyNs;
+        }
+
+        stats_.maxLatencyNs = std::max(stats_.maxLatencyNs, latencyNs);
+        stats_.totalLatencyNs += latencyNs;
+        stats_.detections++;
+
+        LOG_DEBUG(Monitor, "Detection latency %lu ms (min=%lu, avg=%lu, max=%lu), %u wakeups last minute\n",
+            latencyNs / 1'000'000,
+            stats_.minLatencyNs / 1'000'000,
+            stats_.averageLatencyNs() / 1'000'000,
+            stats_.maxLatencyNs / 1'000'000,
+            stats_.wakeupsLastMinute);
+    }
+
+}
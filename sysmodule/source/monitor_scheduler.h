@@ -0,0 +1,151 @@
+#pragma once
+#include <switch.h>
+
+/* Polling limits, can be overridden per deployment (make DEFINES="-DMONITOR_MAX_POLL_MS=...") */
+#ifndef MONITOR_MIN_POLL_MS
+#define MONITOR_MIN_POLL_MS 100
+#endif
+
+#ifndef MONITOR_MAX_POLL_MS
+#define MONITOR_MAX_POLL_MS 5000
+#endif
+
+#ifndef MONITOR_IDLE_POLL_MS
+#define MONITOR_IDLE_POLL_MS 500
+#endif
+
+#ifndef MONITOR_BURST_MS
+#define MONITOR_BURST_MS 3000
+#endif
+
+#ifndef MONITOR_STARTUP_DELAY_MS
+#define MONITOR_STARTUP_DELAY_MS 5000
+#endif
+
+namespace alefbet::authenticator::srv {
+
+    /*! \brief Time source used by the scheduler.
+    */
+    class Clock {
+        public:
+            virtual ~Clock() = default;
+            virtual u64 now() = 0;              ///< Current time in nanoseconds
+            virtual void sleep(s64 ns) = 0;
+    };
+
+    /*! \brief Clock backed by the system tick.
+    */
+    class SystemClock : public Clock {
+        public:
+            u64 now() override;
+            void sleep(s64 ns) override;
+    };
+
+    /*! \brief Clock that only moves when sleep() or advance() is called.
+
+        It is used to evaluate the scheduling policy without waiting in real time.
+    */
+    class VirtualClock : public Clock {
+        public:
+            u64 now() override {
+                return now_;
+            }
+
+            void sleep(s64 ns) override {
+                if(ns > 0) now_ += ns;
+            }
+
+            void advance(s64 ns) {
+                sleep(ns);
+            }
+
+        private:
+            u64 now_ = 0;
+    };
+
+    struct SchedulerLimits {
+        s64 minDelayNs = MONITOR_MIN_POLL_MS * 1'000'000LL;         ///< Delay used right after a transition
+        s64 maxDelayNs = MONITOR_MAX_POLL_MS * 1'000'000LL;         ///< Delay reached during steady play
+        s64 idleDelayNs = MONITOR_IDLE_POLL_MS * 1'000'000LL;       ///< Delay while the monitor is stopped
+        s64 burstDurationNs = MONITOR_BURST_MS * 1'000'000LL;       ///< Time spent at the minimum delay after a transition
+        s64 startupDelayNs = MONITOR_STARTUP_DELAY_MS * 1'000'000LL;///< Delay before the first check
+        u32 backoffFactor = 2;
+    };
+
+    struct SchedulerStats {
+        u64 wakeups = 0;
+        u32 wakeupsLastMinute = 0;
+        u64 detections = 0;
+        u64 minLatencyNs = 0;
+        u64 maxLatencyNs = 0;
+        u64 totalLatencyNs = 0;
+
+        u64 averageLatencyNs() const {
+            return detections > 0 ? totalLatencyNs / detections : 0;
+        }
+    };
+
+    /*! \brief Decides how long the monitor thread sleeps between two checks.
+
+        The scheduler polls at the minimum delay for a short burst after each state transition
+        (game launched or closed, HOME menu, user switched) and backs off exponentially while
+        nothing changes, up to the maximum delay.
+    */
+    class MonitorScheduler {
+        public:
+            typedef enum {
+                GameLaunched,
+                GameClosed,
+                HomeMenu,
+                UserSwitched
+            } Transition;
+
+            MonitorScheduler(Clock* clock = nullptr, const SchedulerLimits& limits = SchedulerLimits{})
+            : clock_(clock != nullptr ? clock : &systemClock_), limits_(limits), delayNs_(limits.minDelayNs) {}
+
+            /*! \brief Enters burst mode after a state transition. */
+            void notify(Transition transition);
+
+            /*! \brief Returns the delay to wait before the next check and updates the backoff. */
+            s64 nextDelay();
+
+            /*! \brief Sleeps for the next delay and records the wakeup. */
+            void sleep();
+
+            /*! \brief Sleeps while the monitor is stopped. */
+            void sleepIdle();
+
+            /*! \brief Sleeps before the first check. */
+            void sleepStartup();
+
+            /*! \brief Records a wakeup of the monitor thread. */
+            void recordWakeup();
+
+            /*! \brief Records the time between a launch and its detection. */
+            void recordDetection(u64 latencyNs);
+
+            /*! \brief Upper bound of the detection latency with the current delay. */
+            s64 currentDelay() const {
+                return delayNs_;
+            }
+
+            const SchedulerStats& stats() const {
+                return stats_;
+            }
+
+            Clock* clock() {
+                return clock_;
+            }
+
+        private:
+            SystemClock systemClock_;
+            Clock* clock_ = nullptr;
+            SchedulerLimits limits_;
+            SchedulerStats stats_;
+            s64 delayNs_ = 0;
+            u64 burstEnd_ = 0;
+            u64 minuteStart_ = 0;
+            u32 wakeupsThisMinute_ = 0;
+    };
+
+}
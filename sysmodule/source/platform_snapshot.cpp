@@ -0,0 +1,102 @@
+#include "platform_snapshot.h"
+#include "logger.h"
+#include "service_manager.h"
+#include "profile_table.h"
+
+using namespace alefbet::authenticator::logger;
+using namespace alefbet::authenticator::structs;
+using namespace alefbet::authenticator::services;
+using namespace alefbet::authenticator::helpers;
+
+namespace alefbet::authenticator::srv {
+
+    bool PlatformQuery::open() {
+        if(accountReady_) return true;
+
+        if(!ServiceManager::get().acquire(Account)) {
+            LOG_ERROR(Monitor, "Could not initialize account service\n");
+            return false;
+        }
+
+        accountReady_ = true;
+        return true;
+    }
+
+    void PlatformQuery::close() {
+        if(!accountReady_) return;
+
+        ServiceManager::get().release(Account);
+        accountReady_ = false;
+        lastUser_.clear();
+    }
+
+    PlatformSnapshot PlatformQuery::take(u64 pid) {
+        PlatformSnapshot snapshot;
+
+        // Running application
+        if(pid == 0) {
+            snapshot.ipcCalls++;
+            if(R_FAILED(pmdmntGetApplicationProcessId(&pid))) {
+                pid = 0;
+            }
+        }
+
+        if(pid != 0) {
+            // The program ID cannot change for a given process
+            if(pid != lastPid_) {
+                snapshot.ipcCalls++;
+                if(R_FAILED(pmdmntGetProgramId(&lastProgramId_, pid))) {
+                    lastProgramId_ = 0;
+                }
+                lastPid_ = pid;
+            }
+
+            snapshot.pid = pid;
+            snapshot.programId = lastProgramId_;
+        } else {
+            lastPid_ = 0;
+            lastProgramId_ = 0;
+        }
+
+        // Current user
+        if(open()) {
+            AccountUid uid{};
+
+            snapshot.ipcCalls++;
+            ::Result rc = ServiceManager::get().call(Account, [&] { return accountGetLastOpenedUser(&uid); });
+            if(R_FAILED(rc)) {
+                LOG_ERROR(Monitor, "Could not get last opened user: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+                snapshot.user.nickname = UserNickname("ERR#004");
+            } else if(lastUser_.isValid() && uid.uid[0] == lastUser_.uid.uid[0] && uid.uid[1] == lastUser_.uid.uid[1]) {
+                snapshot.user = lastUser_;
+            } else {
+                // Only fetch the profile when the user has changed
+                snapshot.user.uid = uid;
+                fetchNickname(uid, snapshot.user.nickname, snapshot.ipcCalls);
+                snapshot.userChanged = true;
+                lastUser_ = snapshot.user;
+            }
+        } else {
+            snapshot.user.nickname = UserNickname("ERR#003");
+        }
+
+        totalIpcCalls_ += snapshot.ipcCalls;
+        snapshots_++;
+
+        return snapshot;
+    }
+
+    bool PlatformQuery::fetchNickname(AccountUid uid, UserNickname& nickname, u32& ipcCalls) {
+        // Known users are answered by the profile table without any request
+        bool fetched = false;
+        nickname = ProfileTable::get().find(uid, &fetched).nickname;
+        if(fetched) {
+            ipcCalls += 3;
+        }
+
+        LOG_TRACE(Monitor, "uid=%lu:%lu, Nickname=%s\n", uid.uid[0], uid.uid[1], nickname.c_str());
+
+        return nickname.substr(0, 4) != "ERR#";
+    }
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <switch.h>
+#include "helpers.h"
+
+namespace alefbet::authenticator::srv {
+
+    /*! \brief State of the console as seen by the monitor on a single tick.
+    */
+    struct PlatformSnapshot {
+        u64 pid = 0;                    ///< Running application process ID (0 if none)
+        u64 programId = 0;              ///< Running application program ID
+        structs::UserData user{};       ///< Last opened user
+        bool userChanged = false;       ///< True if the user differs from the previous snapshot
+        u32 ipcCalls = 0;               ///< Number of IPC requests issued to build the snapshot
+    };
+
+    /*! \brief Collects the running application and current user in one pass.
+
+        The account session is kept open for the lifetime of the query and results that
+        cannot have changed are reused: the program ID is only fetched for a new process
+        and the profile only when the last opened user changes.
+    */
+    class PlatformQuery {
+        public:
+            bool open();
+            void close();
+
+            /*! \brief Takes a new snapshot. \p pid can be given when it is already known. */
+            PlatformSnapshot take(u64 pid = 0);
+
+            u64 totalIpcCalls() const {
+                return totalIpcCalls_;
+            }
+
+            u64 snapshots() const {
+                return snapshots_;
+            }
+
+        private:
+            bool fetchNickname(AccountUid uid, UserNickname& nickname, u32& ipcCalls);
+
+        private:
+            bool accountReady_ = false;
+            u64 lastPid_ = 0;
+            u64 lastProgramId_ = 0;
+            structs::UserData lastUser_{};
+            u64 totalIpcCalls_ = 0;
+            u64 snapshots_ = 0;
+    };
+
+}
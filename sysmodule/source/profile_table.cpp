@@ -0,0 +1,125 @@
+#include "profile_table.h"
+#include "logger.h"
+#include "service_manager.h"
+#include <algorithm>
+
+using namespace alefbet::authenticator::logger;
+using namespace alefbet::authenticator::structs;
+using namespace alefbet::authenticator::services;
+
+namespace alefbet::authenticator::helpers {
+
+    bool ProfileTable::fetchProfile(AccountUid uid, AccountProfileBase& base) {
+        auto& services = ServiceManager::get();
+        AccountProfile profile;
+        AccountUserData user_data;
+
+        ::Result rc = services.call(Account, [&] { return accountGetProfile(&profile, uid); });
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Helpers, "Could not get account profile: %i\n", rc);
+            return false;
+        }
+
+        rc = services.call(Account, [&] { return accountProfileGet(&profile, &user_data, &base); });
+        accountProfileClose(&profile);
+
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Helpers, "Could not get user data: %i\n", rc);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ProfileTable::update(AccountUid uid) {
+        AccountProfileBase base;
+        if(!fetchProfile(uid, base)) return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = entries_[uid];
+
+        // Only touch the entry when the profile has been edited
+        if(entry.lastEditTimestamp != base.last_edit_timestamp || entry.nickname.empty()) {
+            entry.nickname = UserNickname(base.nickname);
+            entry.lastEditTimestamp = base.last_edit_timestamp;
+        }
+
+        return true;
+    }
+
+    bool ProfileTable::load() {
+        if(!refresh()) return false;
+
+        LOG_INFO(Helpers, "%lu user profiles loaded\n", size());
+        return true;
+    }
+
+    bool ProfileTable::refresh() {
+        ServiceSession account(Account);
+        if(!account.ready()) return false;
+
+        AccountUid uids[ACC_USER_LIST_SIZE];
+        s32 count = 0;
+        ::Result rc = account.call([&] { return accountListAllUsers(uids, ACC_USER_LIST_SIZE, &count); });
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Helpers, "Could not list users: %i:%i\n", R_MODULE(rc), R_DESCRIPTION(rc));
+            return false;
+        }
+
+        {
+            // Drop the users that have been deleted
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::erase_if(entries_, [&](const auto& item) {
+                return std::none_of(uids, uids + count, [&](const AccountUid& uid) {
+                    return AccountUidEqual{}(uid, item.first);
+                });
+            });
+        }
+
+        for(s32 i = 0; i < count; i++) {
+            update(uids[i]);
+        }
+
+        return true;
+    }
+
+    UserData ProfileTable::find(AccountUid uid, bool* fetched) {
+        UserData user;
+        user.uid = uid;
+
+        if(fetched != nullptr) *fetched = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto& it = entries_.find(uid);
+            if(it != entries_.end()) {
+                user.nickname = it->second.nickname;
+                return user;
+            }
+        }
+
+        // Unknown user, probably created after boot
+        if(fetched != nullptr) *fetched = true;
+
+        ServiceSession account(Account);
+        if(!account.ready()) {
+            user.nickname = UserNickname("ERR#003");
+            return user;
+        }
+
+        if(!update(uid)) {
+            user.nickname = UserNickname("ERR#005");
+            return user;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        user.nickname = entries_[uid].nickname;
+        return user;
+    }
+
+    size_t ProfileTable::size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <switch.h>
+#include <mutex>
+#include <unordered_map>
+#include "helpers.h"
+
+namespace alefbet::authenticator::helpers {
+
+    struct ProfileEntry {
+        UserNickname nickname;
+        u64 lastEditTimestamp = 0;
+    };
+
+    /*! \brief In-memory table of the profiles of all the users of the console.
+
+        The table is filled once at boot from the account user list. Lookups are answered
+        from memory; a user that is not known yet (added after boot) is fetched on the first
+        lookup. refresh() only rewrites the entries whose profile timestamp has changed.
+    */
+    class ProfileTable {
+        public:
+            static ProfileTable& get() {
+                static ProfileTable table;
+
+                return table;
+            }
+
+            /*! \brief Fills the table with all the users of the console. */
+            bool load();
+
+            /*! \brief Updates the entries whose profile has changed and drops deleted users. */
+            bool refresh();
+
+            /*! \brief Returns the user data for \p uid, fetching the profile only if it is unknown. */
+            structs::UserData find(AccountUid uid, bool* fetched = nullptr);
+
+            size_t size();
+
+        private:
+            ProfileTable() = default;
+
+            static bool fetchProfile(AccountUid uid, AccountProfileBase& base);
+            bool update(AccountUid uid);
+
+        private:
+            std::mutex mutex_;
+            std::unordered_map<AccountUid, ProfileEntry, AccountUidHash, AccountUidEqual> entries_;
+    };
+
+}
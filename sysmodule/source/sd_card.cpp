@@ -0,0 +1,252 @@
+#include "sd_card.h"
+#include "logger.h"
+
+using namespace alefbet::authenticator::logger;
+
+namespace alefbet::authenticator::services {
+
+    bool SdCard::ready() {
+        if(ready_.load(std::memory_order_acquire)) return true;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!ready_.load(std::memory_order_relaxed)) {
+            ready_.store(R_SUCCEEDED(fsOpenSdCardFileSystem(&sdmc_)), std::memory_order_release);
+        }
+
+        return ready_.load(std::memory_order_relaxed);
+    }
+
+    FsFileSystem* SdCard::fs() {
+        return &sdmc_;
+    }
+
+    SdCard::CachedFile* SdCard::find(std::string_view path) {
+        for(auto& file : files_) {
+            if(file.lastUse != 0 && file.path == path) return &file;
+        }
+        return nullptr;
+    }
+
+    SdPathStats& SdCard::statsOf(std::string_view path) {
+        auto it = stats_.find(path);
+        if(it == stats_.end()) {
+            it = stats_.emplace(std::string(path), SdPathStats{}).first;
+        }
+        return it->second;
+    }
+
+    void SdCard::closeLocked(std::string_view path) {
+        CachedFile* file = find(path);
+        if(file == nullptr) return;
+
+        fsFileClose(&file->handle);
+        file->lastUse = 0;
+    }
+
+    ::Result SdCard::open(const char* path, u32 mode, SdPathStats& stats, FsFile*& handle) {
+        CachedFile* file = find(path);
+
+        if(file != nullptr && (file->mode & mode) == mode) {
+            stats.hits++;
+        } else {
+            // Reopened with the union of the modes, or a free (or least recently used) entry is taken
+            if(file != nullptr) {
+                mode |= file->mode;
+                fsFileClose(&file->handle);
+                file->lastUse = 0;
+            } else {
+                file = &files_[0];
+                for(auto& candidate : files_) {
+                    if(candidate.lastUse < file->lastUse) file = &candidate;
+                }
+
+                if(file->lastUse != 0) {
+                    fsFileClose(&file->handle);
+                    statsOf(file->path).evictions++;
+                    file->lastUse = 0;
+                }
+            }
+
+            ::Result rc = fsFsOpenFile(&sdmc_, path, mode, &file->handle);
+            if(R_FAILED(rc)) return rc;
+
+            file->path = path;
+            file->mode = mode;
+            stats.opens++;
+        }
+
+        file->lastUse = ++uses_;
+        handle = &file->handle;
+
+        return 0;
+    }
+
+    ::Result SdCard::read(const char* path, s64 offset, void* buffer, u64 size, u64* dataRead) {
+        return withFile(path, FsOpenMode_Read, [&](FsFile* handle, SdPathStats& stats) {
+            ::Result rc = fsFileRead(handle, offset, buffer, size, FsReadOption_None, dataRead);
+
+            stats.reads++;
+            if(R_SUCCEEDED(rc)) stats.bytesRead += *dataRead;
+
+            return rc;
+        });
+    }
+
+    ::Result SdCard::write(const char* path, s64 offset, const void* data, u64 size, u32 option) {
+        return withFile(path, FsOpenMode_Write | FsOpenMode_Append, [&](FsFile* handle, SdPathStats& stats) {
+            ::Result rc = fsFileWrite(handle, offset, data, size, option);
+
+            stats.writes++;
+            if(R_SUCCEEDED(rc)) stats.bytesWritten += size;
+
+            return rc;
+        });
+    }
+
+    ::Result SdCard::getSize(const char* path, s64* size) {
+        return withFile(path, FsOpenMode_Read, [&](FsFile* handle, SdPathStats&) {
+            return fsFileGetSize(handle, size);
+        });
+    }
+
+    ::Result SdCard::setSize(const char* path, s64 size) {
+        return withFile(path, FsOpenMode_Write, [&](FsFile* handle, SdPathStats&) {
+            return fsFileSetSize(handle, size);
+        });
+    }
+
+    ::Result SdCard::flush(const char* path) {
+        if(!ready()) return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        CachedFile* file = find(path);
+        return file != nullptr ? fsFileFlush(&file->handle) : 0;
+    }
+
+    ::Result SdCard::readFile(const char* path, std::vector<u8>& data) {
+        if(!ready()) return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = statsOf(path);
+
+        // A file read once (configuration, database import) does not take a cache entry
+        FsFile uncached;
+        FsFile* handle = &uncached;
+        CachedFile* file = find(path);
+        if(file != nullptr && (file->mode & FsOpenMode_Read)) {
+            file->lastUse = ++uses_;
+            handle = &file->handle;
+            stats.hits++;
+        } else {
+            if(file != nullptr) closeLocked(path);
+
+            ::Result rc = fsFsOpenFile(&sdmc_, path, FsOpenMode_Read, &uncached);
+            if(R_FAILED(rc)) return rc;
+            stats.opens++;
+        }
+
+        s64 size = 0;
+        u64 dataRead = 0;
+        ::Result rc = fsFileGetSize(handle, &size);
+        if(R_SUCCEEDED(rc)) {
+            data.resize(size);
+            rc = fsFileRead(handle, 0, data.data(), size, FsReadOption_None, &dataRead);
+            stats.reads++;
+        }
+
+        if(handle == &uncached) fsFileClose(&uncached);
+
+        if(R_FAILED(rc)) return rc;
+        if(dataRead != static_cast<u64>(size)) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+
+        stats.bytesRead += dataRead;
+        return 0;
+    }
+
+    void SdCard::close(const char* path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeLocked(path);
+    }
+
+    void SdCard::closeAll() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for(auto& file : files_) {
+            if(file.lastUse == 0) continue;
+
+            fsFileClose(&file.handle);
+            file.lastUse = 0;
+        }
+    }
+
+    bool SdCard::exists(const char* path, FsDirEntryType* type) {
+        FsDirEntryType entryType = FsDirEntryType_File;
+        ::Result rc = metadata(path, [&] { return fsFsGetEntryType(&sdmc_, path, &entryType); });
+        if(R_FAILED(rc)) return false;
+
+        if(type != nullptr) *type = entryType;
+        return true;
+    }
+
+    ::Result SdCard::createFile(const char* path, s64 size) {
+        return metadata(path, [&] { return fsFsCreateFile(&sdmc_, path, size, 0); });
+    }
+
+    ::Result SdCard::deleteFile(const char* path) {
+        return metadata(path, [&] {
+            closeLocked(path);
+            return fsFsDeleteFile(&sdmc_, path);
+        });
+    }
+
+    ::Result SdCard::renameFile(const char* from, const char* to) {
+        return metadata(from, [&] {
+            closeLocked(from);
+            closeLocked(to);
+            return fsFsRenameFile(&sdmc_, from, to);
+        });
+    }
+
+    ::Result SdCard::createDirectory(const char* path) {
+        return metadata(path, [&] { return fsFsCreateDirectory(&sdmc_, path); });
+    }
+
+    ::Result SdCard::openDirectory(const char* path, u32 mode, FsDir* dir) {
+        return metadata(path, [&] { return fsFsOpenDirectory(&sdmc_, path, mode, dir); });
+    }
+
+    ::Result SdCard::getTimeStamp(const char* path, FsTimeStampRaw* timestamp) {
+        return metadata(path, [&] { return fsFsGetFileTimeStampRaw(&sdmc_, path, timestamp); });
+    }
+
+    SdPathStats SdCard::stats(const char* path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        const auto& it = stats_.find(std::string_view(path));
+        return it != stats_.end() ? it->second : SdPathStats{};
+    }
+
+    void SdCard::logStats() {
+        // Copied first: logging may write to the SD card
+        std::map<std::string, SdPathStats, std::less<>> stats;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats = stats_;
+        }
+
+        for(const auto& [path, pathStats] : stats) {
+            LOG_INFO(Services, "%s: opens=%u, hits=%u, evictions=%u, reads=%u (%lu bytes), writes=%u (%lu bytes), metadata=%u\n",
+                path.c_str(),
+                pathStats.opens,
+                pathStats.hits,
+                pathStats.evictions,
+                pathStats.reads,
+                pathStats.bytesRead,
+                pathStats.writes,
+                pathStats.bytesWritten,
+                pathStats.metadataOps);
+        }
+    }
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <switch.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Number of files kept open, can be overridden per deployment (make DEFINES="-DSD_CACHED_FILES=...") */
+#ifndef SD_CACHED_FILES
+#define SD_CACHED_FILES 4
+#endif
+
+namespace alefbet::authenticator::services {
+
+    struct SdPathStats {
+        u32 opens = 0;              ///< Handles actually opened
+        u32 hits = 0;               ///< Operations served by a handle that was already open
+        u32 evictions = 0;          ///< Handles closed to make room for another file
+        u32 reads = 0;
+        u32 writes = 0;
+        u32 metadataOps = 0;        ///< Create, delete, rename, entry type and directory requests
+        u64 bytesRead = 0;
+        u64 bytesWritten = 0;
+    };
+
+    /*! \brief Single SD card session shared by the sysmodule.
+
+        File handles are kept open between operations in a small cache (SD_CACHED_FILES), the least
+        recently used one being closed when another file is needed. Deleting or renaming a file
+        closes its handle first since the file system refuses to do it on an open file. Every
+        request is counted per path.
+
+        Operations take the lock of the cache for their duration: a handle cannot be closed by
+        another thread while it is being used.
+    */
+    class SdCard {
+        public:
+            static SdCard& get() {
+                static SdCard sdcard;
+
+                return sdcard;
+            }
+
+            bool ready();
+
+            /*! \brief The raw session, for the crash path which must not wait for the lock. */
+            FsFileSystem* fs();
+
+            ::Result read(const char* path, s64 offset, void* buffer, u64 size, u64* dataRead);
+            ::Result write(const char* path, s64 offset, const void* data, u64 size, u32 option = FsWriteOption_None);
+            ::Result getSize(const char* path, s64* size);
+            ::Result setSize(const char* path, s64 size);
+            ::Result flush(const char* path);
+
+            /*! \brief Reads a whole file. A file that was not open already is closed afterwards. */
+            ::Result readFile(const char* path, std::vector<u8>& data);
+
+            /*! \brief Closes the handle of \p path if it is open, it will be reopened on next use. */
+            void close(const char* path);
+            void closeAll();
+
+            bool exists(const char* path, FsDirEntryType* type = nullptr);
+            ::Result createFile(const char* path, s64 size);
+            ::Result deleteFile(const char* path);
+            ::Result renameFile(const char* from, const char* to);
+            ::Result createDirectory(const char* path);
+            ::Result openDirectory(const char* path, u32 mode, FsDir* dir);
+            ::Result getTimeStamp(const char* path, FsTimeStampRaw* timestamp);
+
+            SdPathStats stats(const char* path);
+            void logStats();
+
+        private:
+            SdCard() = default;
+
+            struct CachedFile {
+                std::string path;
+                u32 mode = 0;
+                FsFile handle;
+                u64 lastUse = 0;
+            };
+
+            /* Called with the lock held */
+            ::Result open(const char* path, u32 mode, SdPathStats& stats, FsFile*& handle);
+            CachedFile* find(std::string_view path);
+            void closeLocked(std::string_view path);
+            SdPathStats& statsOf(std::string_view path);
+
+            template<typename F>
+            ::Result withFile(const char* path, u32 mode, F&& func) {
+                if(!ready()) return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto& stats = statsOf(path);
+
+                FsFile* handle = nullptr;
+                ::Result rc = open(path, mode, stats, handle);
+                if(R_FAILED(rc)) return rc;
+
+                return func(handle, stats);
+            }
+
+            template<typename F>
+            ::Result metadata(const char* path, F&& func) {
+                if(!ready()) return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                statsOf(path).metadataOps++;
+
+                return func();
+            }
+
+        private:
+            std::mutex mutex_;
+            std::atomic<bool> ready_ = false;
+            FsFileSystem sdmc_;
+            CachedFile files_[SD_CACHED_FILES];
+            u64 uses_ = 0;
+            std::map<std::string, SdPathStats, std::less<>> stats_;
+    };
+
+}
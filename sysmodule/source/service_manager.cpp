@@ -0,0 +1,127 @@
+#include "service_manager.h"
+#include "logger.h"
+#include <algorithm>
+
+using namespace alefbet::authenticator::logger;
+
+constexpr const char* ServiceNames[] = { "account", "ns", "time", "hid", "hid:sys" };
+
+namespace alefbet::authenticator::services {
+
+    ::Result LibnxServiceDriver::initialize(ServiceId id) {
+        switch(id) {
+            case Account:   return accountInitialize(AccountServiceType_Administrator);
+            case Ns:        return nsInitialize();
+            case Time:      return timeInitialize();
+            case Hid:       return hidInitialize();
+            case HidSys:    return hidsysInitialize();
+            default:        return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+        }
+    }
+
+    void LibnxServiceDriver::exit(ServiceId id) {
+        switch(id) {
+            case Account:   accountExit(); break;
+            case Ns:        nsExit(); break;
+            case Time:      timeExit(); break;
+            case Hid:       hidExit(); break;
+            case HidSys:    hidsysExit(); break;
+            default:        break;
+        }
+    }
+
+    void ServiceManager::setDriver(ServiceDriver* driver) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        driver_ = driver != nullptr ? driver : &libnxDriver_;
+    }
+
+    bool ServiceManager::acquire(ServiceId id) {
+        std::lock_guard<std::mutex> session(sessionMutexes_[id]);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = stats_[id];
+
+        if(stats.refCount == 0) {
+            ::Result rc = driver_->initialize(id);
+            if(R_FAILED(rc)) {
+                LOG_ERROR(Services, "Could not open %s: %i:%i\n", ServiceNames[id], R_MODULE(rc), R_DESCRIPTION(rc));
+                stats.failures++;
+                return false;
+            }
+            stats.opens++;
+        }
+
+        stats.refCount++;
+        return true;
+    }
+
+    void ServiceManager::release(ServiceId id) {
+        std::lock_guard<std::mutex> session(sessionMutexes_[id]);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = stats_[id];
+
+        if(stats.refCount == 0) return;
+
+        if(--stats.refCount == 0) {
+            driver_->exit(id);
+        }
+    }
+
+    bool ServiceManager::isSessionFailure(::Result rc) {
+        // Errors coming from the kernel mean the session itself is broken
+        return R_MODULE(rc) == Module_Kernel;
+    }
+
+    bool ServiceManager::reconnect(ServiceId id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = stats_[id];
+
+        if(stats.refCount == 0) return false;
+
+        LOG_WARN(Services, "Reconnecting to %s\n", ServiceNames[id]);
+
+        driver_->exit(id);
+        ::Result rc = driver_->initialize(id);
+        if(R_FAILED(rc)) {
+            LOG_ERROR(Services, "Could not reopen %s: %i:%i\n", ServiceNames[id], R_MODULE(rc), R_DESCRIPTION(rc));
+            stats.failures++;
+            return false;
+        }
+
+        stats.opens++;
+        stats.reconnects++;
+        return true;
+    }
+
+    void ServiceManager::recordCall(ServiceId id, u64 elapsedNs, ::Result rc) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = stats_[id];
+
+        stats.calls++;
+        stats.totalCallNs += elapsedNs;
+        stats.maxCallNs = std::max(stats.maxCallNs, elapsedNs);
+        if(R_FAILED(rc)) {
+            stats.failures++;
+        }
+    }
+
+    ServiceStats ServiceManager::stats(ServiceId id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_[id];
+    }
+
+    void ServiceManager::logStats() {
+        for(int id = 0; id < ServiceCount; id++) {
+            const auto& stats = this->stats(static_cast<ServiceId>(id));
+            LOG_INFO(Services, "%s: refs=%u, opens=%u, reconnects=%u, failures=%u, calls=%lu, avg=%lu us, max=%lu us\n",
+                ServiceNames[id],
+                stats.refCount,
+                stats.opens,
+                stats.reconnects,
+                stats.failures,
+                stats.calls,
+                stats.calls > 0 ? stats.totalCallNs / stats.calls / 1000 : 0,
+                stats.maxCallNs / 1000);
+        }
+    }
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <switch.h>
+#include <mutex>
+
+namespace alefbet::authenticator::services {
+
+    typedef enum {
+        Account,
+        Ns,
+        Time,
+        Hid,
+        HidSys,
+        ServiceCount
+    } ServiceId;
+
+    /*! \brief Opens and closes the actual service sessions.
+    */
+    class ServiceDriver {
+        public:
+            virtual ~ServiceDriver() = default;
+            virtual ::Result initialize(ServiceId id) = 0;
+            virtual void exit(ServiceId id) = 0;
+    };
+
+    /*! \brief Service sessions provided by libnx.
+    */
+    class LibnxServiceDriver : public ServiceDriver {
+        public:
+            ::Result initialize(ServiceId id) override;
+            void exit(ServiceId id) override;
+    };
+
+    struct ServiceStats {
+        u32 refCount = 0;
+        u32 opens = 0;              ///< Number of sessions actually opened
+        u32 failures = 0;           ///< Failed opens and failed calls
+        u32 reconnects = 0;
+        u64 calls = 0;
+        u64 totalCallNs = 0;
+        u64 maxCallNs = 0;
+    };
+
+    /*! \brief Keeps the service sessions open across calls.
+
+        Sessions are reference counted: the first acquire() opens the session and the last
+        release() closes it. Long-lived users (the monitor, the GUI) hold a reference for the
+        lifetime of the sysmodule so that helpers do not go back to the service manager on
+        every call. A session is reopened when a call fails at the kernel level.
+        Calls to a service are serialized by a lock of their own, which the reconnection and
+        the opening and closing of the session also hold: a session is never closed under a call,
+        and concurrent failures reconnect once.
+    */
+    class ServiceManager {
+        public:
+            static ServiceManager& get() {
+                static ServiceManager manager;
+
+                return manager;
+            }
+
+            /*! \brief Replaces the driver. Must be called before any session is opened. */
+            void setDriver(ServiceDriver* driver);
+
+            bool acquire(ServiceId id);
+            void release(ServiceId id);
+
+            /*! \brief Runs \p func on the service, records its latency and reconnects once on session failure. */
+            template<typename F>
+            ::Result call(ServiceId id, F&& func) {
+                std::lock_guard<std::mutex> session(sessionMutexes_[id]);
+
+                const u64 start = armGetSystemTick();
+                ::Result rc = func();
+                recordCall(id, armTicksToNs(armGetSystemTick() - start), rc);
+
+                if(R_FAILED(rc) && isSessionFailure(rc) && reconnect(id)) {
+                    rc = func();
+                }
+
+                return rc;
+            }
+
+            ServiceStats stats(ServiceId id);
+            void logStats();
+
+        private:
+            ServiceManager() = default;
+
+            static bool isSessionFailure(::Result rc);
+
+            /*! \brief Reopens the session, called with its lock held. Returns false if it was closed or could not be reopened. */
+            bool reconnect(ServiceId id);
+            void recordCall(ServiceId id, u64 elapsedNs, ::Result rc);
+
+        private:
+            std::mutex mutex_;                          ///< Driver and statistics
+            std::mutex sessionMutexes_[ServiceCount];   ///< Taken before mutex_
+            LibnxServiceDriver libnxDriver_;
+            ServiceDriver* driver_ = &libnxDriver_;
+            ServiceStats stats_[ServiceCount];
+    };
+
+    /*! \brief Holds a reference on a service for the lifetime of the object.
+    */
+    class ServiceSession {
+        public:
+            ServiceSession(ServiceId id)
+            : id_(id), ready_(ServiceManager::get().acquire(id)) {}
+
+            ~ServiceSession() {
+                if(ready_) ServiceManager::get().release(id_);
+            }
+
+            ServiceSession(const ServiceSession&) = delete;
+            ServiceSession& operator=(const ServiceSession&) = delete;
+
+            bool ready() const {
+                return ready_;
+            }
+
+            template<typename F>
+            ::Result call(F&& func) {
+                return ServiceManager::get().call(id_, std::forward<F>(func));
+            }
+
+        private:
+            ServiceId id_;
+            bool ready_ = false;
+    };
+
+}
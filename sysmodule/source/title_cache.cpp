@@ -0,0 +1,186 @@
+#include "title_cache.h"
+#include "logger.h"
+#include "service_manager.h"
+#include "sd_card.h"
+#include "database/database.h"
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+using namespace alefbet::authenticator::logger;
+using namespace alefbet::authenticator::services;
+
+static const char* CACHE_FILENAME = "/config/authenticator/titles.bin";
+
+constexpr u32 CacheMagic = 0x43544141; // "AATC"
+constexpr u32 CacheVersion = 2;
+
+namespace alefbet::authenticator::helpers {
+    /* File layout: header, then for each entry the title id, the name length and the name (not terminated) */
+    struct CacheHeader {
+        u32 magic;
+        u32 version;
+        u32 count;
+        u32 crc;                ///< CRC32 of the entries
+    };
+
+    static bool validCache(const std::vector<u8>& data) {
+        if(data.size() < sizeof(CacheHeader)) return false;
+
+        CacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        return header.magic == CacheMagic && header.version == CacheVersion
+            && crc32Calculate(data.data() + sizeof(header), data.size() - sizeof(header)) == header.crc;
+    }
+
+    static bool prepare() {
+        if(SdCard::get().ready()) return true;
+
+        LOG_ERROR(Helpers, "Could not get access to SD card\n");
+        return false;
+    }
+
+    bool TitleCache::load() {
+        if(!prepare()) return false;
+
+        database::recoverFile(CACHE_FILENAME, validCache);
+
+        if(!SdCard::get().exists(CACHE_FILENAME)) {
+            // No cache yet
+            return true;
+        }
+
+        std::vector<u8> data;
+        if(R_FAILED(SdCard::get().readFile(CACHE_FILENAME, data))) {
+            LOG_ERROR(Helpers, "Could not read the title cache\n");
+            return false;
+        }
+
+        if(!validCache(data)) {
+            LOG_WARN(Helpers, "Ignoring incompatible title cache\n");
+            return false;
+        }
+
+        CacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        size_t offset = sizeof(header);
+        for(u32 i = 0; i < header.count; i++) {
+            u64 titleId = 0;
+            u16 length = 0;
+
+            if(offset + sizeof(titleId) + sizeof(length) > data.size()) break;
+            std::memcpy(&titleId, &data[offset], sizeof(titleId));
+            offset += sizeof(titleId);
+            std::memcpy(&length, &data[offset], sizeof(length));
+            offset += sizeof(length);
+
+            if(offset + length > data.size()) break;
+            names_[titleId] = std::string(reinterpret_cast<const char*>(&data[offset]), length);
+            offset += length;
+        }
+
+        LOG_INFO(Helpers, "%lu titles loaded from cache\n", names_.size());
+        return true;
+    }
+
+    bool TitleCache::save() {
+        if(!prepare()) return false;
+
+        std::vector<u8> data(sizeof(CacheHeader));
+
+        for(const auto& [titleId, name]: names_) {
+            const u16 length = static_cast<u16>(std::min<size_t>(name.size(), UINT16_MAX));
+            const auto* id = reinterpret_cast<const u8*>(&titleId);
+            const auto* len = reinterpret_cast<const u8*>(&length);
+
+            data.insert(data.end(), id, id + sizeof(titleId));
+            data.insert(data.end(), len, len + sizeof(length));
+            data.insert(data.end(), name.begin(), name.begin() + length);
+        }
+
+        CacheHeader header = { CacheMagic, CacheVersion, static_cast<u32>(names_.size()), 0 };
+        header.crc = crc32Calculate(data.data() + sizeof(header), data.size() - sizeof(header));
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        // Replaced atomically, a crash while saving leaves the previous cache
+        database::createDataDirectory();
+        if(!database::commitFile(CACHE_FILENAME, data.data(), data.size())) {
+            LOG_ERROR(Helpers, "Could not write the title cache\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TitleCache::fetch(u64 titleId, std::string& name) {
+        ServiceSession ns(Ns);
+        if(!ns.ready()) return false;
+
+        // Only the NACP is needed, it is stored before the icon
+        auto nacp = std::make_unique<NacpStruct>();
+        u64 actual_size = 0;
+        ::Result rc = ns.call([&] {
+            return nsGetApplicationControlData(NsApplicationControlSource_Storage, titleId, reinterpret_cast<NsApplicationControlData*>(nacp.get()), sizeof(NacpStruct), &actual_size);
+        });
+
+        if(R_FAILED(rc)) {
+            // Some firmwares refuse a buffer smaller than the whole control data
+            auto control = std::make_unique<NsApplicationControlData>();
+            rc = ns.call([&] {
+                return nsGetApplicationControlData(NsApplicationControlSource_Storage, titleId, control.get(), sizeof(NsApplicationControlData), &actual_size);
+            });
+
+            if(R_FAILED(rc)) {
+                return false;
+            }
+
+            std::memcpy(nacp.get(), &control->nacp, sizeof(NacpStruct));
+        }
+
+        NacpLanguageEntry* langEntry = nullptr;
+        rc = nacpGetLanguageEntry(nacp.get(), &langEntry);
+        if(R_FAILED(rc) || langEntry == nullptr) {
+            return false;
+        }
+
+        name = std::string(langEntry->name, strnlen(langEntry->name, sizeof(langEntry->name)));
+        return true;
+    }
+
+    std::string TitleCache::name(u64 titleId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(!loaded_) {
+            load();
+            loaded_ = true;
+        }
+
+        const auto& it = names_.find(titleId);
+        if(it != names_.end()) {
+            stats_.hits++;
+            return it->second;
+        }
+
+        stats_.misses++;
+
+        std::string name;
+        if(!fetch(titleId, name)) {
+            LOG_ERROR(Helpers, "Could not get application control data for title %s\n", titleIdToString(titleId).c_str());
+            stats_.failures++;
+            return "Unknown";
+        }
+
+        names_[titleId] = name;
+        save();
+
+        return name;
+    }
+
+    TitleCacheStats TitleCache::stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <switch.h>
+#include <string>
+#include "helpers.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace alefbet::authenticator::helpers {
+
+    struct TitleCacheStats {
+        u64 hits = 0;
+        u64 misses = 0;
+        u64 failures = 0;       ///< Misses that could not be resolved by ns
+    };
+
+    /*! \brief Cache of application names keyed by title id.
+
+        The cache is kept in memory and persisted in a compact binary file on the SD card,
+        so a title is only looked up in ns the first time it is seen. Misses only read the
+        NACP part of the control data (the icon is never transferred).
+    */
+    class TitleCache {
+        public:
+            static TitleCache& get() {
+                static TitleCache cache;
+
+                return cache;
+            }
+
+            /*! \brief Returns the name of the title, or "Unknown" if it cannot be found. */
+            std::string name(u64 titleId);
+
+            TitleCacheStats stats();
+
+        private:
+            TitleCache() = default;
+
+            bool load();
+            bool save();
+            bool fetch(u64 titleId, std::string& name);
+
+        private:
+            std::mutex mutex_;
+            bool loaded_ = false;
+            std::unordered_map<u64, std::string> names_;
+            TitleCacheStats stats_;
+    };
+
+}
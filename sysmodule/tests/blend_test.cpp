@@ -0,0 +1,67 @@
+#include <cstdlib>
+#include <vector>
+#include "test.h"
+#include "gui/blend.hpp"
+
+/* The integer blending gives the same pixels as the floating point blending it replaced, for the single pixels
+   and for the runs. The test is built with the NEON emulation of host/neon so that the vector path of blendRun
+   is checked on any host. */
+
+using namespace alefbet::authenticator::gfx;
+
+#ifndef __ARM_NEON
+#error "the test is built with -D__ARM_NEON, see the Makefile"
+#endif
+
+/* The blending of the renderer before the integer kernels */
+static u8 referenceChannel(u8 src, u8 dst, u8 alpha) {
+    const u8 oneMinusAlpha = 0x0F - alpha;
+    return (dst * alpha + src * oneMinusAlpha) / float(0xF);
+}
+
+static u16 referencePixel(u16 pixel, u16 color) {
+    u16 end = std::min((pixel >> 12) + (color >> 12), 0xF) << 12;
+
+    for(u32 shift = 0; shift < 12; shift += 4) {
+        end |= referenceChannel((pixel >> shift) & 0xF, (color >> shift) & 0xF, color >> 12) << shift;
+    }
+
+    return end;
+}
+
+int main() {
+    // div15 covers every sum of two products of 4 bits channels
+    for(u16 n = 0; n <= 0xF * 0xF; n++) {
+        CHECK(div15(n) == n / 15);
+    }
+
+    // Every pixel, under every alpha and a spread of colors
+    u32 mismatches = 0;
+    for(u32 pixel = 0; pixel < 0x10000; pixel++) {
+        for(u32 color = pixel % 7; color < 0x10000; color += 7) {
+            if(blendPixel(pixel, color) != referencePixel(pixel, color)) mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    // Runs of any length and alignment, through the vector loop and the remaining pixels
+    std::srand(1);
+    std::vector<u16> run(512), expected;
+    for(int i = 0; i < 5000; i++) {
+        for(auto& pixel : run) pixel = std::rand();
+        expected = run;
+
+        const u16 color = std::rand();
+        const u32 offset = std::rand() % 16;
+        const u32 count = std::rand() % (run.size() - offset);
+
+        blendRun(run.data() + offset, count, color);
+        for(u32 p = offset; p < offset + count; p++) {
+            expected[p] = referencePixel(expected[p], color);
+        }
+
+        CHECK(run == expected);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* Latency and SD card requests of a save of the password database: the atomic commit against the sequence it
+   replaced (delete, create, open, write, close), for the file sizes of 8 and 1000 users. The commit costs the
+   deletion of a leftover and the rename, so that a complete database exists at any time. The SD card is a
+   directory of the host. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+constexpr const char* Path = "/config/authenticator/bench.json";
+constexpr const char* TmpPath = "/config/authenticator/bench.json.tmp";
+constexpr u32 Saves = 200;
+
+static u32 requests(const SdPathStats& stats) {
+    return stats.metadataOps + stats.opens + stats.writes;
+}
+
+static u32 requests() {
+    auto& sdcard = SdCard::get();
+    return requests(sdcard.stats(Path)) + requests(sdcard.stats(TmpPath));
+}
+
+template<typename F>
+static void measure(const char* name, const std::vector<u8>& data, F&& save) {
+    const u32 before = requests();
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Saves; i++) save(data);
+    const double us = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / Saves;
+
+    std::printf("  %-22s %7zu bytes  %8.1f us  %5.1f SD requests\n", name, data.size(), us, double(requests() - before) / Saves);
+}
+
+int main() {
+    createDataDirectory();
+
+    std::printf("Saves of the password database (per save)\n");
+    for(u32 users : { 8u, 1000u }) {
+        // The size of the JSON file of that many users
+        const std::vector<u8> data(users * 96 + 16, 'x');
+
+        measure("delete and rewrite", data, [](const std::vector<u8>& data) {
+            auto& sdcard = SdCard::get();
+            sdcard.deleteFile(Path);
+            sdcard.createFile(Path, 0);
+            sdcard.write(Path, 0, data.data(), data.size(), FsWriteOption_Flush);
+            sdcard.close(Path);
+        });
+        measure("atomic commit", data, [](const std::vector<u8>& data) {
+            commitFile(Path, data.data(), data.size());
+        });
+    }
+
+    return 0;
+}
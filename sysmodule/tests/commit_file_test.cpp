@@ -0,0 +1,134 @@
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+#include "title_cache.h"
+
+/* A commit replaces a file with a single write and a rename. A temporary file left by a crash is renamed over a
+   missing original only if its content is complete, a preallocated file which never received its data is
+   deleted instead of replacing the credentials or the title cache. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::services;
+
+constexpr const char* LogPath = "/config/authenticator/passwords.log";
+constexpr const char* LogTmpPath = "/config/authenticator/passwords.log.tmp";
+constexpr const char* ShardsDir = "/config/authenticator/shards";
+constexpr const char* ShardTmpPath = "/config/authenticator/shards/00000000000011110000000000002222.bin.tmp";
+constexpr const char* CachePath = "/config/authenticator/titles.bin";
+constexpr const char* CacheTmpPath = "/config/authenticator/titles.bin.tmp";
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+
+static std::vector<u8> readFile(const char* path) {
+    std::vector<u8> data;
+    SdCard::get().readFile(path, data);
+    return data;
+}
+
+static void writeFile(const char* path, const std::vector<u8>& data) {
+    auto& sdcard = SdCard::get();
+    sdcard.deleteFile(path);
+    sdcard.createFile(path, data.size());
+    sdcard.write(path, 0, data.data(), data.size(), FsWriteOption_Flush);
+    sdcard.close(path);
+}
+
+/* What is left when the data of a commit never reached the card: the preallocated file, full of zeroes */
+static void preallocate(const char* path, size_t size) {
+    writeFile(path, std::vector<u8>(size, 0));
+}
+
+int main() {
+    auto& sdcard = SdCard::get();
+    CHECK(createDataDirectory());
+
+    // Left by the previous tests
+    sdcard.deleteFile(LogPath);
+    sdcard.deleteFile(CachePath);
+
+    // A commit: delete the leftover, create, write, delete the original, rename
+    const std::vector<u8> json = { '{', '}' };
+    CHECK(commitFile("/config/authenticator/commit.json", json.data(), json.size()));
+    CHECK(commitStats().commits == 1);
+    CHECK(commitStats().lastMetadataOps == 5);
+    CHECK(commitStats().bytesWritten == json.size());
+    CHECK(readFile("/config/authenticator/commit.json") == json);
+    CHECK(!sdcard.exists("/config/authenticator/commit.json.tmp"));
+
+    // A log of two users, compacted
+    CredentialIndex passwords;
+    passwords.insert(Alice, Credential::fromPassword("AAAA"));
+    passwords.insert(Bob, Credential::fromPassword("BBBB"));
+    {
+        CredentialLog log(LogPath);
+        CHECK(!log.replay(passwords));
+        CHECK(log.rewrite(passwords));
+    }
+    const auto& compacted = readFile(LogPath);
+    CHECK(compacted.size() == 8 + 2 * 96);
+
+    // The crash came before the original was deleted: the original stays
+    preallocate(LogTmpPath, compacted.size());
+    {
+        CredentialLog log(LogPath);
+        CHECK(log.replay(passwords));
+        CHECK(passwords.size() == 2);
+        CHECK(!sdcard.exists(LogTmpPath));
+    }
+
+    // The crash came between the deletion and the rename, the new log is complete: it is renamed
+    sdcard.renameFile(LogPath, LogTmpPath);
+    {
+        CredentialLog log(LogPath);
+        CHECK(log.replay(passwords));
+        CHECK(passwords.size() == 2);
+        CHECK(readFile(LogPath) == compacted);
+        CHECK(!sdcard.exists(LogTmpPath));
+    }
+
+    // The same, but the data was never written: it is deleted rather than read as a log of no user
+    sdcard.deleteFile(LogPath);
+    preallocate(LogTmpPath, compacted.size());
+    {
+        CredentialLog log(LogPath);
+        CHECK(!log.replay(passwords));
+        CHECK(!sdcard.exists(LogPath));
+        CHECK(!sdcard.exists(LogTmpPath));
+    }
+
+    // Only a part of the data was written
+    auto partial = compacted;
+    std::fill(partial.begin() + 8 + 96, partial.end(), 0);
+    writeFile(LogTmpPath, partial);
+    {
+        CredentialLog log(LogPath);
+        CHECK(!log.replay(passwords));
+        CHECK(!sdcard.exists(LogTmpPath));
+    }
+
+    // The shard of a user
+    CHECK(R_SUCCEEDED(sdcard.createDirectory(ShardsDir)));
+    preallocate(ShardTmpPath, 104);
+    {
+        CredentialShards shards(ShardsDir);
+        CHECK(shards.replay(passwords));
+        CHECK(!sdcard.exists(ShardTmpPath));
+        CHECK(!sdcard.exists("/config/authenticator/shards/00000000000011110000000000002222.bin"));
+
+        // The previous shard was deleted by the commit, the account cannot fall back to having no PIN
+        CHECK(passwords.size() == 1);
+        CHECK(passwords.find(Alice) != nullptr && passwords.find(Alice)->kind == Credential::Locked);
+    }
+
+    // The title cache, the next lookups go to ns
+    preallocate(CacheTmpPath, 64);
+    CHECK(TitleCache::get().name(0x0100000000DEAD00) == "Unknown");
+    CHECK(!sdcard.exists(CacheTmpPath));
+    CHECK(!sdcard.exists(CachePath));
+
+    return TEST_RESULT();
+}
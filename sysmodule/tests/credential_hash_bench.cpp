@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <chrono>
+#include "host/host_nx.h"
+#include "credential_hash.h"
+
+/* Calibration curve of the PIN hashing: time of a derivation against its iteration count, then the count the
+   calibration would choose for a few budgets and the time it actually takes, and the cost of a verification
+   answered by the session cache. The figures are for the host, the calibration runs on the console. */
+
+using namespace alefbet::authenticator::database;
+
+constexpr AccountUid User = { { 0x1111, 0x2222 } };
+constexpr u32 CalibrationIterations = 1024;
+
+static double deriveMs(u32 iterations) {
+    const u8 salt[CredentialSaltSize] = {};
+    u8 key[CredentialKeySize];
+
+    const auto& start = std::chrono::steady_clock::now();
+    pbkdf2Sha256("16,32,1,2", salt, sizeof(salt), iterations, key, sizeof(key));
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+int main() {
+    std::printf("PIN derivation\n");
+    std::printf("  %10s %10s %12s\n", "iterations", "ms", "ns/iteration");
+    for(u32 iterations = 1024; iterations <= 1'048'576; iterations *= 4) {
+        const double ms = deriveMs(iterations);
+        std::printf("  %10u %10.2f %12.1f\n", iterations, ms, ms * 1e6 / iterations);
+    }
+
+    // As CredentialHasher::calibrate(): a single derivation of CalibrationIterations, scaled to the budget
+    const double calibrationMs = deriveMs(CalibrationIterations);
+    std::printf("Calibration (%u iterations in %.2f ms)\n", CalibrationIterations, calibrationMs);
+    std::printf("  %10s %10s %10s\n", "budget ms", "iterations", "ms");
+    for(u32 budget : { 10u, 25u, 50u, 100u, 250u }) {
+        const u32 iterations = std::clamp<u32>(budget * CalibrationIterations / calibrationMs, 1024, 1'000'000);
+        std::printf("  %10u %10u %10.2f\n", budget, iterations, deriveMs(iterations));
+    }
+
+    auto& hasher = CredentialHasher::get();
+    const auto& credential = hasher.protect(User, "16,32,1,2");
+    hasher.forget(User);
+
+    auto start = std::chrono::steady_clock::now();
+    hasher.verify(User, credential, "16,32,1,2");
+    const double derivedUs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+
+    start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < 1000; i++) hasher.verify(User, credential, "16,32,1,2");
+    const double cachedUs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+
+    std::printf("Verification (%u iterations for %u ms)\n", hasher.iterations(), PIN_HASH_BUDGET_MS);
+    std::printf("  derived %10.1f us\n  cached  %10.1f us\n", derivedUs, cachedUs);
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <string>
+#include "test.h"
+#include "host/host_nx.h"
+#include "credential_hash.h"
+
+/* PBKDF2-HMAC-SHA256 matches the published vectors, hashes survive their textual form, and the hasher accepts
+   the right PIN only, from the session cache once verified. */
+
+using namespace alefbet::authenticator::database;
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+
+static std::string hex(const u8* data, size_t size) {
+    std::string out;
+    char digits[3];
+    for(size_t i = 0; i < size; i++) {
+        std::snprintf(digits, sizeof(digits), "%02x", data[i]);
+        out += digits;
+    }
+    return out;
+}
+
+static std::string derive(std::string_view password, std::string_view salt, u32 iterations, size_t size) {
+    u8 key[64];
+    pbkdf2Sha256(password, reinterpret_cast<const u8*>(salt.data()), salt.size(), iterations, key, size);
+    return hex(key, size);
+}
+
+int main() {
+    // RFC 7914 section 11, and the vectors of the SHA-256 variant of RFC 6070
+    CHECK(derive("passwd", "salt", 1, 64) == "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+                                             "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783");
+    CHECK(derive("password", "salt", 1, 32) == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+    CHECK(derive("password", "salt", 2, 32) == "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43");
+    CHECK(derive("password", "salt", 4096, 32) == "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+    CHECK(derive("passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 40)
+        == "348c89dbcbd32b2f32d814b8116e84cf2b17347ebc1800181c4e2a1fb8dd53e1c635518c7dac47e9");
+
+    const u8 a[4] = { 1, 2, 3, 4 }, b[4] = { 1, 2, 3, 5 };
+    CHECK(constantTimeEqual(a, a, sizeof(a)));
+    CHECK(!constantTimeEqual(a, b, sizeof(a)));
+
+    // The hasher: calibrated within its range, salted, the right PIN only
+    auto& hasher = CredentialHasher::get();
+    CHECK(hasher.iterations() >= 1024 && hasher.iterations() <= 1'000'000);
+
+    const auto& alice = hasher.protect(Alice, "16,32,1,2");
+    const auto& again = hasher.protect(Alice, "16,32,1,2");
+    CHECK(alice.kind == Credential::Hashed);
+    CHECK(std::memcmp(alice.hash().salt, again.hash().salt, CredentialSaltSize) != 0);
+    CHECK(std::memcmp(alice.hash().key, again.hash().key, CredentialKeySize) != 0);
+
+    CHECK(hasher.verify(Alice, alice, "16,32,1,2"));
+    CHECK(!hasher.verify(Alice, alice, "16,32,1,4"));
+    CHECK(!hasher.verify(Alice, alice, ""));
+
+    // Without the session cache the derivation gives the same answers
+    hasher.forget(Alice);
+    CHECK(!hasher.verify(Alice, alice, "16,32,1,4"));
+    CHECK(hasher.verify(Alice, alice, "16,32,1,2"));
+
+    // The cache of a user does not verify the credential of another one
+    CHECK(!hasher.verify(Bob, alice, "16,32,1,4"));
+    CHECK(hasher.verify(Bob, alice, "16,32,1,2"));
+
+    // The textual form, and counts which this module would not have written
+    CredentialHash decoded;
+    CHECK(decodeCredentialHash(encodeCredentialHash(alice.hash()), decoded));
+    CHECK(std::memcmp(&decoded, alice.data, sizeof(decoded)) == 0);
+    CHECK(hasher.verify(Bob, Credential::fromHash(decoded), "16,32,1,2"));
+
+    auto hash = alice.hash();
+    for(u32 iterations : { 0u, 1023u, 1'000'001u }) {
+        hash.iterations = iterations;
+        CHECK(!decodeCredentialHash(encodeCredentialHash(hash), decoded));
+        CHECK(!hasher.verify(Bob, Credential::fromHash(hash), "16,32,1,2"));
+    }
+    CHECK(!decodeCredentialHash("pbkdf2-sha256$2000$00", decoded));
+    CHECK(!decodeCredentialHash("16,32,1,2", decoded));
+
+    // Plain and other credentials
+    CHECK(hasher.verify(Alice, Credential::fromPassword("1,2"), "1,2"));
+    CHECK(!hasher.verify(Alice, Credential::fromPassword("1,2"), "1,3"));
+    CHECK(!hasher.verify(Alice, Credential::fromPassword("1,2"), "1,2,"));
+    CHECK(!hasher.verify(Alice, Credential::locked(), ""));
+    CHECK(!hasher.verify(Alice, Credential(), ""));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "host/host_nx.h"
+#include "credential_index.h"
+
+/* Lookups and inserts of the credential index, against the map of strings it replaced: keyed by the uid as text
+   ("high:low"), which every request had to format, holding the encoded PIN. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::helpers;
+
+constexpr u32 Requests = 1'000'000;
+
+static volatile u32 g_sink;
+
+template<typename F>
+static double measure(F&& request) {
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Requests; i++) request(i);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / Requests;
+}
+
+int main() {
+    const auto& credential = Credential::fromPassword("16,32,1,2");
+    const std::string password = "16,32,1,2";
+
+    std::printf("Credential lookups and inserts (ns per request)\n");
+    std::printf("  %6s  %10s %10s  %10s %10s\n", "users", "map find", "index", "map insert", "index");
+
+    for(u32 users : { 8u, 64u, 1000u, 10000u }) {
+        std::vector<AccountUid> uids;
+        for(u32 user = 0; user < users; user++) uids.push_back(AccountUid { { 0x0100000000001000ULL + user * 0x10001ULL, 0x2000ULL + user } });
+
+        std::map<std::string, std::string> map;
+        CredentialIndex index;
+        for(const auto& uid : uids) {
+            map[accountUidToString(uid)] = password;
+            index.insert(uid, credential);
+        }
+
+        const double mapFind = measure([&](u32 i) {
+            const auto& entry = map.find(accountUidToString(uids[i * 7919 % users]));
+            g_sink = entry->second.size();
+        });
+        const double indexFind = measure([&](u32 i) {
+            g_sink = index.find(uids[i * 7919 % users])->length;
+        });
+        const double mapInsert = measure([&](u32 i) {
+            map[accountUidToString(uids[i * 7919 % users])] = password;
+        });
+        const double indexInsert = measure([&](u32 i) {
+            index.insert(uids[i * 7919 % users], credential);
+        });
+
+        std::printf("  %6u  %10.1f %10.1f  %10.1f %10.1f\n", users, mapFind, indexFind, mapInsert, indexInsert);
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <map>
+#include <random>
+#include <utility>
+#include "test.h"
+#include "host/host_nx.h"
+#include "credential_index.h"
+
+/* The credential index answers as a map of the uids would, through its growth, replacements and collisions. */
+
+using namespace alefbet::authenticator::database;
+
+static Credential credentialOf(u32 value) {
+    Credential credential;
+    credential.kind = Credential::Plain;
+    credential.length = sizeof(value);
+    std::memcpy(credential.data, &value, sizeof(value));
+    return credential;
+}
+
+static u32 valueOf(const Credential& credential) {
+    u32 value;
+    std::memcpy(&value, credential.data, sizeof(value));
+    return value;
+}
+
+int main() {
+    CredentialIndex index;
+    std::map<std::pair<u64, u64>, u32> reference;
+
+    CHECK(index.find(AccountUid { { 1, 2 } }) == nullptr);
+
+    // Few distinct uids so that most inserts replace a credential, and the low bits shared to make collisions
+    std::mt19937_64 random(1);
+    for(u32 i = 0; i < 20000; i++) {
+        const AccountUid uid = { { (random() % 3000) << 16, random() % 4 } };
+        if(uid.uid[0] == 0 && uid.uid[1] == 0) continue;
+
+        index.insert(uid, credentialOf(i));
+        reference[{ uid.uid[0], uid.uid[1] }] = i;
+    }
+
+    CHECK(index.size() == reference.size());
+
+    u32 mismatches = 0;
+    for(const auto& [key, value] : reference) {
+        const auto* credential = index.find(AccountUid { { key.first, key.second } });
+        if(credential == nullptr || valueOf(*credential) != value) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // Absent uids, close to the present ones
+    u32 found = 0;
+    for(u64 high = 0; high < 3000; high++) {
+        if(index.find(AccountUid { { (high << 16) | 1, 0 } }) != nullptr) found++;
+        if(index.find(AccountUid { { high << 16, 4 } }) != nullptr) found++;
+    }
+    CHECK(found == 0);
+
+    // Every record is visited once
+    size_t visited = 0;
+    index.forEach([&](AccountUid uid, const Credential& credential) {
+        const auto& entry = reference.find({ uid.uid[0], uid.uid[1] });
+        if(entry != reference.end() && entry->second == valueOf(credential)) visited++;
+    });
+    CHECK(visited == reference.size());
+
+    // The null uid marks the free slots, it is never stored
+    index.insert(AccountUid {}, credentialOf(1));
+    CHECK(index.find(AccountUid {}) == nullptr);
+    CHECK(index.size() == reference.size());
+
+    index.clear();
+    CHECK(index.size() == 0);
+    CHECK(index.find(AccountUid { { reference.begin()->first.first, reference.begin()->first.second } }) == nullptr);
+    index.insert(AccountUid { { 1, 2 } }, credentialOf(7));
+    CHECK(index.contains(AccountUid { { 1, 2 } }));
+    CHECK(valueOf(*index.find(AccountUid { { 1, 2 } })) == 7);
+
+    return TEST_RESULT();
+}
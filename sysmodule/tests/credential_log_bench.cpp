@@ -0,0 +1,68 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "database.h"
+
+/* Bytes written and latency of a PIN change with the credential log, against rewriting the whole JSON file as
+   before the log, and the time taken to replay the log at startup. The SD card is a directory of the host. */
+
+using namespace alefbet::authenticator::database;
+
+constexpr const char* LogFilename = "/config/authenticator/bench.log";
+constexpr const char* JsonFilename = "/config/authenticator/bench.json";
+constexpr u32 Updates = 200;
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+static double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+}
+
+int main() {
+    const auto& credential = Credential::fromPassword("ABAB");
+
+    std::printf("PIN changes (per update) and replay\n");
+    std::printf("  %6s  %10s %10s  %10s %10s  %10s %8s\n", "users", "JSON bytes", "us", "log bytes", "us", "replay us", "records");
+
+    for(u32 users : { 8u, 64u, 1000u }) {
+        CredentialIndex passwords;
+        for(u32 user = 0; user < users; user++) passwords.insert(userUid(user), credential);
+
+        // The log is only written once replayed, the previous one is then replaced
+        CredentialLog log(LogFilename);
+        CredentialIndex previous;
+        log.replay(previous);
+        log.rewrite(passwords);
+        writePasswords(passwords, JsonFilename);
+
+        const u64 jsonBytes = commitStats().bytesWritten;
+        auto start = std::chrono::steady_clock::now();
+        for(u32 i = 0; i < Updates; i++) {
+            passwords.insert(userUid(i % users), credential);
+            writePasswords(passwords, JsonFilename);
+        }
+        const double jsonUs = elapsedUs(start) / Updates;
+        const double jsonUpdateBytes = double(commitStats().bytesWritten - jsonBytes) / Updates;
+
+        // Compacting as the store does, after each update
+        const u64 logBytes = log.stats().bytesWritten;
+        start = std::chrono::steady_clock::now();
+        for(u32 i = 0; i < Updates; i++) {
+            log.append(userUid(i % users), credential, true);
+            if(log.needsCompaction()) log.rewrite(passwords);
+        }
+        const double logUs = elapsedUs(start) / Updates;
+        const double logUpdateBytes = double(log.stats().bytesWritten - logBytes) / Updates;
+
+        CredentialLog reader(LogFilename);
+        start = std::chrono::steady_clock::now();
+        reader.replay(previous);
+        const double replayUs = elapsedUs(start);
+
+        std::printf("  %6u  %10.0f %10.1f  %10.0f %10.1f  %10.1f %8u\n", users, jsonUpdateBytes, jsonUs,
+            logUpdateBytes, logUs, replayUs, reader.stats().recoveredRecords);
+    }
+
+    return 0;
+}
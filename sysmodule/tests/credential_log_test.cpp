@@ -0,0 +1,142 @@
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* Replay of the credential log: a torn last record is cut, a corrupted record followed by valid ones is skipped
+   without losing them and locks its account, since the PIN it held may have replaced an older one. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+constexpr const char* Path = "/config/authenticator/replay.log";
+constexpr s64 HeaderSize = 8;
+constexpr s64 RecordSize = 96;
+constexpr s64 UidOffset = 16;
+constexpr s64 CredentialOffset = 32;
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+constexpr AccountUid Carol = { { 0x5555, 0x6666 } };
+
+static bool sameCredential(const Credential* a, const Credential& b) {
+    return a != nullptr && std::memcmp(a, &b, sizeof(b)) == 0;
+}
+
+static s64 fileSize() {
+    s64 size = -1;
+    SdCard::get().getSize(Path, &size);
+    return size;
+}
+
+static void overwrite(s64 offset, u8 value, size_t size) {
+    const std::vector<u8> bytes(size, value);
+    SdCard::get().write(Path, offset, bytes.data(), bytes.size(), FsWriteOption_Flush);
+}
+
+static s64 recordOffset(u32 record) {
+    return HeaderSize + record * RecordSize;
+}
+
+int main() {
+    const auto& a1 = Credential::fromPassword("AAAA");
+    const auto& a2 = Credential::fromPassword("ABAB");
+    const auto& b1 = Credential::fromPassword("BBBB");
+    const auto& b2 = Credential::fromPassword("BABA");
+    const auto& c1 = Credential::fromPassword("CCCC");
+
+    CredentialIndex passwords;
+    {
+        CredentialLog log(Path);
+        CHECK(!log.replay(passwords));
+        CHECK(log.append(Alice, a1, false));
+        CHECK(log.append(Bob, b1, false));
+        CHECK(log.append(Alice, a2, true));
+        CHECK(log.append(Bob, b2, true));
+        CHECK(log.append(Carol, c1, false));
+    }
+    CHECK(fileSize() == recordOffset(5));
+
+    // The second PIN of Alice is corrupted: the older one must not be accepted, Bob and Carol are kept
+    overwrite(recordOffset(2) + CredentialOffset + 8, 0xA5, 4);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(passwords.size() == 3);
+        CHECK(passwords.find(Alice) != nullptr && passwords.find(Alice)->kind == Credential::Locked);
+        CHECK(sameCredential(passwords.find(Bob), b2));
+        CHECK(sameCredential(passwords.find(Carol), c1));
+        CHECK(log.stats().recoveredRecords == 4);
+        CHECK(log.stats().corruptRecords == 1);
+        CHECK(log.stats().discardedBytes == 0);
+        CHECK(log.stats().liveRecords == 3);
+        CHECK(log.stats().deadRecords == 2);
+
+        // A new PIN of Alice supersedes the lock
+        CHECK(log.append(Alice, a1, true));
+    }
+    CHECK(fileSize() == recordOffset(6));
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(sameCredential(passwords.find(Alice), a1));
+    }
+
+    // A corrupted record whose uid cannot be read is skipped, nothing else is lost
+    overwrite(recordOffset(1), 0, RecordSize);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(passwords.size() == 3);
+        CHECK(sameCredential(passwords.find(Bob), b2));
+        CHECK(log.stats().corruptRecords == 2);
+    }
+
+    // A torn append: a partial record, then a whole one of zeroes, is cut and the log goes on after it
+    overwrite(recordOffset(6), 0x5A, RecordSize / 2);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(log.stats().discardedBytes == RecordSize / 2);
+        CHECK(fileSize() == recordOffset(6));
+    }
+    overwrite(recordOffset(6), 0, RecordSize);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(log.stats().corruptRecords == 2);
+        CHECK(log.stats().discardedBytes == RecordSize);
+        CHECK(fileSize() == recordOffset(6));
+        CHECK(log.append(Carol, c1, true));
+    }
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(log.stats().discardedBytes == 0);
+        CHECK(log.stats().recoveredRecords == 5);
+    }
+
+    // The uid of a torn record is not trusted: the last record only is cut, even with a readable uid
+    overwrite(recordOffset(6) + UidOffset - 4, 0xFF, 4);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(sameCredential(passwords.find(Carol), c1));
+        CHECK(fileSize() == recordOffset(6));
+    }
+
+    // The compaction keeps the lock of an account
+    overwrite(recordOffset(3) + CredentialOffset, 0xFF, 1);
+    {
+        CredentialLog log(Path);
+        CHECK(log.replay(passwords));
+        CHECK(passwords.find(Bob)->kind == Credential::Locked);
+        CHECK(log.rewrite(passwords));
+        CHECK(log.replay(passwords));
+        CHECK(log.stats().corruptRecords == 0);
+        CHECK(passwords.find(Bob)->kind == Credential::Locked);
+        CHECK(sameCredential(passwords.find(Alice), a1));
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* Startup with stale records: the time to load the credential store when all its records have the current
+   schema and when they all need a migration, which is only run when a record is read. Built with a schema of 2
+   and a step from schema 1. The SD card is a directory of the host. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+static_assert(CredentialSchemaVersion == 2);
+
+constexpr const char* LogPath = "/config/authenticator/passwords.log";
+constexpr u32 Lookups = 100;
+
+static bool upgrade(Credential& credential) {
+    credential.reserved[0] = 1;
+    return true;
+}
+
+constexpr MigrationStep Steps[] = { upgrade };
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+static double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+}
+
+static void measure(u32 users, u8 schema) {
+    auto credential = Credential::fromPassword("ABAB");
+    credential.schema = schema;
+
+    CredentialIndex passwords;
+    for(u32 user = 0; user < users; user++) passwords.insert(userUid(user), credential);
+
+    SdCard::get().deleteFile(LogPath);
+    CredentialLog log(LogPath);
+    CredentialIndex previous;
+    log.replay(previous);
+    log.rewrite(passwords);
+
+    auto& store = CredentialStore::get();
+    auto start = std::chrono::steady_clock::now();
+    store.load();
+    const double loadUs = elapsedUs(start);
+
+    // The first lookups of users migrate their records, the next ones do not
+    start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Lookups; i++) store.find(userUid(i));
+    const double firstUs = elapsedUs(start) / Lookups;
+
+    start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Lookups; i++) store.find(userUid(i));
+    const double nextUs = elapsedUs(start) / Lookups;
+
+    std::printf("  %6u  %-7s  %10.1f  %12.2f %12.2f\n", users, schema == CredentialSchemaVersion ? "current" : "stale", loadUs, firstUs, nextUs);
+}
+
+int main() {
+    setMigrationSteps(Steps, std::size(Steps));
+    createDataDirectory();
+
+    std::printf("Credential store startup and lookups (us)\n");
+    std::printf("  %6s  %-7s  %10s  %12s %12s\n", "users", "records", "load", "first find", "next find");
+    for(u32 users : { 1000u, 10000u }) {
+        measure(users, CredentialSchemaVersion);
+        measure(users, CredentialSchemaVersion - 1);
+    }
+
+    return 0;
+}
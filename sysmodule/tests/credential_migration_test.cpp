@@ -0,0 +1,134 @@
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* Built with a current schema of 3 and two registered steps: a stale record is upgraded when it is read and
+   written back once, a record of the current schema is left alone, and a record whose migration fails or whose
+   schema is unknown is answered as locked and kept as it is stored. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+static_assert(CredentialSchemaVersion == 3);
+
+constexpr const char* LogPath = "/config/authenticator/passwords.log";
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+constexpr AccountUid Carol = { { 0x5555, 0x6666 } };
+constexpr AccountUid Dave = { { 0x7777, 0x8888 } };
+constexpr AccountUid Erin = { { 0x9999, 0xAAAA } };
+constexpr AccountUid Frank = { { 0xBBBB, 0xCCCC } };
+
+static u32 g_stepRuns = 0;
+
+/* Each step leaves its mark, the second one cannot convert the PIN "FAIL" */
+static bool firstStep(Credential& credential) {
+    g_stepRuns++;
+    credential.reserved[0] |= 1;
+    return true;
+}
+
+static bool secondStep(Credential& credential) {
+    g_stepRuns++;
+    if(credential.password() == "FAIL") return false;
+    credential.reserved[0] |= 2;
+    return true;
+}
+
+constexpr MigrationStep Steps[] = { firstStep, secondStep };
+
+static Credential withSchema(const char* password, u8 schema) {
+    auto credential = Credential::fromPassword(password);
+    credential.schema = schema;
+    return credential;
+}
+
+static s64 logSize() {
+    s64 size = -1;
+    SdCard::get().getSize(LogPath, &size);
+    return size;
+}
+
+static const Credential* stored(AccountUid uid) {
+    static CredentialIndex passwords;
+    CredentialLog log(LogPath);
+    log.replay(passwords);
+    return passwords.find(uid);
+}
+
+int main() {
+    setMigrationSteps(Steps, std::size(Steps));
+
+    // The steps on their own
+    auto credential = withSchema("AAAA", 1);
+    CHECK(migrateCredential(credential) == MigrationApplied);
+    CHECK(credential.schema == 3 && credential.reserved[0] == 3);
+    CHECK(migrateCredential(credential) == MigrationNone);
+
+    credential = withSchema("FAIL", 1);
+    CHECK(migrateCredential(credential) == MigrationFailed);
+    CHECK(credential.schema == 1 && credential.reserved[0] == 0);
+
+    for(u8 schema : { 0, 4, 255 }) {
+        credential = withSchema("AAAA", schema);
+        CHECK(migrateCredential(credential) == MigrationFailed);
+    }
+
+    // A log of records of every schema
+    CHECK(createDataDirectory());
+    SdCard::get().deleteFile(LogPath);
+    {
+        CredentialLog log(LogPath);
+        CredentialIndex passwords;
+        CHECK(!log.replay(passwords));
+        CHECK(log.append(Alice, withSchema("AAAA", 1), false));
+        CHECK(log.append(Bob, withSchema("BBBB", 3), false));
+        CHECK(log.append(Carol, withSchema("FAIL", 2), false));
+        CHECK(log.append(Dave, withSchema("DDDD", 4), false));
+        CHECK(log.append(Erin, withSchema("EEEE", 0), false));
+        CHECK(log.append(Frank, withSchema("FFFF", 1), false));
+    }
+
+    // Loading runs no step
+    auto& store = CredentialStore::get();
+    g_stepRuns = 0;
+    CHECK(store.load());
+    CHECK(store.size() == 6);
+    CHECK(g_stepRuns == 0);
+
+    // Applied: upgraded and written back, once
+    s64 size = logSize();
+    credential = store.find(Alice);
+    CHECK(credential.schema == 3 && credential.reserved[0] == 3 && credential.password() == "AAAA");
+    CHECK(logSize() == size + 96);
+    CHECK(stored(Alice)->schema == 3);
+    CHECK(g_stepRuns == 2);
+
+    size = logSize();
+    CHECK(store.find(Alice).schema == 3);
+    CHECK(logSize() == size);
+    CHECK(g_stepRuns == 2);
+
+    // None: answered as stored, nothing written
+    credential = store.find(Bob);
+    CHECK(credential.schema == 3 && credential.reserved[0] == 0 && credential.password() == "BBBB");
+    CHECK(logSize() == size);
+
+    // Failed: locked, no PIN matches, the record stays for a build which can read it
+    CHECK(store.find(Carol).kind == Credential::Locked);
+    CHECK(!verifyPassword(Carol, "FAIL"));
+    CHECK(stored(Carol)->schema == 2 && stored(Carol)->password() == "FAIL");
+    CHECK(store.find(Dave).kind == Credential::Locked);
+    CHECK(store.find(Erin).kind == Credential::Locked);
+    CHECK(logSize() == size);
+
+    // Without its steps a stale record cannot be read either
+    setMigrationSteps(nullptr, 0);
+    CHECK(store.find(Frank).kind == Credential::Locked);
+    CHECK(stored(Frank)->schema == 1);
+
+    return TEST_RESULT();
+}
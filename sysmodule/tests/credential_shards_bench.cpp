@@ -0,0 +1,67 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* SD card requests and latency of a PIN change with the sharded storage and with the log, stamp of the storage
+   included as the store takes it after each write, and the requests of the replay at startup, for 8, 64 and
+   1000 users. The SD card is a directory of the host. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+constexpr u32 Saves = 200;
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+template<typename Storage>
+static void measure(const char* name, const char* path, u32 users) {
+    const auto& credential = Credential::fromPassword("ABAB");
+
+    CredentialIndex passwords;
+    for(u32 user = 0; user < users; user++) passwords.insert(userUid(user), credential);
+
+    Storage storage(path);
+    CredentialIndex previous;
+    storage.replay(previous);
+    storage.rewrite(passwords);
+    storage.stamp();
+
+    u64 requests = hostSdRequests();
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Saves; i++) {
+        const auto& uid = userUid(i * 7919 % users);
+        storage.append(uid, credential, true);
+        if(storage.needsCompaction()) {
+            storage.rewrite(passwords);
+            storage.stamp();
+        } else {
+            storage.stamp(uid);
+        }
+    }
+    const double us = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / Saves;
+    const double saveRequests = double(hostSdRequests() - requests) / Saves;
+
+    SdCard::get().closeAll();
+    requests = hostSdRequests();
+    Storage reader(path);
+    reader.replay(previous);
+    reader.stamp();
+
+    std::printf("  %-7s %6u  %8.1f %8.1f  %10lu\n", name, users, saveRequests, us, hostSdRequests() - requests);
+}
+
+int main() {
+    createDataDirectory();
+
+    std::printf("PIN changes (per save) and startup\n");
+    std::printf("  %-7s %6s  %8s %8s  %10s\n", "storage", "users", "requests", "us", "startup");
+    for(u32 users : { 8u, 64u, 1000u }) {
+        measure<CredentialShards>("shards", "/config/authenticator/bench", users);
+        measure<CredentialLog>("log", "/config/authenticator/bench.log", users);
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <string>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+#include "sd_card.h"
+
+/* The sharded storage: the stamp taken after a write queries the written shard only and still equals the stamp
+   of a scan of the directory, so that a PIN change costs the same whatever the number of users. A shard which
+   cannot be read locks the account named by its file. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::services;
+
+constexpr const char* Dir = "/config/authenticator/users";
+constexpr const char* LogPath = "/config/authenticator/passwords.log";
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+static void writeFile(const char* path, const std::vector<u8>& data) {
+    auto& sdcard = SdCard::get();
+    sdcard.deleteFile(path);
+    sdcard.createFile(path, data.size());
+    sdcard.write(path, 0, data.data(), data.size(), FsWriteOption_Flush);
+    sdcard.close(path);
+}
+
+/* SD card requests of a PIN change through the store */
+static u64 updateRequests(AccountUid uid) {
+    const u64 requests = hostSdRequests();
+    CHECK(CredentialStore::get().update(uid, Credential::fromPassword("ABAB")));
+    return hostSdRequests() - requests;
+}
+
+int main() {
+    auto& sdcard = SdCard::get();
+    CHECK(createDataDirectory());
+
+    // Left by the other tests, it would be imported
+    sdcard.deleteFile(LogPath);
+
+    const auto& first = Credential::fromPassword("AAAA");
+    const auto& second = Credential::fromPassword("BBBB");
+
+    CredentialShards shards(Dir);
+    CredentialIndex passwords;
+    CHECK(!shards.replay(passwords));
+    for(u32 user = 0; user < 64; user++) CHECK(shards.append(userUid(user), first, false));
+    CHECK(shards.replay(passwords));
+    CHECK(passwords.size() == 64);
+
+    // Replaced and new shards: a single request, the stamp of a scan
+    CHECK(shards.stamp().size == 64 * 104);
+    for(u32 user : { 3u, 40u, 64u, 65u, 3u }) {
+        CHECK(shards.append(userUid(user), second, user < 64));
+
+        const u64 requests = hostSdRequests();
+        const auto& stamp = shards.stamp(userUid(user));
+        CHECK(hostSdRequests() - requests == 1);
+
+        CredentialShards scanner(Dir);
+        CHECK(stamp == scanner.stamp());
+    }
+
+    // Without a stamp of the directory to update, the directory is scanned
+    CredentialShards fresh(Dir);
+    CHECK(fresh.stamp(userUid(3)) == shards.stamp());
+
+    // A shard which cannot be read locks its account, a file which does not name one is ignored
+    writeFile("/config/authenticator/users/0000000000000AAA0000000000000BBB.bin", std::vector<u8>(104, 0));
+    writeFile("/config/authenticator/users/00000000000010050000000000002000.bin", std::vector<u8>(10, 0xFF));
+    writeFile("/config/authenticator/users/notes.bin", std::vector<u8>(104, 0));
+    CHECK(shards.replay(passwords));
+    CHECK(passwords.size() == 67);
+    CHECK(passwords.find(AccountUid { { 0xAAA, 0xBBB } })->kind == Credential::Locked);
+    CHECK(passwords.find(userUid(5))->kind == Credential::Locked);
+    CHECK(shards.stats().corruptRecords == 2);
+    CHECK(shards.stats().recoveredRecords == 65);
+
+    // Through the store: the locked account matches no PIN, and a PIN change costs the same with 64 and 1000 users
+    auto& store = CredentialStore::get();
+    CHECK(store.load());
+    CHECK(store.size() == 67);
+    CHECK(store.find(userUid(5)).kind == Credential::Locked);
+    CHECK(!verifyPassword(userUid(5), "AAAA"));
+
+    const u64 requests = updateRequests(userUid(1));
+    CHECK(requests == updateRequests(userUid(2)));
+    for(u32 user = 66; user < 1000; user++) CHECK(shards.append(userUid(user), first, false));
+    CHECK(store.load());
+    CHECK(store.size() == 1001);
+    CHECK(updateRequests(userUid(1)) == requests);
+    CHECK(updateRequests(userUid(999)) == requests);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "database.h"
+
+/* Lookup and update latency of the credential store, against reading the JSON file for each request and
+   rewriting it for each update as before the store. The JSON path uses today's parser, which is faster than the
+   DOM it replaced, so the gap is a lower bound. The SD card is a directory of the host. */
+
+using namespace alefbet::authenticator::database;
+
+constexpr const char* JsonFilename = "/config/authenticator/bench.json";
+constexpr u32 Requests = 50;
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+static volatile u8 g_sink;
+
+template<typename F>
+static double measure(u32 requests, F&& request) {
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < requests; i++) request(i);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / requests;
+}
+
+int main() {
+    auto& store = CredentialStore::get();
+    store.load();
+
+    const auto& credential = Credential::fromPassword("ABAB");
+    CredentialIndex passwords;
+    u32 users = 0;
+
+    std::printf("Credential lookups and updates (us per request)\n");
+    std::printf("  %6s  %12s %12s  %12s %12s\n", "users", "JSON lookup", "store", "JSON update", "store");
+
+    for(u32 count : { 1u, 10u, 100u, 1000u, 10000u }) {
+        for(; users < count; users++) {
+            passwords.insert(userUid(users), credential);
+            store.update(userUid(users), credential);
+        }
+        writePasswords(passwords, JsonFilename);
+
+        const u32 requests = count >= 1000 ? Requests / 5 : Requests;
+        const double jsonLookup = measure(requests, [&](u32 i) {
+            CredentialIndex stored;
+            loadPasswords(JsonFilename, stored);
+            g_sink = stored.find(userUid(i * 7919 % count))->kind;
+        });
+        const double storeLookup = measure(requests * 100, [&](u32 i) {
+            g_sink = store.find(userUid(i * 7919 % count)).kind;
+        });
+        const double jsonUpdate = measure(requests, [&](u32 i) {
+            CredentialIndex stored;
+            loadPasswords(JsonFilename, stored);
+            stored.insert(userUid(i * 7919 % count), credential);
+            writePasswords(stored, JsonFilename);
+        });
+        const double storeUpdate = measure(requests, [&](u32 i) {
+            store.update(userUid(i * 7919 % count), credential);
+        });
+
+        std::printf("  %6u  %12.2f %12.2f  %12.2f %12.2f\n", count, jsonLookup, storeLookup, jsonUpdate, storeUpdate);
+    }
+
+    return 0;
+}
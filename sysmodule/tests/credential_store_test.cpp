@@ -0,0 +1,63 @@
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+
+/* The credential store answers from memory what has been written to the storage, and nothing else: an update
+   that could not be written is reported and not answered. Changes made by another writer are picked up. */
+
+using namespace alefbet::authenticator::database;
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+constexpr AccountUid Carol = { { 0x5555, 0x6666 } };
+
+static bool sameCredential(const Credential& a, const Credential& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+int main() {
+    auto& store = CredentialStore::get();
+    CHECK(store.load());
+    CHECK(store.find(Alice).empty());
+
+    const auto& first = Credential::fromPassword("AAAA");
+    const auto& second = Credential::fromPassword("BBBB");
+
+    CHECK(store.update(Alice, first));
+    CHECK(sameCredential(store.find(Alice), first));
+
+    // The SD card refuses the writes: the previous credential stays, the new user has none
+    hostFailSdWrites(true);
+    CHECK(!store.update(Alice, second));
+    CHECK(sameCredential(store.find(Alice), first));
+    CHECK(!store.update(Bob, second));
+    CHECK(store.find(Bob).empty());
+    CHECK(store.size() == 1);
+
+    // The PIN entry is told
+    CHECK(!savePassword(Bob, "ABAB"));
+    CHECK(store.find(Bob).empty());
+    CHECK(!verifyPassword(Bob, "ABAB"));
+
+    hostFailSdWrites(false);
+    CHECK(savePassword(Bob, "ABAB"));
+    CHECK(store.find(Bob).kind == Credential::Hashed);
+    CHECK(verifyPassword(Bob, "ABAB"));
+    CHECK(!verifyPassword(Bob, "BABA"));
+
+    // A plain password is migrated to a hash once it has been verified
+    CHECK(verifyPassword(Alice, "AAAA"));
+    CHECK(store.find(Alice).kind == Credential::Hashed);
+    CHECK(verifyPassword(Alice, "AAAA"));
+
+    // Another writer appends to the log, the change is seen once the storage stamp is checked again
+    CredentialLog log("/config/authenticator/passwords.log");
+    CredentialIndex passwords;
+    CHECK(log.replay(passwords));
+    CHECK(passwords.size() == 2);
+    CHECK(log.append(Carol, second, false));
+    CHECK(sameCredential(store.find(Carol), second));
+    CHECK(store.size() == 3);
+
+    return TEST_RESULT();
+}
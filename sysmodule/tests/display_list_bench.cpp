@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdlib>
+#include "host/host_nx.h"
+#include "gui/display_list.hpp"
+
+/* Refreshes of the authentication panel while keys are pressed: the panel drawn entirely for each refresh as
+   before, against its display list drawing only the nodes which changed and no frame when nothing did. The
+   message is a rectangle changing color with the stage, the fonts of the host cannot be measured. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+constexpr u32 Refreshes = 600;
+
+constexpr Color Background(0x2, 0x4, 0x6, 0xE);
+constexpr Color Title(0x1, 0xC, 0xE, 0xF);
+constexpr Color White(0xF, 0xF, 0xF, 0xF);
+constexpr s32 CirclesX[] = { 416, 550, 680, 818 };
+
+struct PanelState {
+    u32 stage = 0;
+    u32 keys = 0;
+};
+
+static Color stageColor(u32 stage) {
+    return Color(0xF, stage, 0x3, 0x9);
+}
+
+/* The same sequence of states for both ways of drawing */
+static PanelState nextState(PanelState state, u32 refresh) {
+    if(refresh > 0 && std::rand() % 3 == 0) return state;
+
+    if(std::rand() % 5 == 0) {
+        state.stage = std::rand() % 6;
+        state.keys = 0;
+    } else {
+        state.keys = (state.keys + 1) % 5;
+    }
+    return state;
+}
+
+template<typename F>
+static void measure(const char* name, F&& refresh) {
+    auto& renderer = Renderer::get();
+    const u64 frames = renderer.stats().frames;
+    u64 pixels = 0;
+
+    std::srand(7);
+    PanelState state;
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Refreshes; i++) {
+        state = nextState(state, i);
+        const u64 before = renderer.stats().frames;
+        refresh(renderer, state);
+        if(renderer.stats().frames != before) pixels += renderer.stats().lastFramePixels;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const u64 drawn = renderer.stats().frames - frames;
+    std::printf("  %-14s %6lu frames  %9.0f pixels per frame  %8.1f us per refresh\n", name, drawn,
+        drawn > 0 ? double(pixels) / drawn : 0.0, seconds * 1e6 / Refreshes);
+}
+
+int main() {
+    auto& renderer = Renderer::get();
+    renderer.init(Width, Height, 0, 0);
+
+    std::printf("Authentication panel, %u refreshes\n", Refreshes);
+    measure("full redraw", [](Renderer& renderer, const PanelState& state) {
+        renderer.invalidateAll();
+        renderer.startFrame();
+        renderer.clearScreen(Background);
+        renderer.drawRect(384, 70, 450, 60, Title);
+        renderer.drawRect(200, 300, Width - 400, 60, stageColor(state.stage));
+        for(u32 i = 0; i < std::size(CirclesX); i++) {
+            renderer.drawCircle(CirclesX[i], 496, 24, state.keys > i, White);
+        }
+        renderer.endFrame();
+    });
+
+    DisplayList panel;
+    panel.reset(Width, Height, Background);
+    panel.addRect(384, 70, 450, 60, Title);
+    const u32 message = panel.addRect(200, 300, Width - 400, 60, stageColor(0));
+    u32 circles[std::size(CirclesX)];
+    for(u32 i = 0; i < std::size(CirclesX); i++) {
+        circles[i] = panel.addCircle(CirclesX[i], 496, 24, false, White);
+    }
+
+    measure("display list", [&](Renderer&, const PanelState& state) {
+        panel.setColor(message, stageColor(state.stage));
+        for(u32 i = 0; i < std::size(CirclesX); i++) panel.setFilled(circles[i], state.keys > i);
+        panel.render();
+    });
+
+    renderer.exit();
+
+    return 0;
+}
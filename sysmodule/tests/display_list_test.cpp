@@ -0,0 +1,117 @@
+#include <cstdlib>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "gui/display_list.hpp"
+
+/* The authentication panel drawn from its display list gives the same frames as the panel drawn entirely for
+   each state, and a refresh which changes nothing draws no frame. The fonts of the host cannot be measured, the
+   message is a rectangle changing color with the stage. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+
+constexpr Color Background(0x2, 0x4, 0x6, 0xE);
+constexpr Color White(0xF, 0xF, 0xF, 0xF);
+constexpr s32 CirclesX[] = { 416, 550, 680, 818 };
+
+struct PanelState {
+    u32 stage = 0;
+    u32 keys = 0;
+};
+
+static Color stageColor(u32 stage) {
+    return Color(0xF, stage, 0x3, 0x9);
+}
+
+static u32 presentedFrameCrc() {
+    size_t size;
+    const void* frame = hostPresentedFramebuffer(&size);
+    return crc32Calculate(frame, size);
+}
+
+/* The panel as drawn before the display list, entirely for each frame */
+static void drawPanel(Renderer& renderer, const PanelState& state) {
+    renderer.clearScreen(Background);
+    renderer.drawRect(384, 70, 450, 60, Color(0x1, 0xC, 0xE, 0xF));
+    renderer.drawRect(200, 300, Width - 400, 60, stageColor(state.stage));
+    for(u32 i = 0; i < std::size(CirclesX); i++) {
+        renderer.drawCircle(CirclesX[i], 496, 24, state.keys > i, White);
+    }
+}
+
+int main() {
+    auto& renderer = Renderer::get();
+    renderer.init(Width, Height, 0, 0);
+
+    DisplayList panel;
+    panel.reset(Width, Height, Background);
+    panel.addRect(384, 70, 450, 60, Color(0x1, 0xC, 0xE, 0xF));
+    const u32 message = panel.addRect(200, 300, Width - 400, 60, stageColor(0));
+    u32 circles[std::size(CirclesX)];
+    for(u32 i = 0; i < std::size(CirclesX); i++) {
+        circles[i] = panel.addCircle(CirclesX[i], 496, 24, false, White);
+    }
+
+    // Keys pressed one by one, the message changing now and then, and refreshes without any change
+    constexpr u32 Refreshes = 300;
+    std::vector<PanelState> states;
+    std::vector<u32> frames;
+    std::vector<bool> drawn;
+    PanelState state;
+    std::srand(7);
+    for(u32 refresh = 0; refresh < Refreshes; refresh++) {
+        if(refresh > 0 && std::rand() % 3 == 0) {
+            // Nothing changed
+        } else if(std::rand() % 5 == 0) {
+            state.stage = std::rand() % 6;
+            state.keys = 0;
+        } else {
+            state.keys = (state.keys + 1) % 5;
+        }
+
+        panel.setColor(message, stageColor(state.stage));
+        for(u32 i = 0; i < std::size(CirclesX); i++) panel.setFilled(circles[i], state.keys > i);
+
+        const u64 before = renderer.stats().frames;
+        const bool rendered = panel.render();
+        CHECK(rendered == (renderer.stats().frames != before));
+
+        states.push_back(state);
+        drawn.push_back(rendered);
+        frames.push_back(presentedFrameCrc());
+    }
+
+    // A refresh is drawn if and only if the state changed
+    u32 mismatches = 0;
+    for(u32 refresh = 1; refresh < Refreshes; refresh++) {
+        const bool changed = states[refresh].stage != states[refresh - 1].stage || states[refresh].keys != states[refresh - 1].keys;
+        if(drawn[refresh] != changed) mismatches++;
+    }
+    CHECK(drawn[0]);
+    CHECK(mismatches == 0);
+
+    // The frames presented after each refresh are those of the panel drawn entirely
+    mismatches = 0;
+    for(u32 refresh = 0; refresh < Refreshes; refresh++) {
+        renderer.invalidateAll();
+        renderer.startFrame();
+        drawPanel(renderer, states[refresh]);
+        renderer.endFrame();
+
+        if(presentedFrameCrc() != frames[refresh]) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // Once the screen content is lost, the whole list is drawn again
+    panel.invalidate();
+    CHECK(panel.render());
+    CHECK(renderer.stats().lastFramePixels >= Width * Height);
+    CHECK(!panel.render());
+
+    renderer.exit();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+#include <string>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* The flight recorder keeps the last LOG_FLIGHT_SLOTS events (64 for this test), traces included, in memory only
+   and writes them on demand, or on a crash through the flusher thread or directly when the flusher is not there. */
+
+using namespace alefbet::authenticator;
+using namespace alefbet::authenticator::logger;
+
+static_assert(LOG_FLIGHT_SLOTS == 64, "the test is built with -DLOG_FLIGHT_SLOTS=64");
+
+constexpr const char* FlightFilename = "/atmosphere/logs/authenticator_flight.bin";
+constexpr u32 Events = 100'000;
+constexpr u64 MaxCaptureNs = 1000;      ///< Per event, far above the cost of a copy into memory
+
+struct Dump {
+    std::string reason;
+    std::vector<u64> events;        ///< Argument of each "event" record, in order
+    bool valid = false;
+};
+
+static Dump readDump() {
+    Dump dump;
+
+    std::vector<u8> data;
+    if(R_FAILED(services::SdCard::get().readFile(FlightFilename, data)) || data.size() < 16) return dump;
+
+    u32 magic;
+    std::memcpy(&magic, data.data(), sizeof(magic));
+    if(magic != 0x424C4141) return dump;
+
+    size_t offset = 16;
+    bool first = true;
+    while(offset + sizeof(LogRecordHeader) <= data.size()) {
+        LogRecordHeader header;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        if(header.size < sizeof(header) || offset + header.size > data.size()) return dump;
+
+        const u8* args = data.data() + offset + sizeof(header);
+        if(first) {
+            // The reason, as a string argument
+            dump.reason.assign(reinterpret_cast<const char*>(args + 2), args[1]);
+            first = false;
+        } else if(header.formatId == logFormatId("[Main] event %u\n")) {
+            u64 value;
+            std::memcpy(&value, args + 1, sizeof(value));
+            dump.events.push_back(value);
+        }
+
+        offset += header.size;
+    }
+
+    dump.valid = offset == data.size();
+    return dump;
+}
+
+static bool lastEvents(const Dump& dump, u32 end, u32 count) {
+    if(dump.events.size() != count) return false;
+
+    for(u32 i = 0; i < count; i++) {
+        if(dump.events[i] != end - count + i) return false;
+    }
+    return true;
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    services::SdCard::get().createDirectory("/atmosphere");
+    services::SdCard::get().createDirectory("/atmosphere/logs");
+
+    // Only the last events are kept, in order
+    for(u32 i = 0; i < 100; i++) {
+        LOG_INFO(Main, "event %u\n", i);
+    }
+
+    CHECK(dumpFlightRecorder("on demand"));
+    Dump dump = readDump();
+    CHECK(dump.valid);
+    CHECK(dump.reason == "on demand");
+    CHECK(lastEvents(dump, 100, 64));
+
+    // Traces are recorded although the log keeps nothing below errors, without any request to the SD card
+    static_assert(LOG_FLIGHT_MIN_LEVEL == 0 && LOG_MIN_LEVEL == 5);
+    const u64 requests = hostSdRequests();
+    const u64 captureStart = armGetSystemTick();
+    for(u32 i = 0; i < Events; i++) {
+        LOG_TRACE(Main, "event %u\n", 100 + i);
+    }
+    const u64 captureNs = armTicksToNs(armGetSystemTick() - captureStart);
+    CHECK(hostSdRequests() == requests);
+    CHECK(captureNs / Events < MaxCaptureNs);
+
+    CHECK(dumpFlightRecorder("traces"));
+    CHECK(lastEvents(readDump(), 100 + Events, 64));
+
+    // A crash without the flusher is written by the crashed thread, later events are not recorded
+    dumpFlightRecorderOnCrash("crash without flusher");
+    dump = readDump();
+    CHECK(dump.valid);
+    CHECK(dump.reason == "crash without flusher");
+    CHECK(lastEvents(dump, 100 + Events, 64));
+
+    for(u32 i = 0; i < 10; i++) {
+        LOG_INFO(Main, "event %u\n", 100 + Events + i);
+    }
+
+    // With the flusher, it writes the dump and the crashed thread waits for it
+    CHECK(startFlusher());
+    const u64 start = armGetSystemTick();
+    dumpFlightRecorderOnCrash("crash with flusher");
+    CHECK(armTicksToNs(armGetSystemTick() - start) < 900'000'000ULL);
+    stopFlusher();
+
+    dump = readDump();
+    CHECK(dump.valid);
+    CHECK(dump.reason == "crash with flusher");
+    CHECK(lastEvents(dump, 100 + Events, 64));
+
+    return TEST_RESULT();
+}
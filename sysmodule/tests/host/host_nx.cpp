@@ -0,0 +1,856 @@
+#include "host_nx.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <random>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* Implementation of the libnx functions used by the tested code, on top of the C++ and POSIX libraries.
+   The SD card is a directory of the host. */
+
+namespace {
+    constexpr u64 TickFrequency = 19'200'000;
+    constexpr Result IoError = MAKERESULT(Module_Libnx, LibnxError_IoError);
+
+    std::string g_sdRoot = "sd.nosync";
+    std::atomic<bool> g_sdWritesFail = false;
+    std::atomic<u64> g_sdRequests = 0;
+    std::atomic<u64> g_sdBytesWritten = 0;
+    std::atomic<u64> g_sdExtendingWrites = 0;
+
+    std::mutex g_filesMutex;
+    std::map<const void*, int> g_files;
+    std::map<const void*, DIR*> g_dirs;
+
+    std::string hostPath(const char* path) {
+        return g_sdRoot + path;
+    }
+
+    int fileDescriptor(const FsFile* file) {
+        std::lock_guard<std::mutex> lock(g_filesMutex);
+        const auto& it = g_files.find(file);
+        return it != g_files.end() ? it->second : -1;
+    }
+
+    struct HostEvent {
+        std::mutex mutex;
+        std::condition_variable signaled;
+        bool set = false;
+        bool autoclear = false;
+    };
+
+    struct HostThread {
+        std::thread thread;
+        void (*entry)(void*) = nullptr;
+        void* arg = nullptr;
+    };
+
+    /* An sfnt header without any table: the fonts load, the glyphs are empty */
+    const u8 g_emptyFont[12] = { 0x00, 0x01, 0x00, 0x00 };
+
+    const void* g_presentedFramebuffer = nullptr;
+    size_t g_presentedSize = 0;
+
+    /* The console: its running application and its users, scripted by the tests */
+    struct HostUser {
+        AccountUid uid;
+        std::string nickname;
+        u64 lastEdit = 0;
+    };
+
+    std::mutex g_consoleMutex;
+    u64 g_applicationPid = 0;
+    u64 g_applicationId = 0;
+    AccountUid g_lastOpenedUser = {};
+    std::vector<HostUser> g_users;
+    std::map<u64, std::string> g_applications;
+    std::atomic<u64> g_ipcCalls = 0;
+    std::atomic<u64> g_ipcBytes = 0;
+    u32 g_hosVersion = MAKEHOSVERSION(17, 0, 0);
+
+    /* SHA-256, its state is kept in the opaque Sha256Context */
+    struct HostSha256 {
+        u32 h[8];
+        u64 length;
+        u32 used;
+        u8 block[SHA256_BLOCK_SIZE];
+    };
+    static_assert(sizeof(HostSha256) <= sizeof(Sha256Context));
+
+    constexpr u32 Sha256K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    HostSha256* sha256State(Sha256Context* ctx) {
+        return reinterpret_cast<HostSha256*>(ctx->state);
+    }
+
+    void sha256Init(Sha256Context* ctx) {
+        auto* state = sha256State(ctx);
+        *state = {};
+        const u32 h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        std::memcpy(state->h, h, sizeof(h));
+    }
+
+    void sha256Block(HostSha256* state) {
+        u32 w[64];
+        for(u32 i = 0; i < 16; i++) {
+            w[i] = state->block[i * 4] << 24 | state->block[i * 4 + 1] << 16 | state->block[i * 4 + 2] << 8 | state->block[i * 4 + 3];
+        }
+        for(u32 i = 16; i < 64; i++) {
+            const u32 s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const u32 s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        u32 a = state->h[0], b = state->h[1], c = state->h[2], d = state->h[3];
+        u32 e = state->h[4], f = state->h[5], g = state->h[6], h = state->h[7];
+        for(u32 i = 0; i < 64; i++) {
+            const u32 t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + Sha256K[i] + w[i];
+            const u32 t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state->h[0] += a; state->h[1] += b; state->h[2] += c; state->h[3] += d;
+        state->h[4] += e; state->h[5] += f; state->h[6] += g; state->h[7] += h;
+    }
+
+    void sha256Update(Sha256Context* ctx, const void* src, size_t size) {
+        auto* state = sha256State(ctx);
+        const u8* data = static_cast<const u8*>(src);
+        state->length += size;
+
+        while(size > 0) {
+            const size_t count = std::min<size_t>(size, SHA256_BLOCK_SIZE - state->used);
+            std::memcpy(state->block + state->used, data, count);
+            state->used += count;
+            data += count;
+            size -= count;
+
+            if(state->used == SHA256_BLOCK_SIZE) {
+                sha256Block(state);
+                state->used = 0;
+            }
+        }
+    }
+
+    void sha256Final(Sha256Context* ctx, void* dst) {
+        auto* state = sha256State(ctx);
+        const u64 bits = state->length * 8;
+
+        const u8 one = 0x80, zero = 0;
+        sha256Update(ctx, &one, 1);
+        while(state->used != SHA256_BLOCK_SIZE - 8) sha256Update(ctx, &zero, 1);
+        for(s32 shift = 56; shift >= 0; shift -= 8) {
+            const u8 byte = bits >> shift;
+            sha256Update(ctx, &byte, 1);
+        }
+
+        u8* out = static_cast<u8*>(dst);
+        for(u32 i = 0; i < 8; i++) {
+            out[i * 4] = state->h[i] >> 24;
+            out[i * 4 + 1] = state->h[i] >> 16;
+            out[i * 4 + 2] = state->h[i] >> 8;
+            out[i * 4 + 3] = state->h[i];
+        }
+    }
+
+    std::mutex g_threadsMutex;
+    std::map<Handle, HostThread*> g_threads;
+    std::atomic<Handle> g_nextHandle = 2;
+    thread_local Handle t_currentHandle = 1;     // The main thread
+}
+
+void hostSetSdRoot(const char* path) {
+    g_sdRoot = path;
+    mkdir(path, 0755);
+}
+
+void hostFailSdWrites(bool fail) {
+    g_sdWritesFail = fail;
+}
+
+void hostSetApplication(u64 pid, u64 programId) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    g_applicationPid = pid;
+    g_applicationId = programId;
+}
+
+void hostAddUser(AccountUid uid, const char* nickname) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    g_users.push_back(HostUser { uid, nickname, 1 });
+}
+
+void hostSetLastOpenedUser(AccountUid uid) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    g_lastOpenedUser = uid;
+}
+
+void hostInstallApplication(u64 titleId, const char* name) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    g_applications[titleId] = name;
+}
+
+u64 hostSdRequests() {
+    return g_sdRequests;
+}
+
+u64 hostSdBytesWritten() {
+    return g_sdBytesWritten;
+}
+
+u64 hostSdExtendingWrites() {
+    return g_sdExtendingWrites;
+}
+
+u64 hostIpcCalls() {
+    return g_ipcCalls;
+}
+
+u64 hostIpcBytes() {
+    return g_ipcBytes;
+}
+
+/* runtime/hosversion.h */
+bool hosversionAtLeast(u8 major, u8 minor, u8 micro) {
+    return g_hosVersion >= MAKEHOSVERSION(major, minor, micro);
+}
+
+bool hosversionBefore(u8 major, u8 minor, u8 micro) {
+    return !hosversionAtLeast(major, minor, micro);
+}
+
+void hosversionSet(u32 version) {
+    g_hosVersion = version;
+}
+
+/* arm/counter.h */
+u64 armGetSystemTick(void) {
+    const auto& now = std::chrono::steady_clock::now().time_since_epoch();
+    return armNsToTicks(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+u64 armGetSystemTickFreq(void) {
+    return TickFrequency;
+}
+
+u64 armNsToTicks(u64 ns) {
+    return ns * 12 / 625;
+}
+
+u64 armTicksToNs(u64 tick) {
+    return tick * 625 / 12;
+}
+
+/* kernel */
+void svcSleepThread(s64 nano) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(nano));
+}
+
+Result threadCreate(Thread* t, void (*entry)(void*), void* arg, void*, size_t, int, int) {
+    auto* thread = new HostThread;
+    thread->entry = entry;
+    thread->arg = arg;
+
+    t->handle = g_nextHandle++;
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    g_threads[t->handle] = thread;
+    return 0;
+}
+
+Result threadStart(Thread* t) {
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    auto* thread = g_threads[t->handle];
+    const Handle handle = t->handle;
+    thread->thread = std::thread([thread, handle] {
+        t_currentHandle = handle;
+        thread->entry(thread->arg);
+    });
+    return 0;
+}
+
+Result threadWaitForExit(Thread* t) {
+    HostThread* thread;
+    {
+        std::lock_guard<std::mutex> lock(g_threadsMutex);
+        thread = g_threads[t->handle];
+    }
+    if(thread->thread.joinable()) thread->thread.join();
+    return 0;
+}
+
+Result threadClose(Thread* t) {
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    delete g_threads[t->handle];
+    g_threads.erase(t->handle);
+    return 0;
+}
+
+Handle threadGetCurHandle(void) {
+    return t_currentHandle;
+}
+
+void ueventCreate(UEvent* e, bool autoclear) {
+    auto* event = new HostEvent;
+    event->autoclear = autoclear;
+    e->impl = event;
+}
+
+void ueventSignal(UEvent* e) {
+    auto* event = static_cast<HostEvent*>(e->impl);
+    std::lock_guard<std::mutex> lock(event->mutex);
+    event->set = true;
+    event->signaled.notify_all();
+}
+
+Result eventWait(Event*, u64) {
+    // The only events waited on directly are vsyncs, which the host does not pace
+    return 0;
+}
+
+void eventClose(Event*) {}
+
+Waiter waiterForUEvent(UEvent* e) {
+    return Waiter { e->impl };
+}
+
+Waiter waiterForEvent(Event*) {
+    // Kernel events are never signaled on the host
+    return Waiter { nullptr };
+}
+
+Result waitSingle(Waiter w, u64 timeout) {
+    auto* event = static_cast<HostEvent*>(w.object);
+    std::unique_lock<std::mutex> lock(event->mutex);
+    if(!event->signaled.wait_for(lock, std::chrono::nanoseconds(timeout), [&] { return event->set; })) {
+        return KERNELRESULT(TimedOut);
+    }
+    if(event->autoclear) event->set = false;
+    return 0;
+}
+
+Result waitObjects(s32* idx_out, const Waiter* objects, s32 num_objects, u64 timeout) {
+    const auto& deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(std::min<u64>(timeout, INT64_MAX / 2));
+
+    while(true) {
+        for(s32 i = 0; i < num_objects; i++) {
+            auto* event = static_cast<HostEvent*>(objects[i].object);
+            if(event == nullptr) continue;
+
+            std::lock_guard<std::mutex> lock(event->mutex);
+            if(event->set) {
+                if(event->autoclear) event->set = false;
+                *idx_out = i;
+                return 0;
+            }
+        }
+
+        if(std::chrono::steady_clock::now() >= deadline) return KERNELRESULT(TimedOut);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+/* pm: the running application set by the tests, launches cannot be hooked */
+Result pmdmntInitialize(void) { return 0; }
+void pmdmntExit(void) {}
+
+Result pmdmntGetApplicationProcessId(u64* pid_out) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    if(g_applicationPid == 0) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    *pid_out = g_applicationPid;
+    return 0;
+}
+
+Result pmdmntGetProgramId(u64* program_id_out, u64 pid) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    if(pid == 0 || pid != g_applicationPid) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    *program_id_out = g_applicationId;
+    return 0;
+}
+
+Result pmdmntHookToCreateApplicationProcess(Event*) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+Result pmdmntStartProcess(u64) { g_ipcCalls++; return 0; }
+Result pmdmntClearHook(u32) { return 0; }
+
+/* account: the users added by the tests. Opening and closing a session are requests too. */
+Result accountInitialize(AccountServiceType) { g_ipcCalls++; return 0; }
+void accountExit(void) { g_ipcCalls++; }
+
+Result accountGetPreselectedUser(AccountUid*) {
+    g_ipcCalls++;
+    return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+}
+
+Result accountGetLastOpenedUser(AccountUid* uid) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    *uid = g_lastOpenedUser;
+    return 0;
+}
+
+Result accountGetUserCount(s32* user_count) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    *user_count = g_users.size();
+    return 0;
+}
+
+Result accountListAllUsers(AccountUid* uids, s32 max_uids, s32* actual_total) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    *actual_total = std::min<s32>(max_uids, g_users.size());
+    for(s32 i = 0; i < *actual_total; i++) uids[i] = g_users[i].uid;
+    return 0;
+}
+
+Result accountGetProfile(AccountProfile* out, AccountUid uid) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    for(size_t i = 0; i < g_users.size(); i++) {
+        if(g_users[i].uid.uid[0] == uid.uid[0] && g_users[i].uid.uid[1] == uid.uid[1]) {
+            out->s.session = i;
+            return 0;
+        }
+    }
+    return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+}
+
+Result accountProfileGet(AccountProfile* profile, AccountUserData* userdata, AccountProfileBase* profilebase) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    const auto& user = g_users.at(profile->s.session);
+    if(userdata != nullptr) *userdata = {};
+    if(profilebase != nullptr) {
+        *profilebase = {};
+        profilebase->uid = user.uid;
+        profilebase->last_edit_timestamp = user.lastEdit;
+        std::strncpy(profilebase->nickname, user.nickname.c_str(), sizeof(profilebase->nickname) - 1);
+    }
+    return 0;
+}
+
+void accountProfileClose(AccountProfile*) { g_ipcCalls++; }
+
+/* time: the clock of the host */
+Result timeGetCurrentTime(TimeType, u64* timestamp) {
+    g_ipcCalls++;
+    *timestamp = std::time(nullptr);
+    return 0;
+}
+
+Result timeToCalendarTimeWithMyRule(u64 timestamp, TimeCalendarTime* caltime, TimeCalendarAdditionalInfo* info) {
+    const time_t time = timestamp;
+    struct tm calendar;
+    gmtime_r(&time, &calendar);
+
+    *caltime = {};
+    caltime->year = calendar.tm_year + 1900;
+    caltime->month = calendar.tm_mon + 1;
+    caltime->day = calendar.tm_mday;
+    caltime->hour = calendar.tm_hour;
+    caltime->minute = calendar.tm_min;
+    caltime->second = calendar.tm_sec;
+    if(info != nullptr) *info = {};
+    return 0;
+}
+
+Result nsInitialize(void) { g_ipcCalls++; return 0; }
+void nsExit(void) { g_ipcCalls++; }
+
+/* ns: the applications installed by the tests, their control data is the NACP followed by an empty icon */
+Result nsGetApplicationControlData(NsApplicationControlSource, u64 application_id, NsApplicationControlData* buffer, size_t size, u64* actual_size) {
+    g_ipcCalls++;
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    const auto& it = g_applications.find(application_id);
+    if(it == g_applications.end()) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    if(size < sizeof(NacpStruct)) return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+
+    std::memset(buffer, 0, size);
+    for(auto& entry : buffer->nacp.lang) {
+        std::strncpy(entry.name, it->second.c_str(), sizeof(entry.name) - 1);
+    }
+
+    // The transfer covers the buffer given, up to the whole control data
+    *actual_size = std::min(size, sizeof(NsApplicationControlData));
+    g_ipcBytes += *actual_size;
+    return 0;
+}
+
+Result nacpGetLanguageEntry(NacpStruct* nacp, NacpLanguageEntry** langentry) {
+    *langentry = &nacp->lang[0];
+    return 0;
+}
+
+/* other services: not available on the host, tests provide their own ServiceDriver */
+Result timeInitialize(void) { return 0; }
+void timeExit(void) {}
+Result hidInitialize(void) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+void hidExit(void) {}
+Result hidsysInitialize(void) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+void hidsysExit(void) {}
+
+Result smInitialize(void) { return 0; }
+void smExit(void) {}
+Result setInitialize(void) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+void setExit(void) {}
+Result setGetSystemLanguage(u64*) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+Result setMakeLanguage(u64, SetLanguage*) { return MAKERESULT(Module_Libnx, LibnxError_NotInitialized); }
+
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType type) {
+    *font = {};
+    font->type = type;
+    font->size = sizeof(g_emptyFont);
+    font->address = const_cast<u8*>(g_emptyFont);
+    return 0;
+}
+
+ssize_t decode_utf8(u32* out, const u8* in) {
+    const u8 lead = in[0];
+    const ssize_t units = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : -1;
+    if(units < 0) return -1;
+
+    u32 code = units == 1 ? lead : lead & (0x7F >> units);
+    for(ssize_t i = 1; i < units; i++) {
+        if((in[i] & 0xC0) != 0x80) return -1;
+        code = (code << 6) | (in[i] & 0x3F);
+    }
+
+    *out = code;
+    return units;
+}
+
+/* vi, framebuffer: the display is a set of buffers in memory */
+Result viInitialize(ViServiceType) { return 0; }
+void viExit(void) {}
+Result viOpenDefaultDisplay(ViDisplay* display) { *display = {}; return 0; }
+Result viCloseDisplay(ViDisplay*) { return 0; }
+Result viGetDisplayVsyncEvent(ViDisplay*, Event* event) { *event = {}; return 0; }
+Result viCreateLayer(const ViDisplay*, ViLayer* layer) { *layer = {}; return 0; }
+Result viCloseLayer(ViLayer*) { return 0; }
+Result viSetLayerScalingMode(ViLayer*, ViScalingMode) { return 0; }
+Result viSetLayerZ(ViLayer*, s32) { return 0; }
+Result viSetLayerSize(ViLayer*, s32, s32) { return 0; }
+Result viSetLayerPosition(ViLayer*, float, float) { return 0; }
+
+Result nwindowCreateFromLayer(NWindow* nw, const ViLayer*) {
+    nw->cur_slot = 0;
+    return 0;
+}
+
+void nwindowClose(NWindow*) {}
+
+Result framebufferCreate(Framebuffer* fb, NWindow* win, u32 width, u32 height, u32, u32 num_fbs) {
+    // Block-linear surfaces are made of blocks of 32 pixels by 128 lines
+    *fb = {};
+    fb->win = win;
+    fb->width_aligned = (width + 31) & ~31;
+    fb->height_aligned = (height + 127) & ~127;
+    fb->stride = fb->width_aligned * sizeof(u16);
+    fb->fb_size = fb->stride * fb->height_aligned;
+    fb->num_fbs = num_fbs;
+    fb->buf = std::calloc(num_fbs, fb->fb_size);
+    fb->has_init = true;
+
+    // The first framebufferBegin() dequeues the first slot
+    win->cur_slot = num_fbs - 1;
+    return 0;
+}
+
+void* framebufferBegin(Framebuffer* fb, u32* out_stride) {
+    fb->win->cur_slot = (fb->win->cur_slot + 1) % fb->num_fbs;
+    if(out_stride != nullptr) *out_stride = fb->stride;
+    return static_cast<u8*>(fb->buf) + fb->win->cur_slot * fb->fb_size;
+}
+
+Result framebufferEnd(Framebuffer* fb) {
+    g_presentedFramebuffer = static_cast<u8*>(fb->buf) + fb->win->cur_slot * fb->fb_size;
+    g_presentedSize = fb->fb_size;
+    return 0;
+}
+
+void framebufferClose(Framebuffer* fb) {
+    if(!fb->has_init) return;
+    std::free(fb->buf);
+    g_presentedFramebuffer = nullptr;
+    g_presentedSize = 0;
+    *fb = {};
+}
+
+const void* hostPresentedFramebuffer(size_t* size) {
+    *size = g_presentedSize;
+    return g_presentedFramebuffer;
+}
+
+/* crypto, random */
+void sha256CalculateHash(void* dst, const void* src, size_t size) {
+    Sha256Context ctx;
+    sha256Init(&ctx);
+    sha256Update(&ctx, src, size);
+    sha256Final(&ctx, dst);
+}
+
+void hmacSha256CreateContext(HmacSha256Context* out, const void* key, size_t key_size) {
+    *out = {};
+    u8* paddedKey = reinterpret_cast<u8*>(out->key);
+    if(key_size > SHA256_BLOCK_SIZE) {
+        sha256CalculateHash(paddedKey, key, key_size);
+    } else {
+        std::memcpy(paddedKey, key, key_size);
+    }
+
+    u8 innerPad[SHA256_BLOCK_SIZE];
+    for(u32 i = 0; i < SHA256_BLOCK_SIZE; i++) innerPad[i] = paddedKey[i] ^ 0x36;
+    sha256Init(&out->sha_ctx);
+    sha256Update(&out->sha_ctx, innerPad, sizeof(innerPad));
+}
+
+void hmacSha256ContextUpdate(HmacSha256Context* ctx, const void* src, size_t size) {
+    sha256Update(&ctx->sha_ctx, src, size);
+}
+
+void hmacSha256ContextGetMac(HmacSha256Context* ctx, void* dst) {
+    if(!ctx->finalized) {
+        u8 inner[SHA256_HASH_SIZE];
+        sha256Final(&ctx->sha_ctx, inner);
+
+        const u8* paddedKey = reinterpret_cast<const u8*>(ctx->key);
+        u8 outerPad[SHA256_BLOCK_SIZE];
+        for(u32 i = 0; i < SHA256_BLOCK_SIZE; i++) outerPad[i] = paddedKey[i] ^ 0x5C;
+
+        sha256Init(&ctx->sha_ctx);
+        sha256Update(&ctx->sha_ctx, outerPad, sizeof(outerPad));
+        sha256Update(&ctx->sha_ctx, inner, sizeof(inner));
+        sha256Final(&ctx->sha_ctx, ctx->mac);
+        ctx->finalized = true;
+    }
+    std::memcpy(dst, ctx->mac, SHA256_HASH_SIZE);
+}
+
+void hmacSha256CalculateMac(void* dst, const void* key, size_t key_size, const void* src, size_t size) {
+    HmacSha256Context ctx;
+    hmacSha256CreateContext(&ctx, key, key_size);
+    hmacSha256ContextUpdate(&ctx, src, size);
+    hmacSha256ContextGetMac(&ctx, dst);
+}
+
+void randomGet(void* buf, size_t len) {
+    static std::random_device device;
+    u8* out = static_cast<u8*>(buf);
+    for(size_t i = 0; i < len; i++) out[i] = device();
+}
+
+u64 randomGet64(void) {
+    u64 value;
+    randomGet(&value, sizeof(value));
+    return value;
+}
+
+/* fs */
+Result fsOpenSdCardFileSystem(FsFileSystem*) {
+    // Like any SD card prepared for Atmosphère
+    mkdir(g_sdRoot.c_str(), 0755);
+    mkdir(hostPath("/config").c_str(), 0755);
+    return 0;
+}
+
+void fsFsClose(FsFileSystem*) {}
+
+Result fsFsCommit(FsFileSystem*) {
+    return 0;
+}
+
+Result fsFsCreateFile(FsFileSystem*, const char* path, s64 size, u32) {
+    g_sdRequests++;
+    if(g_sdWritesFail) return IoError;
+    const int fd = open(hostPath(path).c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) return IoError;
+    const bool sized = ftruncate(fd, size) == 0;
+    close(fd);
+    return sized ? 0 : IoError;
+}
+
+Result fsFsDeleteFile(FsFileSystem*, const char* path) {
+    g_sdRequests++;
+    return unlink(hostPath(path).c_str()) == 0 ? 0 : IoError;
+}
+
+Result fsFsRenameFile(FsFileSystem*, const char* cur_path, const char* new_path) {
+    g_sdRequests++;
+    if(g_sdWritesFail) return IoError;
+
+    // Like the console, a file is never renamed over another one
+    struct stat st;
+    if(stat(hostPath(new_path).c_str(), &st) == 0) return IoError;
+    return rename(hostPath(cur_path).c_str(), hostPath(new_path).c_str()) == 0 ? 0 : IoError;
+}
+
+Result fsFsCreateDirectory(FsFileSystem*, const char* path) {
+    g_sdRequests++;
+    return mkdir(hostPath(path).c_str(), 0755) == 0 ? 0 : IoError;
+}
+
+Result fsFsGetEntryType(FsFileSystem*, const char* path, FsDirEntryType* out) {
+    g_sdRequests++;
+    struct stat st;
+    if(stat(hostPath(path).c_str(), &st) != 0) return IoError;
+    *out = S_ISDIR(st.st_mode) ? FsDirEntryType_Dir : FsDirEntryType_File;
+    return 0;
+}
+
+Result fsFsGetFileTimeStampRaw(FsFileSystem*, const char* path, FsTimeStampRaw* out) {
+    g_sdRequests++;
+    struct stat st;
+    if(stat(hostPath(path).c_str(), &st) != 0) return IoError;
+    *out = {};
+    out->created = st.st_ctime;
+    out->modified = st.st_mtime;
+    out->accessed = st.st_atime;
+    out->is_valid = 1;
+    return 0;
+}
+
+Result fsFsOpenFile(FsFileSystem*, const char* path, u32 mode, FsFile* out) {
+    g_sdRequests++;
+    const int fd = open(hostPath(path).c_str(), (mode & (FsOpenMode_Write | FsOpenMode_Append)) ? O_RDWR : O_RDONLY);
+    if(fd < 0) return IoError;
+    std::lock_guard<std::mutex> lock(g_filesMutex);
+    g_files[out] = fd;
+    return 0;
+}
+
+Result fsFsOpenDirectory(FsFileSystem*, const char* path, u32, FsDir* out) {
+    g_sdRequests++;
+    DIR* dir = opendir(hostPath(path).c_str());
+    if(dir == nullptr) return IoError;
+    std::lock_guard<std::mutex> lock(g_filesMutex);
+    g_dirs[out] = dir;
+    return 0;
+}
+
+Result fsFileRead(FsFile* f, s64 off, void* buf, u64 read_size, u32, u64* bytes_read) {
+    g_sdRequests++;
+    const ssize_t read = pread(fileDescriptor(f), buf, read_size, off);
+    if(read < 0) return IoError;
+    *bytes_read = read;
+    return 0;
+}
+
+Result fsFileWrite(FsFile* f, s64 off, const void* buf, u64 write_size, u32) {
+    g_sdRequests++;
+    if(g_sdWritesFail) return IoError;
+
+    // Writing past the end extends the file, as with FsOpenMode_Append
+    const int fd = fileDescriptor(f);
+    struct stat st;
+    if(fstat(fd, &st) == 0 && off + static_cast<s64>(write_size) > st.st_size) g_sdExtendingWrites++;
+    if(pwrite(fd, buf, write_size, off) != static_cast<ssize_t>(write_size)) return IoError;
+
+    g_sdBytesWritten += write_size;
+    return 0;
+}
+
+Result fsFileFlush(FsFile*) {
+    g_sdRequests++;
+    return 0;
+}
+
+Result fsFileGetSize(FsFile* f, s64* out) {
+    g_sdRequests++;
+    struct stat st;
+    if(fstat(fileDescriptor(f), &st) != 0) return IoError;
+    *out = st.st_size;
+    return 0;
+}
+
+Result fsFileSetSize(FsFile* f, s64 sz) {
+    g_sdRequests++;
+    if(g_sdWritesFail) return IoError;
+    return ftruncate(fileDescriptor(f), sz) == 0 ? 0 : IoError;
+}
+
+void fsFileClose(FsFile* f) {
+    std::lock_guard<std::mutex> lock(g_filesMutex);
+    const auto& it = g_files.find(f);
+    if(it == g_files.end()) return;
+    close(it->second);
+    g_files.erase(it);
+}
+
+Result fsDirRead(FsDir* d, s64* total_entries, size_t max_entries, FsDirectoryEntry* buf) {
+    g_sdRequests++;
+    DIR* dir;
+    {
+        std::lock_guard<std::mutex> lock(g_filesMutex);
+        dir = g_dirs[d];
+    }
+
+    *total_entries = 0;
+    while(static_cast<size_t>(*total_entries) < max_entries) {
+        const dirent* entry = readdir(dir);
+        if(entry == nullptr) break;
+        if(std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) continue;
+
+        auto& out = buf[(*total_entries)++];
+        out = {};
+        std::snprintf(out.name, sizeof(out.name), "%s", entry->d_name);
+        out.type = entry->d_type == DT_DIR ? FsDirEntryType_Dir : FsDirEntryType_File;
+
+        struct stat st;
+        if(out.type == FsDirEntryType_File && fstatat(dirfd(dir), entry->d_name, &st, 0) == 0) out.file_size = st.st_size;
+    }
+    return 0;
+}
+
+Result fsDirGetEntryCount(FsDir* d, s64* count) {
+    DIR* dir;
+    {
+        std::lock_guard<std::mutex> lock(g_filesMutex);
+        dir = g_dirs[d];
+    }
+
+    *count = 0;
+    rewinddir(dir);
+    while(const dirent* entry = readdir(dir)) {
+        if(std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) (*count)++;
+    }
+    rewinddir(dir);
+    return 0;
+}
+
+void fsDirClose(FsDir* d) {
+    std::lock_guard<std::mutex> lock(g_filesMutex);
+    const auto& it = g_dirs.find(d);
+    if(it == g_dirs.end()) return;
+    closedir(it->second);
+    g_dirs.erase(it);
+}
+
+/* crc */
+u32 crc32Calculate(const void* src, size_t size) {
+    return crc32(0, static_cast<const Bytef*>(src), size);
+}
+
+u32 crc32CalculateWithSeed(u32 seed, const void* src, size_t size) {
+    return crc32(seed, static_cast<const Bytef*>(src), size);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <switch.h>
+
+/* Directory of the host standing for the root of the SD card, created if needed */
+void hostSetSdRoot(const char* path);
+
+/* Requests sent to the SD card so far: file and directory operations, reads and writes */
+u64 hostSdRequests();
+
+/* Bytes written to the files of the SD card so far, and the writes which made a file grow */
+u64 hostSdBytesWritten();
+u64 hostSdExtendingWrites();
+
+/* Makes the requests writing to the SD card (create, rename, write, resize) fail, as on a full or removed card */
+void hostFailSdWrites(bool fail);
+
+/* Content of the framebuffer last presented by framebufferEnd(), in the block-linear layout, and its size in bytes */
+const void* hostPresentedFramebuffer(size_t* size);
+
+/* Application running on the console, none if \p pid is 0 */
+void hostSetApplication(u64 pid, u64 programId);
+
+/* Users of the console and the last one who opened an application */
+void hostAddUser(AccountUid uid, const char* nickname);
+void hostSetLastOpenedUser(AccountUid uid);
+
+/* Application installed on the console, \p name is the name of all its languages */
+void hostInstallApplication(u64 titleId, const char* name);
+
+/* Requests sent to the pm, account, time and ns stand-ins so far, and bytes received from ns */
+u64 hostIpcCalls();
+u64 hostIpcBytes();
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+/* Emulation of the NEON intrinsics used by the renderer, lane by lane, so that its vector paths can be
+   checked on a host without NEON. Only enabled for the tests which are built with -Ihost/neon. */
+
+struct uint16x8_t { uint16_t lanes[8]; };
+
+#define NEON_LANES(expr) \
+    uint16x8_t result; \
+    for(int i = 0; i < 8; i++) result.lanes[i] = static_cast<uint16_t>(expr); \
+    return result
+
+inline uint16x8_t vdupq_n_u16(uint16_t value) { NEON_LANES(value); }
+inline uint16x8_t vld1q_u16(const uint16_t* ptr) { NEON_LANES(ptr[i]); }
+inline void vst1q_u16(uint16_t* ptr, uint16x8_t a) { for(int i = 0; i < 8; i++) ptr[i] = a.lanes[i]; }
+
+inline uint16x8_t vandq_u16(uint16x8_t a, uint16x8_t b) { NEON_LANES(a.lanes[i] & b.lanes[i]); }
+inline uint16x8_t vorrq_u16(uint16x8_t a, uint16x8_t b) { NEON_LANES(a.lanes[i] | b.lanes[i]); }
+inline uint16x8_t vaddq_u16(uint16x8_t a, uint16x8_t b) { NEON_LANES(a.lanes[i] + b.lanes[i]); }
+inline uint16x8_t vmulq_u16(uint16x8_t a, uint16x8_t b) { NEON_LANES(a.lanes[i] * b.lanes[i]); }
+inline uint16x8_t vminq_u16(uint16x8_t a, uint16x8_t b) { NEON_LANES(a.lanes[i] < b.lanes[i] ? a.lanes[i] : b.lanes[i]); }
+inline uint16x8_t vmlaq_u16(uint16x8_t a, uint16x8_t b, uint16x8_t c) { NEON_LANES(a.lanes[i] + b.lanes[i] * c.lanes[i]); }
+
+/* The shift amounts are immediates on NEON, any value is accepted here */
+inline uint16x8_t vshrq_n_u16(uint16x8_t a, int n) { NEON_LANES(a.lanes[i] >> n); }
+inline uint16x8_t vshlq_n_u16(uint16x8_t a, int n) { NEON_LANES(a.lanes[i] << n); }
+
+#undef NEON_LANES
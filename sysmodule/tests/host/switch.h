@@ -0,0 +1,300 @@
+#pragma once
+/* Host stand-in for the parts of libnx used by the sysmodule, so that its platform independent code
+   can be built and tested on a PC. Only the declarations are provided, host_nx.cpp implements the
+   functions the tests link with. The types keep the field names used by the sources, not the layouts. */
+#include <bit>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/types.h>
+
+#define FS_MAX_PATH 0x301
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef volatile u32 vu32;
+typedef u32 Result;
+typedef u32 Handle;
+
+#define BIT(n) (1U << (n))
+#define NX_INLINE static inline
+#define NX_CONSTEXPR static constexpr
+
+/* result.h */
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res) ((res) != 0)
+#define R_MODULE(res) ((res) & 0x1FF)
+#define R_DESCRIPTION(res) (((res) >> 9) & 0x1FFF)
+#define R_VALUE(res) ((res) & 0x3FFFFF)
+#define MAKERESULT(module, description) ((((module) & 0x1FF)) | ((description) & 0x1FFF) << 9)
+#define KERNELRESULT(description) MAKERESULT(Module_Kernel, KernelError_##description)
+
+enum { Module_Kernel = 1, Module_Libnx = 345, Module_HomebrewLoader = 347 };
+enum { KernelError_TimedOut = 117, KernelError_Cancelled = 118, KernelError_UnhandledUserInterrupt = 124 };
+enum {
+    LibnxError_BadInput = 1,
+    LibnxError_OutOfMemory = 2,
+    LibnxError_NotInitialized = 3,
+    LibnxError_NotFound = 4,
+    LibnxError_IoError = 5
+};
+
+/* runtime/hosversion.h */
+#define MAKEHOSVERSION(major, minor, micro) (((u32)(major) << 16) | ((u32)(minor) << 8) | (u32)(micro))
+bool hosversionAtLeast(u8 major, u8 minor, u8 micro);
+bool hosversionBefore(u8 major, u8 minor, u8 micro);
+void hosversionSet(u32 version);
+
+/* arm/counter.h */
+u64 armGetSystemTick(void);
+u64 armGetSystemTickFreq(void);
+u64 armNsToTicks(u64 ns);
+u64 armTicksToNs(u64 tick);
+
+/* kernel */
+typedef union { u64 x; u32 w; } CpuRegister;
+typedef struct {
+    u32 error_desc;
+    u32 pad[3];
+    CpuRegister cpu_gprs[29];
+    CpuRegister fp, lr, sp, pc;
+} ThreadExceptionDump;
+
+typedef struct { Handle revent; Handle wevent; bool autoclear; } Event;
+typedef struct { Handle handle; void* stack_mem; } Thread;
+typedef struct { u32 tag; } Mutex;
+typedef struct { u32 tag; } CondVar;
+typedef struct { void* impl; } UEvent;
+typedef struct { void* object; } Waiter;
+typedef struct { Handle handle; } TransferMemory;
+typedef u32 Permission;
+
+void svcSleepThread(s64 nano);
+Result svcReturnFromException(Result res);
+Result svcExitProcess(void);
+Result svcSetHeapSize(void** out_addr, u64 size);
+Result svcBreak(u32 reason, uintptr_t address, uintptr_t size);
+void fatalThrow(Result err);
+
+Result eventCreate(Event* t, bool autoclear);
+Result eventWait(Event* t, u64 timeout);
+Result eventFire(Event* t);
+Result eventClear(Event* t);
+void eventClose(Event* t);
+
+Result threadCreate(Thread* t, void (*entry)(void*), void* arg, void* stack_mem, size_t stack_sz, int prio, int cpuid);
+Result threadStart(Thread* t);
+Result threadWaitForExit(Thread* t);
+Result threadClose(Thread* t);
+Handle threadGetCurHandle(void);
+
+void mutexInit(Mutex* m);
+void mutexLock(Mutex* m);
+void mutexUnlock(Mutex* m);
+void condvarInit(CondVar* c);
+Result condvarWait(CondVar* c, Mutex* m);
+Result condvarWaitTimeout(CondVar* c, Mutex* m, u64 timeout);
+Result condvarWakeOne(CondVar* c);
+Result condvarWakeAll(CondVar* c);
+
+void ueventCreate(UEvent* e, bool autoclear);
+void ueventSignal(UEvent* e);
+Waiter waiterForUEvent(UEvent* e);
+Waiter waiterForEvent(Event* e);
+Result waitSingle(Waiter w, u64 timeout);
+Result waitObjects(s32* idx_out, const Waiter* objects, s32 num_objects, u64 timeout);
+#define waitMulti(idx_out, timeout, ...) ({ Waiter __objects[] = { __VA_ARGS__ }; waitObjects((idx_out), __objects, sizeof(__objects) / sizeof(Waiter), (timeout)); })
+
+Result tmemCreateFromMemory(TransferMemory* t, void* buf, size_t size, Permission perm);
+
+/* sm, services */
+typedef struct { Handle session; } Service;
+Result smInitialize(void);
+void smExit(void);
+Result serviceDispatchIn(Service* s, u32 request_id, ...);
+Result fsInitialize(void);
+
+typedef struct { u8 major, minor, micro; } SetSysFirmwareVersion;
+Result setsysInitialize(void);
+void setsysExit(void);
+Result setsysGetFirmwareVersion(SetSysFirmwareVersion* out);
+
+typedef enum { SetLanguage_JA, SetLanguage_ZHCN, SetLanguage_ZHHANS, SetLanguage_KO, SetLanguage_ZHTW, SetLanguage_ZHHANT } SetLanguage;
+Result setInitialize(void);
+void setExit(void);
+Result setGetSystemLanguage(u64* out);
+Result setMakeLanguage(u64 language_code, SetLanguage* language);
+
+Result pmdmntInitialize(void);
+void pmdmntExit(void);
+Result pmdmntGetApplicationProcessId(u64* pid_out);
+Result pmdmntGetProgramId(u64* program_id_out, u64 pid);
+Result pmdmntGetProcessId(u64* pid_out, u64 program_id);
+Result pmdmntHookToCreateApplicationProcess(Event* out_event);
+Result pmdmntStartProcess(u64 pid);
+Result pmdmntClearHook(u32 which);
+
+Result nsInitialize(void);
+void nsExit(void);
+
+/* account */
+typedef struct { u64 uid[2]; } AccountUid;
+static inline bool accountUidIsValid(const AccountUid* uid) { return uid->uid[0] != 0 || uid->uid[1] != 0; }
+
+typedef enum { AccountServiceType_Application, AccountServiceType_System, AccountServiceType_Administrator } AccountServiceType;
+typedef struct { Service s; } AccountProfile;
+typedef struct { u32 unk; u32 iconID; u8 iconBackgroundColorID; u8 unk_x9[7]; u8 miiID[0x10]; u8 unk_x20[0x60]; } AccountUserData;
+typedef struct { AccountUid uid; u64 last_edit_timestamp; char nickname[0x20 + 1]; } AccountProfileBase;
+#define ACC_USER_LIST_SIZE 8
+
+Result accountInitialize(AccountServiceType service_type);
+void accountExit(void);
+Result accountGetPreselectedUser(AccountUid* uid);
+Result accountGetLastOpenedUser(AccountUid* uid);
+Result accountGetUserCount(s32* user_count);
+Result accountListAllUsers(AccountUid* uids, s32 max_uids, s32* actual_total);
+Result accountGetProfile(AccountProfile* out, AccountUid uid);
+Result accountProfileGet(AccountProfile* profile, AccountUserData* userdata, AccountProfileBase* profilebase);
+void accountProfileClose(AccountProfile* profile);
+
+/* ns */
+typedef struct { char name[0x200]; char author[0x100]; } NacpLanguageEntry;
+typedef struct { NacpLanguageEntry lang[16]; u8 rest[0x1000]; } NacpStruct;
+typedef struct { NacpStruct nacp; u8 icon[0x20000]; } NsApplicationControlData;
+typedef enum { NsApplicationControlSource_CacheOnly, NsApplicationControlSource_Storage } NsApplicationControlSource;
+Result nsGetApplicationControlData(NsApplicationControlSource source, u64 application_id, NsApplicationControlData* buffer, size_t size, u64* actual_size);
+Result nacpGetLanguageEntry(NacpStruct* nacp, NacpLanguageEntry** langentry);
+
+/* time */
+typedef enum { TimeType_UserSystemClock, TimeType_NetworkSystemClock, TimeType_LocalSystemClock } TimeType;
+typedef struct { u16 year; u8 month, day, hour, minute, second, pad; } TimeCalendarTime;
+typedef struct { u32 wday, yday; char timezoneName[8]; u32 DST; s32 offset; } TimeCalendarAdditionalInfo;
+Result timeInitialize(void);
+void timeExit(void);
+Result timeGetCurrentTime(TimeType type, u64* timestamp);
+Result timeToCalendarTimeWithMyRule(u64 timestamp, TimeCalendarTime* caltime, TimeCalendarAdditionalInfo* info);
+
+/* hid */
+typedef enum { HidNpadIdType_No1 = 0, HidNpadIdType_Handheld = 0x20 } HidNpadIdType;
+enum { HidNpadStyleSet_NpadStandard = 0x1F, HidNpadStyleTag_NpadSystemExt = BIT(29) };
+typedef struct { u64 buttons[8]; } PadState;
+Result hidInitialize(void);
+void hidExit(void);
+Result hidsysInitialize(void);
+void hidsysExit(void);
+Service* hidsysGetServiceSession(void);
+Result hidSetSupportedNpadIdType(const HidNpadIdType* ids, size_t count);
+void padConfigureInput(u32 max_players, u32 style_set);
+void padInitialize(PadState* pad, ...);
+void padUpdate(PadState* pad);
+u64 padGetButtonsDown(const PadState* pad);
+
+/* fs */
+typedef struct { Service s; } FsFileSystem;
+typedef struct { Service s; } FsFile;
+typedef struct { Service s; } FsDir;
+
+enum { FsOpenMode_Read = BIT(0), FsOpenMode_Write = BIT(1), FsOpenMode_Append = BIT(2) };
+typedef enum { FsReadOption_None = 0 } FsReadOption;
+typedef enum { FsWriteOption_None = 0, FsWriteOption_Flush = BIT(0) } FsWriteOption;
+typedef enum { FsDirEntryType_Dir = 0, FsDirEntryType_File = 1 } FsDirEntryType;
+enum { FsDirOpenMode_ReadDirs = BIT(0), FsDirOpenMode_ReadFiles = BIT(1), FsDirOpenMode_NoFileSize = BIT(31) };
+
+typedef struct { char name[FS_MAX_PATH]; u8 pad[3]; s8 type; u8 pad2[3]; s64 file_size; } FsDirectoryEntry;
+typedef struct { u64 created; u64 modified; u64 accessed; u8 is_valid; u8 padding[7]; } FsTimeStampRaw;
+
+Result fsOpenSdCardFileSystem(FsFileSystem* out);
+void fsFsClose(FsFileSystem* fs);
+Result fsFsCommit(FsFileSystem* fs);
+Result fsFsCreateFile(FsFileSystem* fs, const char* path, s64 size, u32 option);
+Result fsFsDeleteFile(FsFileSystem* fs, const char* path);
+Result fsFsRenameFile(FsFileSystem* fs, const char* cur_path, const char* new_path);
+Result fsFsCreateDirectory(FsFileSystem* fs, const char* path);
+Result fsFsGetEntryType(FsFileSystem* fs, const char* path, FsDirEntryType* out);
+Result fsFsGetFileTimeStampRaw(FsFileSystem* fs, const char* path, FsTimeStampRaw* out);
+Result fsFsOpenFile(FsFileSystem* fs, const char* path, u32 mode, FsFile* out);
+Result fsFsOpenDirectory(FsFileSystem* fs, const char* path, u32 mode, FsDir* out);
+
+Result fsFileRead(FsFile* f, s64 off, void* buf, u64 read_size, u32 option, u64* bytes_read);
+Result fsFileWrite(FsFile* f, s64 off, const void* buf, u64 write_size, u32 option);
+Result fsFileFlush(FsFile* f);
+Result fsFileGetSize(FsFile* f, s64* out);
+Result fsFileSetSize(FsFile* f, s64 sz);
+void fsFileClose(FsFile* f);
+
+Result fsDirRead(FsDir* d, s64* total_entries, size_t max_entries, FsDirectoryEntry* buf);
+Result fsDirGetEntryCount(FsDir* d, s64* count);
+void fsDirClose(FsDir* d);
+
+/* crypto, random, crc */
+#define SHA256_HASH_SIZE 0x20
+#define SHA256_BLOCK_SIZE 0x40
+typedef struct { u8 state[0x80]; } Sha256Context;
+typedef struct { Sha256Context sha_ctx; u32 key[SHA256_BLOCK_SIZE / sizeof(u32)]; u8 mac[SHA256_HASH_SIZE]; bool finalized; } HmacSha256Context;
+void sha256CalculateHash(void* dst, const void* src, size_t size);
+void hmacSha256CreateContext(HmacSha256Context* out, const void* key, size_t key_size);
+void hmacSha256ContextUpdate(HmacSha256Context* ctx, const void* src, size_t size);
+void hmacSha256ContextGetMac(HmacSha256Context* ctx, void* dst);
+void hmacSha256CalculateMac(void* dst, const void* key, size_t key_size, const void* src, size_t size);
+void randomGet(void* buf, size_t len);
+u64 randomGet64(void);
+u32 crc32Calculate(const void* src, size_t size);
+u32 crc32CalculateWithSeed(u32 seed, const void* src, size_t size);
+
+/* vi, framebuffer */
+typedef struct { u64 display_id; } ViDisplay;
+typedef struct { u64 layer_id; } ViLayer;
+typedef u32 ViLayerStack;
+typedef u32 ViLayerFlags;
+typedef enum { ViServiceType_Manager = 2 } ViServiceType;
+typedef enum { ViScalingMode_FitToLayer = 2 } ViScalingMode;
+typedef struct { u32 cur_slot; } NWindow;
+typedef struct { NWindow* win; void* buf; u32 stride, width_aligned, height_aligned, num_fbs, fb_size; bool has_init; } Framebuffer;
+enum { PIXEL_FORMAT_RGBA_4444 = 7 };
+
+Result viInitialize(ViServiceType service_type);
+void viExit(void);
+Service* viGetSession_IManagerDisplayService(void);
+Result viOpenDefaultDisplay(ViDisplay* display);
+Result viCloseDisplay(ViDisplay* display);
+Result viGetDisplayVsyncEvent(ViDisplay* display, Event* event_out);
+Result viCreateLayer(const ViDisplay* display, ViLayer* layer);
+Result viCloseLayer(ViLayer* layer);
+Result viSetLayerScalingMode(ViLayer* layer, ViScalingMode scaling_mode);
+Result viSetLayerZ(ViLayer* layer, s32 z);
+Result viSetLayerSize(ViLayer* layer, s32 width, s32 height);
+Result viSetLayerPosition(ViLayer* layer, float x, float y);
+Result nwindowCreateFromLayer(NWindow* nw, const ViLayer* layer);
+void nwindowClose(NWindow* nw);
+Result framebufferCreate(Framebuffer* fb, NWindow* win, u32 width, u32 height, u32 format, u32 num_fbs);
+void* framebufferBegin(Framebuffer* fb, u32* out_stride);
+Result framebufferEnd(Framebuffer* fb);
+void framebufferClose(Framebuffer* fb);
+
+/* pl */
+typedef enum { PlServiceType_User, PlServiceType_System } PlServiceType;
+typedef enum {
+    PlSharedFontType_Standard,
+    PlSharedFontType_ChineseSimplified,
+    PlSharedFontType_ExtChineseSimplified,
+    PlSharedFontType_ChineseTraditional,
+    PlSharedFontType_KO,
+    PlSharedFontType_NintendoExt
+} PlSharedFontType;
+typedef struct { u32 type; u32 offset; u32 size; void* address; } PlFontData;
+Result plInitialize(PlServiceType service_type);
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType shared_font_type);
+
+enum { AppletType_None = -2 };
+
+/* runtime/util/utf.h */
+ssize_t decode_utf8(u32* out, const u8* in);
@@ -0,0 +1,84 @@
+#include "host/host_nx.h"
+#include "helpers.h"
+#include "platform_snapshot.h"
+#include "profile_table.h"
+
+/* Requests sent by the monitor on each of its checks, for a day of checks while games are played and users
+   switched: the sequence it used before the snapshots, the helpers which replaced it, and the snapshots. The
+   snapshots report their own count, which is checked against the requests received by the stand-in. */
+
+using namespace alefbet::authenticator::srv;
+using namespace alefbet::authenticator::helpers;
+
+constexpr u32 Ticks = 100'000;
+constexpr u32 UsersCount = 4;
+
+/* The console as seen on a given check: a game every 1000 checks, a user switch every 250 */
+static void playTick(u32 tick) {
+    hostSetApplication(tick % 1000 < 800 ? 100 + tick / 1000 : 0, 0x0100000000010000 + tick / 1000);
+    hostSetLastOpenedUser(AccountUid { { 0x1000 + (tick / 250) % UsersCount, 0x2000 } });
+}
+
+/* The check before the snapshots, with a session and the profile opened each time */
+static void initialCheck() {
+    u64 pid = 0, programId = 0;
+    if(R_SUCCEEDED(pmdmntGetApplicationProcessId(&pid))) {
+        pmdmntGetProgramId(&programId, pid);
+    }
+
+    if(R_FAILED(accountInitialize(AccountServiceType_Administrator))) return;
+
+    AccountUid uid;
+    if(R_FAILED(accountGetPreselectedUser(&uid))) accountGetLastOpenedUser(&uid);
+
+    AccountProfile profile;
+    AccountProfileBase base;
+    if(R_SUCCEEDED(accountGetProfile(&profile, uid))) {
+        accountProfileGet(&profile, nullptr, &base);
+        accountProfileClose(&profile);
+    }
+
+    accountExit();
+}
+
+template<typename F>
+static void measure(const char* name, F&& check) {
+    const u64 start = hostIpcCalls();
+    for(u32 tick = 0; tick < Ticks; tick++) {
+        playTick(tick);
+        check();
+    }
+
+    std::printf("  %-28s %5.2f requests per check\n", name, (hostIpcCalls() - start) / double(Ticks));
+}
+
+int main() {
+    for(u32 user = 0; user < UsersCount; user++) {
+        hostAddUser(AccountUid { { 0x1000 + user, 0x2000 } }, "Player");
+    }
+    ProfileTable::get().load();
+
+    std::printf("Monitor checks, %u checks\n", Ticks);
+
+    measure("initial sequence", initialCheck);
+
+    measure("helpers", [] {
+        const u64 pid = getRunningApplicationPid();
+        if(pid != 0) getRunningApplicationTitleId(pid);
+        getCurrentUser();
+    });
+
+    PlatformQuery query;
+    query.open();
+    u64 userChanges = 0;
+    const u64 start = hostIpcCalls();
+    measure("snapshots", [&] {
+        userChanges += query.take().userChanged;
+    });
+
+    std::printf("  snapshots counted %lu requests for %lu snapshots (%lu received), %lu user changes\n",
+        query.totalIpcCalls(), query.snapshots(), hostIpcCalls() - start, userChanges);
+    query.close();
+
+    return 0;
+}
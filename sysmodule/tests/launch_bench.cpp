@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "scripted_console.h"
+#include "monitor.h"
+
+/* Time between the launch of a game and the authentication panel, with the pm:dmnt hook and with the polling
+   it replaced (the hook being unavailable), over a virtual day of play. The latencies are in virtual time, the
+   handling of the launch itself is not counted. */
+
+constexpr u64 Millisecond = 1'000'000;
+constexpr u64 Minute = 60'000 * Millisecond;
+constexpr u32 Games = 200;
+constexpr AccountUid User = { { 0x1111, 0x2222 } };
+
+static ScriptedConsole* g_console = nullptr;
+static std::vector<u64> g_latencies;
+
+void GuiController::showAuthenticationPanel(const UserData&) {
+    g_latencies.push_back(g_console->now() - g_console->launchTime());
+}
+
+void GuiController::hideAll() {}
+
+/* Counts the wakeups of the monitor thread */
+class CountingConsole : public ScriptedConsole {
+    public:
+        void sleep(s64 ns) override {
+            sleeps++;
+            ScriptedConsole::sleep(ns);
+        }
+
+        u64 sleeps = 0;
+};
+
+static void run(const char* name, u32 failedOpens) {
+    CountingConsole console;
+    ScriptedLaunchSource source(console, failedOpens);
+    GuiController gui;
+    Monitor monitor(&gui, &source, &console);
+
+    // Games of 1 to 20 minutes, 1 to 10 minutes apart
+    std::srand(1);
+    u64 time = Minute;
+    for(u32 game = 0; game < Games; game++) {
+        time += (std::rand() % 540 + 60) * 1000 * Millisecond;
+        console.launch(time, 100 + game, 0x0100000000010000 + game);
+        time += (std::rand() % 1140 + 60) * 1000 * Millisecond;
+        console.close(time);
+    }
+    console.stopAt(time + Minute, [&] { monitor.shutdown(); });
+
+    g_console = &console;
+    g_latencies.clear();
+    const u64 ipcCalls = hostIpcCalls();
+
+    monitor.start();
+    monitor.loop();
+
+    std::sort(g_latencies.begin(), g_latencies.end());
+    const auto& percentile = [](u32 p) { return g_latencies[(g_latencies.size() - 1) * p / 100] / double(Millisecond); };
+    const double hours = console.now() / (60.0 * Minute);
+
+    std::printf("  %-10s %3zu launches  latency p50 %7.1f ms  p95 %7.1f ms  max %7.1f ms  %6.0f wakeups/h  %6.0f IPC/h\n",
+        name, g_latencies.size(), percentile(50), percentile(95), percentile(100),
+        console.sleeps / hours, (hostIpcCalls() - ipcCalls) / hours);
+}
+
+int main() {
+    hostAddUser(User, "Player");
+    hostSetLastOpenedUser(User);
+
+    std::printf("Launch detection, %u games\n", Games);
+    run("hook", 0);
+    run("polling", UINT32_MAX);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* Bytes written to the SD card for the same session logged as text and as binary records, and the time taken to
+   encode a line each way. The session is an hour of monitor ticks with the uid trace, games launched every few
+   minutes with the PIN entered, and the database and renderer lines that go with them. The binary records also
+   hold a tick, which the text lines do not. */
+
+using namespace alefbet::authenticator;
+
+constexpr u32 Ticks = 3600;
+constexpr u32 Encodings = 200'000;
+
+/* Logs a line as text or as a binary record, the format id is computed by the compiler as with LOG_BINARY */
+#define BENCH_LOG(binary, fmt, ...) \
+    do { \
+        if(binary) { \
+            logger::logBinary(logger::logFormatId(fmt), logger::LogInfo, logger::LogCategory_Main __VA_OPT__(,) __VA_ARGS__); \
+        } else { \
+            logger::logToFile(fmt __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while(0)
+
+static u64 g_lines = 0;
+static volatile u8 g_sink;
+
+/* Written by the ring every few lines, so that none is dropped */
+static void lineLogged() {
+    if(++g_lines % 16 == 0) logger::flush();
+}
+
+static void playSession(bool binary) {
+    const AccountUid uid = { { 0x0123456789ABCDEF, 0x1122334455667788 } };
+
+    for(u32 tick = 0; tick < Ticks; tick++) {
+        BENCH_LOG(binary, "[Monitor] uid=%lu:%lu, Nickname=%s\n", uid.uid[0], uid.uid[1], "Player");
+        lineLogged();
+
+        if(tick % 300 != 0) continue;
+
+        // A launch: the panel, four keys and the check of the PIN
+        BENCH_LOG(binary, "[Monitor] Application launched: pid %lu, program %016lX\n", 100UL + tick, 0x0100000000010000UL + tick);
+        lineLogged();
+        BENCH_LOG(binary, "[Renderer] Display list frame: %u of %lu nodes drawn\n", 12u, 14UL);
+        lineLogged();
+        for(u32 key = 0; key < 4; key++) {
+            BENCH_LOG(binary, "[Gui] Key %u pressed\n", key);
+            lineLogged();
+            BENCH_LOG(binary, "[Renderer] Frame %lu: %lu pixels drawn\n", 1UL + key, 2401UL);
+            lineLogged();
+        }
+        BENCH_LOG(binary, "[Database] PIN derivation took %lu us\n", 48213UL);
+        lineLogged();
+        BENCH_LOG(binary, "[Monitor] Authentication succeeded\n");
+        lineLogged();
+    }
+
+    logger::flush();
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+
+    logger::clearLog();
+    logger::startFlusher();
+
+    std::printf("Log bytes for a session of %u ticks\n", Ticks);
+    u64 textBytes = 0;
+    for(bool binary : { false, true }) {
+        const auto& before = logger::stats();
+        g_lines = 0;
+        playSession(binary);
+        const auto& after = logger::stats();
+
+        const u64 bytes = after.bytesWritten - before.bytesWritten;
+        if(!binary) textBytes = bytes;
+        std::printf("  %-8s %6lu lines  %8lu bytes  %5.1f bytes/line  %lu dropped\n", binary ? "binary" : "text",
+            g_lines, bytes, double(bytes) / g_lines, after.dropped - before.dropped);
+        if(binary) std::printf("  binary/text %.2f\n", double(bytes) / textBytes);
+    }
+
+    logger::stopFlusher();
+
+    std::printf("Encoding of the uid trace\n");
+    const AccountUid uid = { { 0x0123456789ABCDEF, 0x1122334455667788 } };
+    char text[logger::LogRecordMaxSize];
+    u64 size = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Encodings; i++) {
+        size += snprintf(text, sizeof(text), "[Monitor] uid=%lu:%lu, Nickname=%s\n", uid.uid[0] + i, uid.uid[1], "Player");
+    }
+    double ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / Encodings;
+    std::printf("  %-8s %6.1f ns  %5.1f bytes\n", "text", ns, double(size) / Encodings);
+
+    size = 0;
+    start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Encodings; i++) {
+        logger::LogRecordWriter<> writer(logger::logFormatId("[Monitor] uid=%lu:%lu, Nickname=%s\n"), logger::LogTrace, logger::LogCategory_Monitor);
+        writer.add(uid.uid[0] + i);
+        writer.add(uid.uid[1]);
+        writer.add("Player");
+        g_sink = writer.data()[0];
+        size += writer.size();
+    }
+    ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / Encodings;
+    std::printf("  %-8s %6.1f ns  %5.1f bytes\n", "binary", ns, double(size) / Encodings);
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <cstdarg>
+#include <mutex>
+#include <vector>
+#include <elf.h>
+#include <x86intrin.h>
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* Code size and cost of a log call site, by level: a trace compiled out below LOG_MIN_LEVEL, a debug line
+   filtered at runtime, an info line written as text and as a binary record, and the logger before the levels,
+   which formatted and wrote every line. The sizes are those of the functions holding each call, read from the
+   symbol table of the benchmark, the format strings are looked for in its file. Cycles are counted with the
+   time stamp counter, the lines written by the ring are flushed outside of the measures. The flight recorder
+   is left out (LOG_FLIGHT_SLOTS=0). */
+
+using namespace alefbet::authenticator;
+
+constexpr const char* ReferenceFilename = "/atmosphere/logs/authenticator_reference.log";
+constexpr u32 Calls = 20'000;
+constexpr u32 Block = 16;       ///< Calls measured between two flushes, below the high water mark of the ring
+
+/* The logger before the levels: every line formatted, written and flushed */
+static std::mutex s_referenceMutex;
+static char g_referenceBuffer[8192];
+static s64 s_referenceOffset = 0;
+
+static void referenceLog(const char* fmt, ...) {
+    std::lock_guard<std::mutex> lock(s_referenceMutex);
+
+    FsFileSystem* sdmc = services::SdCard::get().fs();
+    FsFile file;
+    if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) {
+        if(R_FAILED(fsFsCreateFile(sdmc, ReferenceFilename, 0, 0))) return;
+        if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) return;
+    }
+
+    std::va_list vl;
+    va_start(vl, fmt);
+    vsnprintf(g_referenceBuffer, sizeof(g_referenceBuffer), fmt, vl);
+    va_end(vl);
+
+    const size_t size = std::strlen(g_referenceBuffer);
+    if(R_SUCCEEDED(fsFileWrite(&file, s_referenceOffset, g_referenceBuffer, size, FsWriteOption_Flush))) {
+        s_referenceOffset += size;
+    }
+    fsFileClose(&file);
+}
+
+/* The call sites, each with its own format string */
+extern "C" {
+    __attribute__((noinline)) void siteTrace(u32 tick, u64 uid) {
+        LOG_TRACE(Monitor, "Trace site: tick %u uid %016lx\n", tick, uid);
+    }
+
+    __attribute__((noinline)) void siteDebug(u32 tick, u64 uid) {
+        LOG_DEBUG(Monitor, "Debug site: tick %u uid %016lx\n", tick, uid);
+    }
+
+    __attribute__((noinline)) void siteText(u32 tick, u64 uid) {
+        LOG_INFO(Monitor, "Text site: tick %u uid %016lx\n", tick, uid);
+    }
+
+    /* LOG_INFO as expanded with -DLOG_BINARY */
+    __attribute__((noinline)) void siteBinary(u32 tick, u64 uid) {
+        if(logger::isEnabled(logger::LogInfo, logger::LogCategory_Monitor)) {
+            logger::logBinary(logger::logFormatId("[Monitor] Binary site: tick %u uid %016lx\n"), logger::LogInfo,
+                logger::LogCategory_Monitor, tick, uid);
+        }
+    }
+
+    __attribute__((noinline)) void siteReference(u32 tick, u64 uid) {
+        referenceLog("[Monitor] Reference site: tick %u uid %016lx\n", tick, uid);
+    }
+}
+
+/* Size of the function \p name in the symbol table of the benchmark, 0 if not found */
+static size_t functionSize(const std::vector<u8>& elf, const char* name) {
+    if(elf.size() < sizeof(Elf64_Ehdr)) return 0;
+    const auto* header = reinterpret_cast<const Elf64_Ehdr*>(elf.data());
+    const auto* sections = reinterpret_cast<const Elf64_Shdr*>(elf.data() + header->e_shoff);
+
+    for(u32 i = 0; i < header->e_shnum; i++) {
+        if(sections[i].sh_type != SHT_SYMTAB) continue;
+
+        const auto* symbols = reinterpret_cast<const Elf64_Sym*>(elf.data() + sections[i].sh_offset);
+        const char* names = reinterpret_cast<const char*>(elf.data() + sections[sections[i].sh_link].sh_offset);
+        for(size_t s = 0; s < sections[i].sh_size / sizeof(Elf64_Sym); s++) {
+            if(std::strcmp(names + symbols[s].st_name, name) == 0) return symbols[s].st_size;
+        }
+    }
+
+    return 0;
+}
+
+/* Whether the format string starting with "[<tag>" is in the benchmark. The bracket is looked for separately,
+   so that \p tag itself does not match. */
+static bool containsFormat(const std::vector<u8>& elf, const char* tag) {
+    const size_t length = std::strlen(tag);
+    for(size_t i = 0; i + 1 + length <= elf.size(); i++) {
+        if(elf[i] == '[' && std::memcmp(elf.data() + i + 1, tag, length) == 0) return true;
+    }
+    return false;
+}
+
+static std::vector<u8> readSelf() {
+    std::vector<u8> elf;
+    FILE* file = std::fopen("/proc/self/exe", "rb");
+    if(file == nullptr) return elf;
+
+    u8 buffer[65536];
+    for(size_t read; (read = std::fread(buffer, 1, sizeof(buffer), file)) > 0;) elf.insert(elf.end(), buffer, buffer + read);
+    std::fclose(file);
+
+    return elf;
+}
+
+static void measure(const std::vector<u8>& elf, const char* name, const char* function, const char* tag, void (*site)(u32, u64)) {
+    u64 cycles = 0;
+    for(u32 call = 0; call < Calls; call += Block) {
+        const u64 start = __rdtsc();
+        for(u32 i = 0; i < Block; i++) site(call + i, 0x1111222233334444UL);
+        cycles += __rdtsc() - start;
+
+        logger::flush();
+    }
+
+    std::printf("  %-26s %6zu bytes  %-3s %10.0f cycles\n", name, functionSize(elf, function),
+        containsFormat(elf, tag) ? "yes" : "no", double(cycles) / Calls);
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+    sdcard.deleteFile(ReferenceFilename);
+
+    logger::clearLog();
+    logger::startFlusher();
+
+    const auto& elf = readSelf();
+
+    std::printf("Log call sites, LOG_MIN_LEVEL=%d, info kept at runtime\n", LOG_MIN_LEVEL);
+    std::printf("  %-26s %12s  %-3s %17s\n", "", "code", "fmt", "per call");
+    measure(elf, "trace, compiled out", "siteTrace", "Monitor] Trace site", siteTrace);
+    measure(elf, "debug, filtered at runtime", "siteDebug", "Monitor] Debug site", siteDebug);
+    measure(elf, "info, text", "siteText", "Monitor] Text site", siteText);
+    measure(elf, "info, binary record", "siteBinary", "Monitor] Binary site", siteBinary);
+    measure(elf, "reference logger", "siteReference", "Monitor] Reference site", siteReference);
+
+    logger::stopFlusher();
+    sdcard.deleteFile(ReferenceFilename);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <string>
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* Write amplification and space taken on the SD card by a long session of logging: the single file the logger
+   appended to before the rotation, against the preallocated files rotated at LOG_MAX_SIZE_KB. The amplification
+   is the ratio of the bytes written to the SD card to the bytes of the lines, the growing writes are those which
+   extend a file and cost an allocation on the card. The space counts the preallocated part of the current file.
+   log_rotation_lz4_bench is the same benchmark with the rotated files compressed (LOG_COMPRESS_ROTATED). */
+
+using namespace alefbet::authenticator;
+
+constexpr const char* LogFilename = "/atmosphere/logs/authenticator_svc.log";
+constexpr const char* ReferenceFilename = "/atmosphere/logs/authenticator_reference.log";
+constexpr u32 Lines = 60'000;
+constexpr u32 Generations = LOG_GENERATIONS;
+
+static u64 g_lineBytes = 0;
+
+static void formatLine(char* text, size_t size, u32 index) {
+    snprintf(text, size, "[Monitor] uid=%lu:%lu, Nickname=%s, tick %u\n", 0x0123456789ABCDEFUL, 0x1122334455667788UL, "Player", index);
+}
+
+/* The logger before the rotation: every line appended to the end of the file */
+static void referenceLog(u32 index) {
+    static s64 offset = 0;
+    char text[128];
+    formatLine(text, sizeof(text), index);
+
+    FsFileSystem* sdmc = services::SdCard::get().fs();
+    FsFile file;
+    if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) {
+        if(R_FAILED(fsFsCreateFile(sdmc, ReferenceFilename, 0, 0))) return;
+        if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) return;
+    }
+
+    const size_t size = std::strlen(text);
+    if(R_SUCCEEDED(fsFileWrite(&file, offset, text, size, FsWriteOption_Flush))) offset += size;
+    fsFileClose(&file);
+}
+
+static void rotatedLog(u32 index) {
+    LOG_INFO(Monitor, "uid=%lu:%lu, Nickname=%s, tick %u\n", 0x0123456789ABCDEFUL, 0x1122334455667788UL, "Player", index);
+
+    // Written by the ring every few lines, so that none is dropped
+    if(index % 32 == 31) logger::flush();
+}
+
+static s64 fileSize(const char* path) {
+    s64 size = 0;
+    return R_SUCCEEDED(services::SdCard::get().getSize(path, &size)) ? size : 0;
+}
+
+static s64 rotatedSpace() {
+    s64 space = fileSize(LogFilename);
+    for(u32 generation = 1; generation <= Generations + 1; generation++) {
+        for(const char* suffix : { "", ".lz4" }) {
+            const std::string& path = std::string(LogFilename) + "." + std::to_string(generation) + suffix;
+            space += fileSize(path.c_str());
+        }
+    }
+    return space;
+}
+
+static void deleteLogs() {
+    auto& sdcard = services::SdCard::get();
+    sdcard.deleteFile(ReferenceFilename);
+    sdcard.deleteFile(LogFilename);
+    for(u32 generation = 1; generation <= Generations + 1; generation++) {
+        for(const char* suffix : { "", ".lz4" }) {
+            sdcard.deleteFile((std::string(LogFilename) + "." + std::to_string(generation) + suffix).c_str());
+        }
+    }
+}
+
+template<typename F, typename S>
+static void measure(const char* name, F&& log, S&& space) {
+    const u64 written = hostSdBytesWritten();
+    const u64 growing = hostSdExtendingWrites();
+
+    for(u32 i = 0; i < Lines; i++) log(i);
+    logger::flush();
+
+    std::printf("  %-10s %9lu bytes written  %5.2fx  %6lu growing writes  %9ld bytes on SD\n", name,
+        hostSdBytesWritten() - written, double(hostSdBytesWritten() - written) / g_lineBytes,
+        hostSdExtendingWrites() - growing, space());
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+    deleteLogs();
+
+    for(u32 i = 0; i < Lines; i++) {
+        char text[128];
+        formatLine(text, sizeof(text), i);
+        g_lineBytes += std::strlen(text);
+    }
+
+#ifdef LOG_COMPRESS_ROTATED
+    const char* compression = ", compressed";
+#else
+    const char* compression = "";
+#endif
+    std::printf("Log of %u lines (%lu bytes), %d KB files, %u generations%s\n", Lines, g_lineBytes, LOG_MAX_SIZE_KB, Generations, compression);
+
+    measure("reference", referenceLog, [] { return fileSize(ReferenceFilename); });
+
+    logger::clearLog();
+    logger::startFlusher();
+    measure("rotated", rotatedLog, rotatedSpace);
+    logger::stopFlusher();
+
+    const auto& stats = logger::stats();
+    std::printf("  %lu rotations, %lu dropped", stats.rotations, stats.dropped);
+    if(stats.compressedIn > 0) std::printf(", compressed to %.1f%%", 100.0 * stats.compressedOut / stats.compressedIn);
+    std::printf("\n");
+
+    deleteLogs();
+
+    return 0;
+}
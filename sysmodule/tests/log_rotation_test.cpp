@@ -0,0 +1,158 @@
+#include <string>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* The log file is preallocated to LOG_MAX_SIZE_KB (8 for this test) and rotated once full, the two newest
+   generations are kept and compressed to LZ4 frames. Read back in order, the generations and the current file
+   hold every line logged, the file of the previous boot becoming generation 1. */
+
+using namespace alefbet::authenticator;
+
+static_assert(LOG_MAX_SIZE_KB == 8 && LOG_GENERATIONS == 2, "the test is built with -DLOG_MAX_SIZE_KB=8 -DLOG_GENERATIONS=2");
+
+constexpr const char* LogFilename = "/atmosphere/logs/authenticator_svc.log";
+constexpr const char* Generations[] = {
+    "/atmosphere/logs/authenticator_svc.log.1.lz4",
+    "/atmosphere/logs/authenticator_svc.log.2.lz4",
+    "/atmosphere/logs/authenticator_svc.log.3.lz4"
+};
+constexpr s64 MaxSize = 8 * 1024;
+constexpr u32 Lines = 2000;
+
+static std::vector<u8> readFile(const char* path) {
+    std::vector<u8> data;
+    services::SdCard::get().readFile(path, data);
+    return data;
+}
+
+/* Content of an LZ4 frame as written by compressFile(), false if it is not one */
+static bool decompress(const std::vector<u8>& frame, std::string& out) {
+    u32 magic;
+    if(frame.size() < 7 || (std::memcpy(&magic, frame.data(), sizeof(magic)), magic) != 0x184D2204) return false;
+
+    for(size_t offset = 7; offset + sizeof(u32) <= frame.size();) {
+        u32 header;
+        std::memcpy(&header, frame.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        if(header == 0) return offset == frame.size();
+
+        const size_t size = header & 0x7FFFFFFF;
+        if(offset + size > frame.size()) return false;
+        const u8* block = frame.data() + offset;
+        offset += size;
+
+        if(header & 0x80000000) {
+            out.append(reinterpret_cast<const char*>(block), size);
+            continue;
+        }
+
+        for(size_t p = 0; p < size;) {
+            const u8 token = block[p++];
+            size_t literals = token >> 4;
+            if(literals == 15) for(u8 more = 255; more == 255 && p < size; literals += (more = block[p++])) {}
+            if(p + literals > size) return false;
+            out.append(reinterpret_cast<const char*>(block + p), literals);
+            p += literals;
+            if(p == size) break;
+
+            if(p + 2 > size) return false;
+            const size_t distance = block[p] | block[p + 1] << 8;
+            p += 2;
+            size_t length = (token & 15) + 4;
+            if((token & 15) == 15) for(u8 more = 255; more == 255 && p < size; length += (more = block[p++])) {}
+            if(distance == 0 || distance > out.size()) return false;
+
+            for(size_t i = 0; i < length; i++) out.push_back(out[out.size() - distance]);
+        }
+    }
+
+    return false;
+}
+
+/* The data of the current log, without its preallocated space */
+static std::string currentLog() {
+    const auto& data = readFile(LogFilename);
+    std::string text(data.begin(), data.end());
+    return text.substr(0, text.find('\0'));
+}
+
+static std::string line(u32 index) {
+    char text[32];
+    snprintf(text, sizeof(text), "[Main] line %05u\n", index);
+    return text;
+}
+
+/* Whether \p text is made of the lines up to \p end, starting anywhere */
+static bool linesUpTo(const std::string& text, u32 end) {
+    if(text.empty() || text.size() % line(0).size() != 0) return false;
+
+    const u32 count = text.size() / line(0).size();
+    if(count > end) return false;
+
+    std::string expected;
+    for(u32 i = end - count; i < end; i++) expected += line(i);
+    return text == expected;
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+    sdcard.deleteFile(LogFilename);
+    for(const char* path : Generations) sdcard.deleteFile(path);
+
+    // Without the flusher each line is written right away
+    logger::clearLog();
+    for(u32 i = 0; i < Lines; i++) {
+        LOG_INFO(Main, "line %05u\n", i);
+
+        // The file being written never grows past its preallocated size
+        s64 size = 0;
+        sdcard.getSize(LogFilename, &size);
+        if(size != MaxSize) {
+            CHECK(size == MaxSize);
+            break;
+        }
+    }
+
+    const auto& stats = logger::stats();
+    CHECK(stats.rotations >= Lines * line(0).size() / MaxSize - 1);
+    CHECK(stats.compressedOut > 0 && stats.compressedOut < stats.compressedIn / 2);
+
+    // Two generations, each a full file, followed by the current one
+    std::string oldest, newest;
+    CHECK(decompress(readFile(Generations[1]), oldest));
+    CHECK(decompress(readFile(Generations[0]), newest));
+    CHECK(!sdcard.exists(Generations[2]));
+    CHECK(oldest.size() <= MaxSize && oldest.size() > MaxSize - line(0).size() - 4096);
+    CHECK(newest.size() <= MaxSize && newest.size() > MaxSize - line(0).size() - 4096);
+    CHECK(linesUpTo(oldest + newest + currentLog(), Lines));
+
+    // Stopping gives back the space that was not used
+    const std::string current = currentLog();
+    CHECK(logger::startFlusher());
+    logger::stopFlusher();
+    s64 size = 0;
+    CHECK(R_SUCCEEDED(sdcard.getSize(LogFilename, &size)));
+    CHECK(size == static_cast<s64>(current.size()));
+
+    // On the next boot, the log of the previous one becomes generation 1
+    logger::clearLog();
+    CHECK(!sdcard.exists(LogFilename));
+    std::string previous;
+    CHECK(decompress(readFile(Generations[0]), previous));
+    CHECK(previous == current);
+
+    std::string shifted;
+    CHECK(decompress(readFile(Generations[1]), shifted));
+    CHECK(shifted == newest);
+
+    sdcard.deleteFile(LogFilename);
+    for(const char* path : Generations) sdcard.deleteFile(path);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "host/host_nx.h"
+#include "logger.h"
+#include "sd_card.h"
+
+/* Latency of a log call and throughput of two threads logging at once, through the ring buffer and through
+   the logger it replaced, which formatted under a mutex and opened, wrote, flushed and closed the file for
+   each line. The lines are logged back to back, then with a pause between them as the monitor and the GUI
+   do. Back to back, the ring drops the lines the flusher has no time to write, more so on a host with few
+   cores. The SD card is a directory of the host, much faster than the real one. */
+
+using namespace alefbet::authenticator;
+
+constexpr const char* ReferenceFilename = "/atmosphere/logs/authenticator_reference.log";
+constexpr u32 Lines = 20'000;
+constexpr u32 Threads = 2;
+
+/* The logger before the ring buffer */
+static std::mutex s_referenceMutex;
+static char g_referenceBuffer[8192];
+static s64 s_referenceOffset = 0;
+
+static void referenceLog(const char* fmt, ...) {
+    std::lock_guard<std::mutex> lock(s_referenceMutex);
+
+    FsFileSystem* sdmc = services::SdCard::get().fs();
+    FsFile file;
+    if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) {
+        if(R_FAILED(fsFsCreateFile(sdmc, ReferenceFilename, 0, 0))) return;
+        if(R_FAILED(fsFsOpenFile(sdmc, ReferenceFilename, FsOpenMode_Write | FsOpenMode_Append, &file))) return;
+    }
+
+    std::va_list vl;
+    va_start(vl, fmt);
+    vsnprintf(g_referenceBuffer, sizeof(g_referenceBuffer), fmt, vl);
+    va_end(vl);
+
+    const size_t size = std::strlen(g_referenceBuffer);
+    if(R_SUCCEEDED(fsFileWrite(&file, s_referenceOffset, g_referenceBuffer, size, FsWriteOption_Flush))) {
+        s_referenceOffset += size;
+    }
+    fsFileClose(&file);
+}
+
+template<typename F>
+static void measure(const char* name, u32 lines, u32 pauseUs, F&& log) {
+    std::vector<std::vector<u32>> latencies(Threads);
+    const u64 dropped = logger::stats().dropped;
+
+    const auto& start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(u32 t = 0; t < Threads; t++) {
+        threads.emplace_back([&, t] {
+            auto& own = latencies[t];
+            own.reserve(lines);
+            for(u32 i = 0; i < lines; i++) {
+                const auto& before = std::chrono::steady_clock::now();
+                log(t, i);
+                own.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before).count());
+                if(pauseUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<u32> all;
+    for(const auto& own : latencies) all.insert(all.end(), own.begin(), own.end());
+    std::sort(all.begin(), all.end());
+    const auto& percentile = [&](u32 p) { return all[(all.size() - 1) * p / 100] / 1000.0; };
+
+    std::printf("  %-10s %9.2f %9.2f %9.1f  %10.0f  %7lu\n", name, percentile(50), percentile(99), percentile(100),
+        Threads * lines / seconds, logger::stats().dropped - dropped);
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+    sdcard.deleteFile(ReferenceFilename);
+
+    logger::clearLog();
+    logger::startFlusher();
+
+    for(u32 pauseUs : { 0u, 100u }) {
+        // Paced threads sleep between their lines, which leaves the flusher room to run
+        const u32 lines = pauseUs > 0 ? Lines / 10 : Lines;
+        std::printf("%u threads, %u lines each, %u us between lines\n", Threads, lines, pauseUs);
+        std::printf("  %-10s %9s %9s %9s  %10s  %7s\n", "", "p50 us", "p99 us", "max us", "lines/s", "dropped");
+
+        measure("reference", lines, pauseUs, [](u32 thread, u32 line) {
+            referenceLog("[Monitor] Thread %u line %u uid %016lx\n", thread, line, 0x1111222233334444UL);
+        });
+        measure("ring", lines, pauseUs, [](u32 thread, u32 line) {
+            logger::logToFile("[Monitor] Thread %u line %u uid %016lx\n", thread, line, 0x1111222233334444UL);
+        });
+        logger::flush();
+    }
+
+    logger::stopFlusher();
+    sdcard.deleteFile(ReferenceFilename);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <vector>
+#include "test.h"
+#include "scripted_console.h"
+#include "monitor.h"
+
+/* The monitor detects the launches through its event source, falls back to polling while the source is
+   unavailable, and only tries to get the source back a few times, further and further apart. */
+
+constexpr u64 Second = 1'000'000'000;
+constexpr u64 Minute = 60 * Second;
+constexpr AccountUid User = { { 0x1111, 0x2222 } };
+
+static ScriptedConsole* g_console = nullptr;
+static std::vector<u64> g_latencies;
+
+void GuiController::showAuthenticationPanel(const UserData&) {
+    g_latencies.push_back(g_console->now() - g_console->launchTime());
+}
+
+void GuiController::hideAll() {}
+
+/* An hour of play: a game launched every ten minutes, closed after five. Returns the opens of the source. */
+static u32 play(u32 failedOpens) {
+    ScriptedConsole console;
+    ScriptedLaunchSource source(console, failedOpens);
+    GuiController gui;
+    Monitor monitor(&gui, &source, &console);
+
+    for(u64 game = 0; game < 6; game++) {
+        console.launch(game * 10 * Minute + Minute, 100 + game, 0x0100000000010000 + game);
+        console.close(game * 10 * Minute + 6 * Minute);
+    }
+    console.stopAt(60 * Minute, [&] { monitor.shutdown(); });
+
+    g_console = &console;
+    g_latencies.clear();
+
+    monitor.start();
+    monitor.loop();
+
+    return source.opens();
+}
+
+int main() {
+    hostAddUser(User, "Player");
+    hostSetLastOpenedUser(User);
+
+    // The hook is there from the start: every launch is seen as it happens
+    CHECK(play(0) == 1);
+    CHECK(g_latencies.size() == 6);
+    for(u64 latency : g_latencies) CHECK(latency == 0);
+
+    // The hook is held by another process for a few seconds: the monitor polls and then gets it back
+    CHECK(play(3) == 4);
+    CHECK(g_latencies.size() == 6);
+    for(u64 latency : g_latencies) CHECK(latency == 0);
+
+    // The hook is never released: a few attempts, then polling only, within its maximum delay
+    CHECK(play(UINT32_MAX) == 9);
+    CHECK(g_latencies.size() == 6);
+    for(u64 latency : g_latencies) CHECK(latency <= MONITOR_MAX_POLL_MS * 1'000'000ULL);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "host/host_nx.h"
+#include "password_json.h"
+
+/* Parse time and heap use of the password database parser, for 8 to 10000 users. The heap is counted by the
+   allocation functions below, they are those of the index growing; the input buffer is not counted, the
+   parser reads it in place. The DOM of
+   nlohmann::json it replaced is no longer in the tree. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::helpers;
+
+constexpr u32 Repeats = 20;
+
+static size_t g_allocations = 0;
+static size_t g_heap = 0;
+static size_t g_peak = 0;
+
+/* Each block is preceded by its size */
+void* operator new(size_t size) {
+    auto* block = static_cast<size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+    if(block == nullptr) std::abort();
+
+    *block = size;
+    g_allocations++;
+    g_heap += size;
+    if(g_heap > g_peak) g_peak = g_heap;
+
+    return reinterpret_cast<u8*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* pointer) noexcept {
+    if(pointer == nullptr) return;
+
+    auto* block = reinterpret_cast<size_t*>(static_cast<u8*>(pointer) - sizeof(std::max_align_t));
+    g_heap -= *block;
+    std::free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+int main() {
+    std::printf("Password database parsing\n");
+    std::printf("  %6s %9s  %10s %9s  %12s %12s\n", "users", "bytes", "us", "ns/entry", "allocations", "peak heap");
+
+    for(u32 users : { 8u, 64u, 1000u, 10000u }) {
+        std::string json = "{\"passwords\":[";
+        for(u32 user = 0; user < users; user++) {
+            if(user > 0) json += ",";
+            json += "{\"uid\":\"" + accountUidToString(AccountUid { { 0x1000 + user, 0x2000 } }) + "\",\"password\":\"16,32,1,2\"}";
+        }
+        json += "]}";
+
+        double us = 0;
+        size_t allocations = 0, peak = 0;
+        for(u32 i = 0; i < Repeats; i++) {
+            const size_t heap = g_heap;
+            g_peak = g_heap;
+            allocations = g_allocations;
+
+            const auto& start = std::chrono::steady_clock::now();
+            {
+                CredentialIndex passwords;
+                if(!parsePasswordsJson(json.c_str(), json.size(), passwords).ok) return 1;
+            }
+            us += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+
+            allocations = g_allocations - allocations;
+            peak = g_peak - heap;
+        }
+        us /= Repeats;
+
+        std::printf("  %6u %9zu  %10.1f %9.1f  %12zu %12zu\n", users, json.size(), us, us * 1000 / users, allocations, peak);
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <string>
+#include "test.h"
+#include "host/host_nx.h"
+#include "database.h"
+#include "password_json.h"
+#include "sd_card.h"
+
+/* The JSON parser reads the schema of the database and reports malformed input instead of aborting. A file
+   which cannot be parsed entirely is not imported, not even in part, and stays in place. */
+
+using namespace alefbet::authenticator::database;
+using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::services;
+
+constexpr const char* DbPath = "/config/authenticator/passwords.json";
+constexpr const char* ImportedPath = "/config/authenticator/passwords.json.imported";
+
+constexpr AccountUid Alice = { { 0x1111, 0x2222 } };
+constexpr AccountUid Bob = { { 0x3333, 0x4444 } };
+
+static JsonParseResult parse(const std::string& json, CredentialIndex& passwords) {
+    passwords.clear();
+    return parsePasswordsJson(json.c_str(), json.size(), passwords);
+}
+
+static std::string entry(AccountUid uid, const std::string& password) {
+    return "{\"uid\":\"" + accountUidToString(uid) + "\",\"password\":\"" + password + "\"}";
+}
+
+static void writeFile(const char* path, const std::string& data) {
+    auto& sdcard = SdCard::get();
+    sdcard.deleteFile(path);
+    sdcard.createFile(path, data.size());
+    sdcard.write(path, 0, data.data(), data.size(), FsWriteOption_Flush);
+    sdcard.close(path);
+}
+
+int main() {
+    CredentialIndex passwords;
+
+    // The schema, with spaces, unknown keys and values of any type skipped
+    const auto& valid = "{ \"version\": [1, {\"a\": null}], \"passwords\": [\n  " + entry(Alice, "16,32,1,2")
+        + ",\n  {\"comment\": \"x\\\"y\", \"uid\": \"" + accountUidToString(Bob) + "\", \"password\": \"8,8\", \"n\": -1.5e3, \"b\": true}\n] }\n";
+    auto result = parse(valid, passwords);
+    CHECK(result.ok);
+    CHECK(result.entries == 2);
+    CHECK(passwords.size() == 2);
+    CHECK(passwords.find(Alice)->password() == "16,32,1,2");
+    CHECK(passwords.find(Bob)->password() == "8,8");
+
+    // A hash keeps its form through the serialization
+    CredentialHash hash;
+    hash.salt[0] = 0x5A;
+    hash.key[31] = 0xA5;
+    hash.iterations = 12345;
+    passwords.insert(Alice, Credential::fromHash(hash));
+    CredentialIndex reparsed;
+    result = parse(serializePasswordsJson(passwords), reparsed);
+    CHECK(result.ok);
+    CHECK(reparsed.size() == 2);
+    CHECK(reparsed.find(Alice)->kind == Credential::Hashed);
+    CHECK(std::memcmp(reparsed.find(Alice)->data, passwords.find(Alice)->data, sizeof(hash)) == 0);
+    CHECK(reparsed.find(Bob)->password() == "8,8");
+
+    CHECK(parse("{\"passwords\":[]}", passwords).ok);
+    CHECK(passwords.size() == 0);
+
+    // Malformed input is reported with its position
+    const std::string first = entry(Alice, "1,2");
+    const std::pair<std::string, const char*> invalid[] = {
+        { "", "unexpected character" },
+        { "[]", "unexpected character" },
+        { "{}", "missing \"passwords\"" },
+        { "{\"passwords\":[" + first, "unexpected character" },
+        { "{\"passwords\":[" + first + "]", "unexpected character" },
+        { "{\"passwords\":[" + first + "]} x", "trailing characters" },
+        { "{\"passwords\":[{\"uid\":\"1:2\"}]}", "incomplete entry" },
+        { "{\"passwords\":[{\"uid\":\"0:0\",\"password\":\"1\"}]}", "invalid uid" },
+        { "{\"passwords\":[{\"uid\":\"abc\",\"password\":\"1\"}]}", "invalid uid" },
+        { "{\"passwords\":[{\"uid\":\"1:2\",\"password\":\"\"}]}", "invalid password" },
+        { "{\"passwords\":[{\"uid\":\"1:2\",\"password\":\"" + std::string(57, '1') + "\"}]}", "invalid password" },
+    };
+    for(const auto& [json, error] : invalid) {
+        result = parse(json, passwords);
+        CHECK(!result.ok);
+        CHECK(result.error != nullptr && std::string(result.error) == error);
+        CHECK(result.offset <= json.size());
+    }
+
+    // The error stops the parsing: the entries before it are in the index, the caller must not use them
+    const auto& truncated = "{\"passwords\":[" + entry(Alice, "1,2") + "," + entry(Bob, "3,4");
+    result = parse(truncated, passwords);
+    CHECK(!result.ok);
+    CHECK(result.entries == 2);
+
+    // Deep nesting in skipped values is an error, not a crash
+    result = parse("{\"x\":" + std::string(100000, '[') + ",\"passwords\":[]}", passwords);
+    CHECK(!result.ok);
+
+    // loadPasswords() returns nothing of a file it cannot parse entirely
+    CHECK(createDataDirectory());
+    writeFile("/config/authenticator/load.json", truncated);
+    passwords.insert(Alice, Credential::fromPassword("5,6"));
+    CHECK(!loadPasswords("/config/authenticator/load.json", passwords));
+    CHECK(passwords.size() == 1);
+    CHECK(passwords.find(Alice)->password() == "5,6");
+    CHECK(!loadPasswords("/config/authenticator/missing.json", passwords));
+    writeFile("/config/authenticator/load.json", valid);
+    CHECK(loadPasswords("/config/authenticator/load.json", passwords));
+    CHECK(passwords.size() == 2);
+
+    // The import: a truncated file stays in place and nothing of it is stored
+    auto& store = CredentialStore::get();
+    SdCard::get().deleteFile("/config/authenticator/passwords.log");
+    writeFile(DbPath, truncated);
+    CHECK(store.load());
+    CHECK(store.size() == 0);
+    CHECK(store.find(Alice).empty());
+    CHECK(SdCard::get().exists(DbPath));
+    CHECK(!SdCard::get().exists(ImportedPath));
+
+    // Once fixed it is imported on the next start
+    writeFile(DbPath, valid);
+    CHECK(store.load());
+    CHECK(store.size() == 2);
+    CHECK(store.find(Alice).password() == "16,32,1,2");
+    CHECK(!SdCard::get().exists(DbPath));
+    CHECK(SdCard::get().exists(ImportedPath));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+#include "test.h"
+#include "host/host_nx.h"
+#include "platform_snapshot.h"
+#include "profile_table.h"
+
+/* Each snapshot counts the requests it sends, and only sends the ones whose answer may have changed: the program
+   ID of a new process, the profile of a user who is not in the profile table. */
+
+using namespace alefbet::authenticator::srv;
+using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::structs;
+
+constexpr AccountUid UserA = { { 0x1111, 0x2222 } };
+constexpr AccountUid UserB = { { 0x3333, 0x4444 } };
+constexpr AccountUid UserC = { { 0x5555, 0x6666 } };
+
+static bool sameUser(const UserData& user, AccountUid uid) {
+    return user.uid.uid[0] == uid.uid[0] && user.uid.uid[1] == uid.uid[1];
+}
+
+int main() {
+    hostAddUser(UserA, "Alice");
+    hostAddUser(UserB, "Bob");
+    hostSetLastOpenedUser(UserA);
+    CHECK(ProfileTable::get().load());
+
+    PlatformQuery query;
+    CHECK(query.open());
+    const u64 ipcCalls = hostIpcCalls();
+    u64 snapshotCalls = 0;
+    const auto& take = [&](u64 pid = 0) {
+        const auto& snapshot = query.take(pid);
+        snapshotCalls += snapshot.ipcCalls;
+        return snapshot;
+    };
+
+    // Nothing running: the pid and the user, whose nickname comes from the table
+    auto snapshot = take();
+    CHECK(snapshot.pid == 0);
+    CHECK(snapshot.ipcCalls == 2);
+    CHECK(snapshot.userChanged);
+    CHECK(sameUser(snapshot.user, UserA) && snapshot.user.nickname == "Alice");
+
+    // A game is launched: its program ID is fetched once
+    hostSetApplication(100, 0x0100000000010000);
+    snapshot = take();
+    CHECK(snapshot.pid == 100 && snapshot.programId == 0x0100000000010000);
+    CHECK(snapshot.ipcCalls == 3);
+    CHECK(!snapshot.userChanged);
+
+    snapshot = take();
+    CHECK(snapshot.programId == 0x0100000000010000);
+    CHECK(snapshot.ipcCalls == 2);
+
+    // The pid is known when the launch has been hooked
+    snapshot = take(100);
+    CHECK(snapshot.ipcCalls == 1);
+
+    // Another user
+    hostSetLastOpenedUser(UserB);
+    snapshot = take();
+    CHECK(snapshot.userChanged);
+    CHECK(sameUser(snapshot.user, UserB) && snapshot.user.nickname == "Bob");
+    CHECK(snapshot.ipcCalls == 2);
+
+    // A user created after boot: the profile is fetched once, then known
+    hostAddUser(UserC, "Carol");
+    hostSetLastOpenedUser(UserC);
+    snapshot = take();
+    CHECK(snapshot.userChanged && snapshot.user.nickname == "Carol");
+    CHECK(snapshot.ipcCalls == 2 + 3);
+
+    snapshot = take();
+    CHECK(!snapshot.userChanged && snapshot.user.nickname == "Carol");
+    CHECK(snapshot.ipcCalls == 2);
+
+    // The game is closed
+    hostSetApplication(0, 0);
+    snapshot = take();
+    CHECK(snapshot.pid == 0 && snapshot.programId == 0);
+
+    // The counts are the requests actually sent
+    CHECK(query.snapshots() == 8);
+    CHECK(query.totalIpcCalls() == snapshotCalls);
+    CHECK(hostIpcCalls() - ipcCalls == snapshotCalls);
+
+    query.close();
+
+    return TEST_RESULT();
+}
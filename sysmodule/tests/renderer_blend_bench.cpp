@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "host/host_nx.h"
+#include "gui/renderer.hpp"
+
+/* Blending of a translucent color over the pixels of the panel: the floating point blending as before, the
+   integer kernel per pixel and over runs. The figures are for the host, without the NEON path of blendRun. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+constexpr u32 Repeats = 50;
+
+constexpr Color Background(0x2, 0x4, 0x6, 0xE);
+
+static volatile u16 g_sink;
+
+template<typename F>
+static void measure(const char* name, u64 pixels, F&& func) {
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Repeats; i++) {
+        func();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("  %-32s %8.1f Mpixels/s\n", name, Repeats * pixels / seconds / 1e6);
+}
+
+/* The blending before the integer kernels */
+static u8 floatChannel(u8 src, u8 dst, u8 alpha) {
+    const u8 oneMinusAlpha = 0x0F - alpha;
+    return (dst * alpha + src * oneMinusAlpha) / float(0xF);
+}
+
+static u16 floatPixel(u16 pixel, u16 color) {
+    u16 end = std::min((pixel >> 12) + (color >> 12), 0xF) << 12;
+
+    for(u32 shift = 0; shift < 12; shift += 4) {
+        end |= floatChannel((pixel >> shift) & 0xF, (color >> shift) & 0xF, color >> 12) << shift;
+    }
+
+    return end;
+}
+
+int main() {
+    std::printf("Blending\n");
+    std::vector<u16> pixels(Width * Height);
+    std::srand(1);
+    for(auto& pixel : pixels) pixel = std::rand();
+
+    measure("floating point, per pixel", pixels.size(), [&] {
+        for(auto& pixel : pixels) pixel = floatPixel(pixel, Background.rgba);
+    });
+    measure("integer, per pixel", pixels.size(), [&] {
+        for(auto& pixel : pixels) pixel = blendPixel(pixel, Background.rgba);
+    });
+    measure("integer, runs", pixels.size(), [&] {
+        blendRun(pixels.data(), pixels.size(), Background.rgba);
+    });
+    g_sink = pixels[0];
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "gui/renderer.hpp"
+
+/* Frames of the panel background: the clear followed by the translucent background blended pixel by pixel as
+   before, blended in runs of framebuffer order, fused with the clear, and an opaque fill for comparison. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+constexpr u32 Repeats = 50;
+
+constexpr Color Background(0x2, 0x4, 0x6, 0xE);
+
+template<typename F>
+static void measureFrame(const char* name, F&& func) {
+    auto& renderer = Renderer::get();
+
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Repeats; i++) {
+        renderer.invalidateAll();
+        renderer.startFrame();
+        func(renderer);
+        renderer.endFrame();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("  %-32s %8.1f Mpixels/s\n", name, Repeats * Width * Height / seconds / 1e6);
+}
+
+int main() {
+    auto& renderer = Renderer::get();
+    renderer.init(Width, Height, 0, 0);
+
+    std::printf("Panel background\n");
+    measureFrame("clear, blended pixel by pixel", [](Renderer& renderer) {
+        renderer.clearScreen();
+        for(s32 x = 0; x < static_cast<s32>(Width); x++) {
+            for(s32 y = 0; y < static_cast<s32>(Height); y++) renderer.setPixelBlendDst(x, y, Background);
+        }
+    });
+    measureFrame("clear, blended in runs", [](Renderer& renderer) {
+        renderer.clearScreen();
+        renderer.drawRect(0, 0, Width, Height, Background);
+    });
+    measureFrame("fused clear", [](Renderer& renderer) {
+        renderer.clearScreen(Background);
+    });
+    measureFrame("opaque fill", [](Renderer& renderer) {
+        renderer.fillRect(0, 0, Width, Height, Color(0xF, 0x0, 0x0, 0xF));
+    });
+
+    renderer.exit();
+
+    return 0;
+}
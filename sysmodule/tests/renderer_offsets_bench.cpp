@@ -0,0 +1,58 @@
+#include <chrono>
+#include "host/host_nx.h"
+#include "gui/renderer.hpp"
+
+/* Block-linear offsets of the pixels of the panel: computed for each pixel as before, and looked up in the
+   per-row and per-column tables of the renderer. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+constexpr u32 Repeats = 50;
+
+static volatile u32 g_sink;
+
+template<typename F>
+static void measure(const char* name, F&& func) {
+    const auto& start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < Repeats; i++) {
+        func();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("  %-32s %8.1f Mpixels/s\n", name, Repeats * Width * Height / seconds / 1e6);
+}
+
+/* Offset of a pixel as computed before the tables */
+static u32 computedOffset(u32 x, u32 y) {
+    u32 offset = ((y & 127) / 16) + (x / 32 * 8) + ((y / 16 / 8) * (((Width / 2) / 16 * 8)));
+    offset *= 16 * 16 * 4;
+    offset += ((y % 16) / 8) * 512 + ((x % 32) / 16) * 256 + ((y % 8) / 2) * 64 + ((x % 16) / 8) * 32 + (y % 2) * 16 + (x % 8) * 2;
+    return offset / 2;
+}
+
+int main() {
+    auto& renderer = Renderer::get();
+    renderer.init(Width, Height, 0, 0);
+
+    std::printf("Pixel offsets\n");
+    measure("computed", [] {
+        u32 sum = 0;
+        for(u32 y = 0; y < Height; y++) {
+            for(u32 x = 0; x < Width; x++) sum += computedOffset(x, y);
+        }
+        g_sink = sum;
+    });
+    measure("tables", [&] {
+        u32 sum = 0;
+        for(u32 y = 0; y < Height; y++) {
+            for(u32 x = 0; x < Width; x++) sum += renderer.getPixelOffset(x, y);
+        }
+        g_sink = sum;
+    });
+
+    renderer.exit();
+
+    return 0;
+}
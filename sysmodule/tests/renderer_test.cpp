@@ -0,0 +1,180 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "gui/renderer.hpp"
+
+/* The renderer draws the same pixels as before its optimizations: the offset tables match the block-linear
+   formula, the span fills match the pixel by pixel drawing, and the frames drawn within the damaged regions
+   match the frames drawn entirely. */
+
+using namespace alefbet::authenticator::gfx;
+
+constexpr u32 Width = 1216;
+constexpr u32 Height = 768;
+
+constexpr Color Background(0x2, 0x4, 0x6, 0xE);
+constexpr s32 CirclesX[] = { 416, 550, 680, 818 };
+
+static std::vector<u8> presentedFrame() {
+    size_t size;
+    const u8* frame = static_cast<const u8*>(hostPresentedFramebuffer(&size));
+    return std::vector<u8>(frame, frame + size);
+}
+
+static u32 presentedFrameCrc() {
+    size_t size;
+    const void* frame = hostPresentedFramebuffer(&size);
+    return crc32Calculate(frame, size);
+}
+
+/* Offset of a pixel as computed before the tables */
+static u32 referenceOffset(u32 x, u32 y, u32 width) {
+    u32 offset = ((y & 127) / 16) + (x / 32 * 8) + ((y / 16 / 8) * (((width / 2) / 16 * 8)));
+    offset *= 16 * 16 * 4;
+    offset += ((y % 16) / 8) * 512 + ((x % 32) / 16) * 256 + ((y % 8) / 2) * 64 + ((x % 16) / 8) * 32 + (y % 2) * 16 + (x % 8) * 2;
+    return offset / 2;
+}
+
+/* Frame filled with pixels drawn one by one, the same for a given seed */
+static void drawNoise(Renderer& renderer, u32 seed) {
+    for(s32 y = 0; y < static_cast<s32>(Height); y++) {
+        for(s32 x = 0; x < static_cast<s32>(Width); x++) {
+            seed = seed * 1664525 + 1013904223;
+            renderer.setPixel(x, y, Color(seed >> 16));
+        }
+    }
+}
+
+/* The authentication panel, as a function of its stage and of the number of keys pressed */
+static void drawPanel(Renderer& renderer, u32 stage, u32 keys) {
+    renderer.clearScreen(Background);
+    renderer.drawRect(384, 70, 450, 60, Color(0x1, 0xC, 0xE, 0xF));
+
+    // The message, translucent and centered, its width depends on the stage
+    const s32 width = 200 + stage * 90;
+    renderer.drawRect((Width - width) / 2, 300, width, 60, Color(0xF, stage, 0x3, 0x9));
+
+    for(u32 i = 0; i < std::size(CirclesX); i++) {
+        renderer.drawCircle(CirclesX[i], 496, 24, keys > i, Color(0xF, 0xF, 0xF, 0xF));
+    }
+}
+
+int main() {
+    auto& renderer = Renderer::get();
+
+    // Offset tables, for the panel and a few other surfaces
+    for(u32 width : { 1216u, 1280u, 448u, 1920u }) {
+        for(u32 height : { 768u, 720u, 1080u }) {
+            renderer.init(width, height, 0, 0);
+
+            u32 mismatches = 0;
+            for(u32 y = 0; y < height; y++) {
+                for(u32 x = 0; x < width; x++) {
+                    if(renderer.getPixelOffset(x, y) != referenceOffset(x, y, width)) mismatches++;
+                }
+            }
+            CHECK(mismatches == 0);
+        }
+    }
+
+    // The framebuffers are allocated by the first init(), with the size of the panel
+    renderer.exit();
+    renderer.init(Width, Height, 0, 0);
+
+    // Rectangles, drawn in spans and pixel by pixel over the same frame
+    std::srand(1);
+    for(u32 i = 0; i < 300; i++) {
+        const s32 x = std::rand() % 1400 - 100, y = std::rand() % 900 - 100;
+        const s32 w = std::rand() % 300, h = std::rand() % 300;
+        Color color(std::rand());
+        if(i % 3 == 0) color.a = 0xF;
+
+        renderer.invalidateAll();
+        renderer.startFrame();
+        drawNoise(renderer, i);
+        for(s32 x1 = x; x1 < x + w; x1++) {
+            for(s32 y1 = y; y1 < y + h; y1++) {
+                renderer.setPixelBlendDst(x1, y1, color);
+            }
+        }
+        renderer.endFrame();
+        const auto& expected = presentedFrame();
+
+        renderer.invalidateAll();
+        renderer.startFrame();
+        drawNoise(renderer, i);
+        renderer.drawRect(x, y, w, h, color);
+        renderer.endFrame();
+
+        CHECK(presentedFrame() == expected);
+    }
+
+    // The background fused with the clear
+    renderer.invalidateAll();
+    renderer.startFrame();
+    renderer.clearScreen();
+    renderer.drawRect(0, 0, Width, Height, Background);
+    renderer.endFrame();
+    const auto& expected = presentedFrame();
+
+    renderer.invalidateAll();
+    renderer.startFrame();
+    renderer.clearScreen(Background);
+    renderer.endFrame();
+    CHECK(presentedFrame() == expected);
+
+    // A sequence of panels drawn within the damaged regions, then entirely
+    constexpr u32 Frames = 200;
+    std::vector<u32> stages, keys;
+    std::srand(3);
+    for(u32 frame = 0, stage = 0, key = 0; frame < Frames; frame++) {
+        if(std::rand() % 5 == 0) {
+            stage = std::rand() % 6;
+            key = 0;
+        } else {
+            key = (key + 1) % 5;
+        }
+        stages.push_back(stage);
+        keys.push_back(key);
+    }
+
+    std::vector<u32> partialFrames;
+    u64 partialPixels = 0;
+    renderer.invalidateAll();
+    for(u32 frame = 0; frame < Frames; frame++) {
+        if(frame > 0) {
+            if(stages[frame] != stages[frame - 1]) renderer.invalidate(0, 300, Width, 60);
+            for(u32 i = 0; i < std::size(CirclesX); i++) {
+                if((keys[frame] > i) != (keys[frame - 1] > i)) renderer.invalidate(CirclesX[i] - 24, 472, 49, 49);
+            }
+        }
+
+        renderer.startFrame();
+        drawPanel(renderer, stages[frame], keys[frame]);
+        renderer.endFrame();
+
+        // The first frame of each framebuffer is drawn entirely
+        if(frame >= 2) partialPixels += renderer.stats().lastFramePixels;
+        partialFrames.push_back(presentedFrameCrc());
+    }
+
+    u32 mismatches = 0;
+    for(u32 frame = 0; frame < Frames; frame++) {
+        renderer.invalidateAll();
+        renderer.startFrame();
+        drawPanel(renderer, stages[frame], keys[frame]);
+        renderer.endFrame();
+
+        if(presentedFrameCrc() != partialFrames[frame]) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // Drawing the changes only is the point
+    CHECK(partialPixels / (Frames - 2) < Width * Height / 4);
+
+    renderer.exit();
+
+    return TEST_RESULT();
+}
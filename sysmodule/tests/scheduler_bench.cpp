@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <vector>
+#include "monitor_scheduler.h"
+
+/* Wakeups and detection latency of the polling policies over a virtual day of play: the fixed delay polled
+   before the scheduler, and the bursts with back-off of the scheduler under a few limits. The monitor only
+   polls when the launch hook is unavailable, see launch_bench for the hook. */
+
+using namespace alefbet::authenticator::srv;
+
+constexpr s64 Millisecond = 1'000'000;
+constexpr u64 Minute = 60'000 * Millisecond;
+constexpr u32 Games = 200;
+
+struct Session {
+    u64 launch;
+    u64 close;
+};
+
+static void run(const char* name, const SchedulerLimits& limits, const std::vector<Session>& sessions) {
+    VirtualClock clock;
+    MonitorScheduler scheduler(&clock, limits);
+
+    // The polling loop of the monitor, each check sees the state of the console at the time of the wakeup
+    bool running = false;
+    size_t next = 0;
+    while(next < sessions.size()) {
+        scheduler.sleep();
+
+        const auto& session = sessions[next];
+        if(!running && clock.now() >= session.launch) {
+            running = true;
+            scheduler.recordDetection(clock.now() - session.launch);
+            scheduler.notify(MonitorScheduler::GameLaunched);
+        }
+        if(running && clock.now() >= session.close) {
+            running = false;
+            next++;
+            scheduler.notify(MonitorScheduler::GameClosed);
+        }
+    }
+
+    const auto& stats = scheduler.stats();
+    const double hours = clock.now() / (60.0 * Minute);
+    std::printf("  %-24s %7.0f wakeups/h  latency avg %6.1f ms  max %6.1f ms\n", name, stats.wakeups / hours,
+        stats.averageLatencyNs() / double(Millisecond), stats.maxLatencyNs / double(Millisecond));
+}
+
+int main() {
+    // Games of 1 to 20 minutes, 1 to 10 minutes apart
+    std::vector<Session> sessions;
+    std::srand(1);
+    u64 time = 0;
+    for(u32 game = 0; game < Games; game++) {
+        Session session;
+        session.launch = time + (std::rand() % 540'000 + 60'000) * Millisecond;
+        session.close = session.launch + (std::rand() % 1140 + 60) * 1000 * Millisecond;
+        sessions.push_back(session);
+        time = session.close;
+    }
+
+    std::printf("Polling policies, %u games\n", Games);
+
+    SchedulerLimits fixed;
+    fixed.maxDelayNs = fixed.minDelayNs;
+    run("fixed 100 ms", fixed, sessions);
+
+    run("default", SchedulerLimits{}, sessions);
+
+    SchedulerLimits capped;
+    capped.maxDelayNs = 1000 * Millisecond;
+    run("capped at 1 s", capped, sessions);
+
+    SchedulerLimits slow;
+    slow.maxDelayNs = 10'000 * Millisecond;
+    run("capped at 10 s", slow, sessions);
+
+    return 0;
+}
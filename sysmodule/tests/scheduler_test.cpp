@@ -0,0 +1,61 @@
+#include <algorithm>
+#include "test.h"
+#include "monitor_scheduler.h"
+
+/* The scheduler polls at the minimum delay during a burst following a transition, then doubles the delay up to
+   the maximum, and keeps the statistics of the wakeups and of the detections. Time is virtual. */
+
+using namespace alefbet::authenticator::srv;
+
+constexpr s64 Millisecond = 1'000'000;
+
+int main() {
+    VirtualClock clock;
+    SchedulerLimits limits;
+    limits.minDelayNs = 100 * Millisecond;
+    limits.maxDelayNs = 1600 * Millisecond;
+    limits.burstDurationNs = 1000 * Millisecond;
+    MonitorScheduler scheduler(&clock, limits);
+
+    // Burst: the minimum delay for the burst duration
+    scheduler.notify(MonitorScheduler::GameLaunched);
+    u32 burstWakeups = 0;
+    while(clock.now() < static_cast<u64>(limits.burstDurationNs)) {
+        CHECK(scheduler.currentDelay() == limits.minDelayNs);
+        scheduler.sleep();
+        burstWakeups++;
+    }
+    CHECK(burstWakeups == 10);
+
+    // Back-off: doubled at each wakeup past the burst, up to the maximum
+    s64 expected = limits.minDelayNs;
+    for(u32 i = 0; i < 8; i++) {
+        CHECK(scheduler.currentDelay() == expected);
+        scheduler.sleep();
+        expected = std::min(expected * 2, limits.maxDelayNs);
+    }
+    CHECK(scheduler.currentDelay() == limits.maxDelayNs);
+
+    // A transition goes back to the minimum delay
+    scheduler.notify(MonitorScheduler::UserSwitched);
+    CHECK(scheduler.currentDelay() == limits.minDelayNs);
+    CHECK(scheduler.stats().wakeups == 18);
+
+    // Wakeups are counted per minute of the clock
+    clock.advance(60'000 * Millisecond);
+    for(u32 i = 0; i < 5; i++) scheduler.recordWakeup();
+    clock.advance(60'000 * Millisecond);
+    scheduler.recordWakeup();
+    CHECK(scheduler.stats().wakeupsLastMinute == 5);
+
+    // Detection latencies
+    scheduler.recordDetection(300 * Millisecond);
+    scheduler.recordDetection(100 * Millisecond);
+    scheduler.recordDetection(200 * Millisecond);
+    CHECK(scheduler.stats().detections == 3);
+    CHECK(scheduler.stats().minLatencyNs == 100 * Millisecond);
+    CHECK(scheduler.stats().maxLatencyNs == 300 * Millisecond);
+    CHECK(scheduler.stats().averageLatencyNs() == 200 * Millisecond);
+
+    return TEST_RESULT();
+}
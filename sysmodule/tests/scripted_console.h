@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "host/host_nx.h"
+#include "launch_event_source.h"
+#include "monitor_scheduler.h"
+
+/* Scripted console for the tests and benchmarks of the monitor: applications launched and closed at given times
+   of a virtual clock, and a launch event source reporting the launches, which may also be unavailable. The
+   monitor runs on the thread of the test, each of its sleeps plays the script up to the new time. */
+
+using namespace alefbet::authenticator::srv;
+
+class ScriptedConsole : public VirtualClock {
+    public:
+        struct Step {
+            u64 timeNs = 0;
+            u64 pid = 0;            ///< 0 closes the running application
+            u64 programId = 0;
+        };
+
+        ScriptedConsole() {
+            hostSetApplication(0, 0);
+        }
+
+        void launch(u64 timeNs, u64 pid, u64 programId) {
+            steps_.push_back(Step { timeNs, pid, programId });
+        }
+
+        void close(u64 timeNs) {
+            steps_.push_back(Step { timeNs, 0, 0 });
+        }
+
+        /*! \brief Calls \p stop once the clock reaches \p timeNs. */
+        void stopAt(u64 timeNs, std::function<void()> stop) {
+            stopNs_ = timeNs;
+            stop_ = std::move(stop);
+        }
+
+        void sleep(s64 ns) override {
+            VirtualClock::sleep(ns);
+
+            while(next_ < steps_.size() && steps_[next_].timeNs <= now()) {
+                const auto& step = steps_[next_++];
+                hostSetApplication(step.pid, step.programId);
+                if(step.pid != 0) launchNs_ = step.timeNs;
+            }
+
+            if(!stopped_ && now() >= stopNs_) {
+                stopped_ = true;
+                if(stop_) stop_();
+            }
+        }
+
+        /*! \brief Next step of the script, nullptr once it has been played. */
+        const Step* nextStep() const {
+            return next_ < steps_.size() ? &steps_[next_] : nullptr;
+        }
+
+        u64 stopTime() const {
+            return stopNs_;
+        }
+
+        /*! \brief Time of the last launch played. */
+        u64 launchTime() const {
+            return launchNs_;
+        }
+
+    private:
+        std::vector<Step> steps_;
+        size_t next_ = 0;
+        u64 launchNs_ = 0;
+        u64 stopNs_ = UINT64_MAX;
+        bool stopped_ = false;
+        std::function<void()> stop_;
+};
+
+/* The launch hook of the scripted console, unavailable for the first \p failedOpens calls of open() */
+class ScriptedLaunchSource : public LaunchEventSource {
+    public:
+        ScriptedLaunchSource(ScriptedConsole& console, u32 failedOpens = 0)
+        : console_(console), failedOpens_(failedOpens) {}
+
+        bool open() override {
+            opens_++;
+            open_ = opens_ > failedOpens_;
+            return open_;
+        }
+
+        void close() override {
+            open_ = false;
+        }
+
+        LaunchEvent wait(s64 timeoutNs) override {
+            LaunchEvent event;
+            if(!open_) {
+                event.type = LaunchEvent::Failed;
+                return event;
+            }
+
+            const u64 end = std::min(timeoutNs < 0 ? UINT64_MAX : console_.now() + timeoutNs, console_.stopTime());
+            while(true) {
+                const auto* step = console_.nextStep();
+                if(step == nullptr || step->timeNs > end) {
+                    console_.advance(end > console_.now() ? end - console_.now() : 0);
+                    return event;
+                }
+
+                // Plays the step, even if it was already due
+                const u64 pid = step->pid;
+                console_.advance(step->timeNs > console_.now() ? step->timeNs - console_.now() : 0);
+                if(pid != 0) {
+                    event.type = LaunchEvent::Launched;
+                    event.pid = pid;
+                    event.tick = armGetSystemTick();
+                    return event;
+                }
+            }
+        }
+
+        void interrupt() override {}
+
+        void acknowledge(LaunchEvent&) override {}
+
+        u32 opens() const {
+            return opens_;
+        }
+
+    private:
+        ScriptedConsole& console_;
+        u32 failedOpens_ = 0;
+        u32 opens_ = 0;
+        bool open_ = false;
+};
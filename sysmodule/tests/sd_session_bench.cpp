@@ -0,0 +1,86 @@
+#include <string>
+#include "host/host_nx.h"
+#include "database.h"
+#include "logger.h"
+#include "sd_card.h"
+#include "title_cache.h"
+
+/* File handles opened on the SD card during a session of the console: the sysmodule starts, then games are
+   launched and the authentication panel shown for each, some users changing their PIN. Each file operation
+   opened and closed its handle before the shared session, which keeps SD_CACHED_FILES of them open: the
+   operations are the opens and the requests served by a handle already open. The logger opened its file for
+   each line then, it now writes them in batches. */
+
+using namespace alefbet::authenticator;
+using namespace alefbet::authenticator::database;
+
+constexpr const char* Paths[] = {
+    "/atmosphere/logs/authenticator_svc.log",
+    "/config/authenticator/passwords.log",
+    "/config/authenticator/titles.bin",
+    "/config/authenticator/titles.bin.tmp"
+};
+constexpr u32 Launches = 50;
+constexpr u32 UsersCount = 4;
+constexpr u32 Titles = 10;
+
+static AccountUid userUid(u32 user) {
+    return AccountUid { { 0x1000 + user, 0x2000 } };
+}
+
+static u64 titleId(u32 title) {
+    return 0x0100000000010000 + (u64(title) << 16);
+}
+
+int main() {
+    hostSetSdRoot("sd.nosync");
+    auto& sdcard = services::SdCard::get();
+    sdcard.createDirectory("/atmosphere");
+    sdcard.createDirectory("/atmosphere/logs");
+    for(const char* path : Paths) sdcard.deleteFile(path);
+    for(u32 title = 0; title < Titles; title++) {
+        hostInstallApplication(titleId(title), ("Title " + std::to_string(title)).c_str());
+    }
+
+    // Start of the sysmodule
+    logger::clearLog();
+    logger::startFlusher();
+    LOG_INFO(Main, "Authenticator started\n");
+    auto& store = CredentialStore::get();
+    store.load();
+    auto& titles = helpers::TitleCache::get();
+    for(u32 user = 0; user < UsersCount; user++) {
+        store.update(userUid(user), Credential::fromPassword("ABAB"));
+    }
+
+    // The launches, the panel asking for the PIN of the user, a new PIN every fifth time
+    for(u32 launch = 0; launch < Launches; launch++) {
+        const AccountUid uid = userUid(launch % UsersCount);
+        const u64 title = titleId(launch * 7 % Titles);
+
+        LOG_INFO(Monitor, "Application launched: program %016lX\n", title);
+        LOG_INFO(Gui, "Authentication panel for %s\n", titles.name(title).c_str());
+        const auto& credential = store.find(uid);
+        LOG_INFO(Database, "Credential of kind %u\n", credential.kind);
+        if(launch % 5 == 0) store.update(uid, Credential::fromPassword("BABA"));
+        LOG_INFO(Monitor, "Authentication succeeded\n");
+
+        logger::flush();
+    }
+
+    logger::stopFlusher();
+
+    std::printf("SD card handles for %u launches, %d cached\n", Launches, SD_CACHED_FILES);
+    std::printf("  %-40s %8s %8s %14s\n", "", "opened", "evicted", "operations");
+    u32 opens = 0, operations = 0;
+    for(const char* path : Paths) {
+        const auto& stats = sdcard.stats(path);
+        std::printf("  %-40s %8u %8u %14u\n", path, stats.opens, stats.evictions, stats.opens + stats.hits);
+        opens += stats.opens;
+        operations += stats.opens + stats.hits;
+    }
+    std::printf("  %-40s %8u %8s %14u\n", "total", opens, "", operations);
+    std::printf("  %.2f opens per launch, %.2f before the shared session\n", double(opens) / Launches, double(operations) / Launches);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "service_manager.h"
+
+/* Sessions are reference counted, and a kernel failure reconnects once however many threads see it,
+   without any call running on a closed session. */
+
+using namespace alefbet::authenticator::services;
+
+constexpr ::Result SessionClosed = KERNELRESULT(Cancelled);
+
+class FakeDriver : public ServiceDriver {
+    public:
+        ::Result initialize(ServiceId) override {
+            initializations++;
+            broken = false;
+            served = false;
+            open = true;
+            return 0;
+        }
+
+        void exit(ServiceId) override {
+            // Leaves room for a call to run on the closed session if it is not locked out
+            open = false;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            exits++;
+        }
+
+        ::Result request() {
+            if(!open) {
+                closedCalls++;
+                return SessionClosed;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+
+            // A requested breakage hits a session which already served a request, not the retry after a reconnection
+            if(served && breakRequested.exchange(false)) broken = true;
+            if(broken) return SessionClosed;
+
+            served = true;
+            return 0;
+        }
+
+        std::atomic<bool> open = false;
+        std::atomic<bool> broken = false;
+        std::atomic<bool> served = false;
+        std::atomic<bool> breakRequested = false;
+        std::atomic<u32> initializations = 0;
+        std::atomic<u32> exits = 0;
+        std::atomic<u32> closedCalls = 0;
+};
+
+int main() {
+    FakeDriver driver;
+    auto& manager = ServiceManager::get();
+    manager.setDriver(&driver);
+
+    // Reference counting
+    CHECK(manager.acquire(Account));
+    CHECK(manager.acquire(Account));
+    CHECK(driver.initializations == 1);
+    manager.release(Account);
+    CHECK(driver.exits == 0);
+    manager.release(Account);
+    CHECK(driver.exits == 1);
+
+    // A call on a session that is not held is not retried
+    driver.broken = true;
+    CHECK(R_FAILED(manager.call(Account, [&] { return driver.request(); })));
+    CHECK(manager.stats(Account).reconnects == 0);
+    driver.closedCalls = 0;
+
+    // Concurrent calls seeing the same broken session reconnect once and all succeed
+    CHECK(manager.acquire(Account));
+    const u32 initializations = driver.initializations;
+    driver.broken = true;
+
+    std::atomic<u32> failedCalls = 0;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for(int i = 0; i < 50; i++) {
+                if(R_FAILED(manager.call(Account, [&] { return driver.request(); }))) failedCalls++;
+            }
+        });
+    }
+
+    // Breaks the session a few more times while the calls run
+    for(int i = 0; i < 5; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        driver.breakRequested = true;
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto& stats = manager.stats(Account);
+    CHECK(failedCalls == 0);
+    CHECK(driver.closedCalls == 0);
+    CHECK(stats.reconnects == driver.initializations - initializations);
+    CHECK(stats.reconnects >= 1 && stats.reconnects <= 6);
+    CHECK(stats.refCount == 1);
+
+    manager.release(Account);
+    CHECK(driver.open == false);
+
+    return TEST_RESULT();
+}
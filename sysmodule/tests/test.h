@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdio>
+
+/* Minimal assertions for the host tests: a failed check is reported and the test returns 1 from main() */
+
+inline int g_testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            g_testFailures++; \
+        } \
+    } while(0)
+
+#define TEST_RESULT() (g_testFailures == 0 ? (std::printf("%s: ok\n", __FILE__), 0) : 1)
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "host/host_nx.h"
+#include "title_cache.h"
+
+/* Names of the titles shown by the sysmodule, looked up in ns each time as before the cache, and through the
+   cache. A few titles are played most of the time (Zipf distribution). The times are those of the host, the
+   requests and the bytes transferred are those an actual console would see. */
+
+using namespace alefbet::authenticator::helpers;
+
+constexpr u32 Titles = 60;
+constexpr u32 Lookups = 20'000;
+
+static volatile size_t g_sink;
+
+template<typename F>
+static void measure(const char* name, const std::vector<u64>& lookups, F&& lookup) {
+    const u64 calls = hostIpcCalls(), bytes = hostIpcBytes();
+    const auto& start = std::chrono::steady_clock::now();
+    for(u64 titleId : lookups) g_sink = lookup(titleId).size();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("  %-12s %6.2f requests  %9.0f bytes  %7.2f us per lookup\n", name,
+        (hostIpcCalls() - calls) / double(lookups.size()), (hostIpcBytes() - bytes) / double(lookups.size()),
+        seconds * 1e6 / lookups.size());
+}
+
+int main() {
+    for(u32 i = 0; i < Titles; i++) {
+        const std::string name = "Title " + std::to_string(i);
+        hostInstallApplication(0x0100000000010000 + (u64(i) << 16), name.c_str());
+    }
+
+    std::vector<double> weights;
+    for(u32 i = 0; i < Titles; i++) weights.push_back(1.0 / (i + 1));
+    std::mt19937 random(1);
+    std::discrete_distribution<u32> zipf(weights.begin(), weights.end());
+    std::vector<u64> lookups;
+    for(u32 i = 0; i < Lookups; i++) lookups.push_back(0x0100000000010000 + (u64(zipf(random)) << 16));
+
+    std::printf("Title names, %u lookups of %u titles\n", Lookups, Titles);
+
+    measure("ns", lookups, [](u64 titleId) {
+        nsInitialize();
+        auto control = std::make_unique<NsApplicationControlData>();
+        u64 size = 0;
+        std::string name = "Unknown";
+        NacpLanguageEntry* entry = nullptr;
+        if(R_SUCCEEDED(nsGetApplicationControlData(NsApplicationControlSource_Storage, titleId, control.get(), sizeof(*control), &size))
+            && R_SUCCEEDED(nacpGetLanguageEntry(&control->nacp, &entry))) {
+            name = entry->name;
+        }
+        nsExit();
+        return name;
+    });
+
+    measure("cache", lookups, [](u64 titleId) {
+        return TitleCache::get().name(titleId);
+    });
+
+    const auto& stats = TitleCache::get().stats();
+    std::printf("  cache hit rate %.2f %% (%lu hits, %lu misses)\n", 100.0 * stats.hits / (stats.hits + stats.misses), stats.hits, stats.misses);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <vector>
+#include "test.h"
+#include "host/host_nx.h"
+#include "sd_card.h"
+#include "title_cache.h"
+
+/* The names come from ns once per title, only the NACP is transferred, and the cache is saved to the SD card. */
+
+using namespace alefbet::authenticator::helpers;
+using namespace alefbet::authenticator::services;
+
+constexpr u64 Zelda = 0x01007EF00011E000;
+constexpr u64 Mario = 0x0100000000010000;
+constexpr u64 Missing = 0x0100000000DEAD00;
+
+int main() {
+    hostInstallApplication(Zelda, "The Legend of Zelda");
+    hostInstallApplication(Mario, "Super Mario Odyssey");
+
+    auto& cache = TitleCache::get();
+
+    // The first lookup asks ns for the NACP only
+    u64 bytes = hostIpcBytes();
+    CHECK(cache.name(Zelda) == "The Legend of Zelda");
+    CHECK(hostIpcBytes() - bytes == sizeof(NacpStruct));
+
+    // Then it is answered from memory
+    const u64 calls = hostIpcCalls();
+    bytes = hostIpcBytes();
+    for(u32 i = 0; i < 10; i++) CHECK(cache.name(Zelda) == "The Legend of Zelda");
+    CHECK(hostIpcCalls() == calls);
+    CHECK(hostIpcBytes() == bytes);
+
+    CHECK(cache.name(Mario) == "Super Mario Odyssey");
+    CHECK(cache.name(Missing) == "Unknown");
+
+    const auto& stats = cache.stats();
+    CHECK(stats.hits == 10);
+    CHECK(stats.misses == 3);
+    CHECK(stats.failures == 1);
+
+    // The file holds the two names: a header of 16 bytes, then the id, the length and the name of each
+    std::vector<u8> data;
+    CHECK(R_SUCCEEDED(SdCard::get().readFile("/config/authenticator/titles.bin", data)));
+    CHECK(data.size() == 16 + (8 + 2 + 19) + (8 + 2 + 19));
+    CHECK(!SdCard::get().exists("/config/authenticator/titles.bin.tmp"));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""Decodes the binary log of the sysmodule (built with DEFINES=-DLOG_BINARY).
+
+Records only hold the FNV-1a hash of their format string. The string table is
+rebuilt from the LOG_* calls of the sources (or read from the table emitted by
+the build with --emit-table).
+
+    logdecode.py --emit-table source > logformats.tsv
+    logdecode.py --table logformats.tsv authenticator_svc.bin
+    logdecode.py --sources source authenticator_svc.bin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+FILE_HEADER = struct.Struct("<IIQ")
+RECORD_HEADER = struct.Struct("<IHBBQ")
+FILE_MAGIC = 0x424C4141  # "AALB"
+
+LEVELS = ["TRACE", "DEBUG", "INFO", "WARN", "ERROR"]
+
+LITERALS = r'((?:"(?:\\.|[^"\\])*"\s*)+)'
+LOG_CALL = re.compile(r'\bLOG_(?:TRACE|DEBUG|INFO|WARN|ERROR)\(\s*(\w+)\s*,\s*' + LITERALS)
+FORMAT_ID = re.compile(r'\blogFormatId\(\s*' + LITERALS + r'\)')
+SPECIFIER = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcspfFeEgG%])')
+
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", '"': '"', "'": "'"}
+
+
+def unquote(literals):
+    text = "".join(re.findall(r'"((?:\\.|[^"\\])*)"', literals))
+    return re.sub(r'\\(.)', lambda m: ESCAPES.get(m.group(1), m.group(1)), text)
+
+
+def fnv1a(text):
+    value = 2166136261
+    for byte in text.encode("utf-8"):
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def scan_sources(root):
+    formats = {}
+    for directory, _, files in os.walk(root):
+        for name in files:
+            if not name.endswith((".cpp", ".h", ".hpp")):
+                continue
+            with open(os.path.join(directory, name), encoding="utf-8", errors="replace") as source:
+                content = source.read()
+            found = ["[%s] %s" % (m.group(1), unquote(m.group(2))) for m in LOG_CALL.finditer(content)]
+            found += [unquote(m.group(1)) for m in FORMAT_ID.finditer(content)]
+            for fmt in found:
+                formatId = fnv1a(fmt)
+                if formats.get(formatId, fmt) != fmt:
+                    print("warning: format id collision %08x" % formatId, file=sys.stderr)
+                formats[formatId] = fmt
+    return formats
+
+
+def read_table(path):
+    formats = {}
+    with open(path, encoding="utf-8") as table:
+        for line in table:
+            formatId, _, fmt = line.rstrip("\n").partition("\t")
+            formats[int(formatId, 16)] = fmt.encode("utf-8").decode("unicode_escape")
+    return formats
+
+
+def read_arguments(payload):
+    args = []
+    offset = 0
+    while offset < len(payload):
+        kind = payload[offset]
+        offset += 1
+        if kind == 4:
+            if offset >= len(payload):
+                break
+            length = payload[offset]
+            args.append(payload[offset + 1:offset + 1 + length].decode("utf-8", "replace"))
+            offset += 1 + length
+        elif kind in (1, 2, 3, 5):
+            if offset + 8 > len(payload):
+                break
+            code = {1: "<q", 2: "<Q", 3: "<d", 5: "<Q"}[kind]
+            value = struct.unpack_from(code, payload, offset)[0]
+            args.append(("ptr", value) if kind == 5 else value)
+            offset += 8
+        else:
+            break
+    return args
+
+
+def format_record(fmt, args):
+    remaining = list(args)
+
+    def substitute(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if not remaining:
+            return "<?>"
+        value = remaining.pop(0)
+        if isinstance(value, tuple):
+            return "0x%x" % value[1]
+        if conversion == "p":
+            return "0x%x" % value
+        if conversion in "di" and isinstance(value, int) and value >= 1 << 63:
+            value -= 1 << 64
+        if conversion == "c":
+            return chr(value & 0xFF)
+        if conversion == "s":
+            return ("%" + flags + "s") % value
+        if conversion in "uU":
+            conversion = "d"
+        try:
+            return ("%" + flags + conversion) % value
+        except TypeError:
+            return str(value)
+
+    return SPECIFIER.sub(substitute, fmt)
+
+
+def decode(path, formats, out):
+    with open(path, "rb") as log:
+        data = log.read()
+
+    if len(data) < FILE_HEADER.size:
+        sys.exit("%s: truncated file" % path)
+    magic, version, frequency = FILE_HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC or version != 1:
+        sys.exit("%s: not a binary log" % path)
+
+    offset = FILE_HEADER.size
+    while offset + RECORD_HEADER.size <= len(data):
+        formatId, size, level, _, tick = RECORD_HEADER.unpack_from(data, offset)
+        if size < RECORD_HEADER.size or offset + size > len(data):
+            print("warning: torn record at offset %d" % offset, file=sys.stderr)
+            break
+        args = read_arguments(data[offset + RECORD_HEADER.size:offset + size])
+        fmt = formats.get(formatId)
+        text = format_record(fmt, args) if fmt is not None else "<unknown format %08x> %r\n" % (formatId, args)
+        seconds = tick / frequency if frequency else 0
+        levelName = LEVELS[level] if level < len(LEVELS) else str(level)
+        out.write("%12.6f %-5s %s" % (seconds, levelName, text if text.endswith("\n") else text + "\n"))
+        offset += size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--sources", help="source directory to rebuild the string table from")
+    parser.add_argument("--table", help="string table emitted by the build")
+    parser.add_argument("--emit-table", metavar="SOURCES", help="print the string table of SOURCES and exit")
+    parser.add_argument("log", nargs="?", help="authenticator_svc.bin")
+    options = parser.parse_args()
+
+    if options.emit_table:
+        for formatId, fmt in sorted(scan_sources(options.emit_table).items()):
+            print("%08x\t%s" % (formatId, fmt.encode("unicode_escape").decode("ascii")))
+        return
+
+    if options.log is None or (options.sources is None) == (options.table is None):
+        parser.error("a log and either --sources or --table are required")
+
+    formats = read_table(options.table) if options.table else scan_sources(options.sources)
+    decode(options.log, formats, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()